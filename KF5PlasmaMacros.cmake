@@ -39,6 +39,39 @@ macro(plasma_install_package dir component)
 endmacro()
 
 
+# plasma_compile_theme(path themename)
+#
+# Measures the elements of the svgs of a desktop theme at build time and
+# installs the result as the elements.index of the theme, so applications
+# don't have to parse the svgs the first time they use the theme.
+# The index is only used by Plasma for the version of the theme it has been
+# compiled from, the X-KDE-PluginInfo-Version key of metadata.desktop
+# @arg path The source path of the theme, location of metadata.desktop
+# @arg themename The directory the theme is installed to
+#
+# Example:
+# plasma_compile_theme(${CMAKE_CURRENT_SOURCE_DIR} mytheme)
+#
+macro(plasma_compile_theme dir theme)
+   if(TARGET plasma-themecompiler)
+      set(_themecompiler plasma-themecompiler)
+   else()
+      find_program(_themecompiler plasma-themecompiler)
+   endif()
+   if(NOT _themecompiler)
+      message(WARNING "plasma-themecompiler not found, the theme ${theme} will be installed without elements.index")
+   else()
+      file(GLOB_RECURSE _theme_svgs ${dir}/*.svg ${dir}/*.svgz)
+      add_custom_command(OUTPUT ${CMAKE_CURRENT_BINARY_DIR}/elements.index
+                         COMMAND ${_themecompiler} ${dir} ${CMAKE_CURRENT_BINARY_DIR}/elements.index
+                         DEPENDS ${_themecompiler} ${dir}/metadata.desktop ${_theme_svgs}
+                         COMMENT "Compiling the element index of the ${theme} desktop theme")
+      add_custom_target(plasma-theme-${theme}-index ALL DEPENDS ${CMAKE_CURRENT_BINARY_DIR}/elements.index)
+      install(FILES ${CMAKE_CURRENT_BINARY_DIR}/elements.index DESTINATION ${PLASMA_DATA_INSTALL_DIR}/desktoptheme/${theme}/)
+   endif()
+endmacro()
+
+
 # plasma_add_plugin(pluginname sources_SRC)
 #
 # Use instead of add_library. Replacement for kde4_add_plugin
@@ -0,0 +1,105 @@
+/******************************************************************************
+*   Copyright 2016 The KDE Community                                          *
+*                                                                             *
+*   This library is free software; you can redistribute it and/or             *
+*   modify it under the terms of the GNU Library General Public               *
+*   License as published by the Free Software Foundation; either              *
+*   version 2 of the License, or (at your option) any later version.          *
+*                                                                             *
+*   This library is distributed in the hope that it will be useful,           *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU          *
+*   Library General Public License for more details.                          *
+*                                                                             *
+*   You should have received a copy of the GNU Library General Public License *
+*   along with this library; see the file COPYING.LIB.  If not, write to      *
+*   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+*   Boston, MA 02110-1301, USA.                                               *
+******************************************************************************/
+
+#include "alpharegiontest.h"
+
+#include <QBitmap>
+#include <QPainter>
+#include <QPixmap>
+
+#include "plasma/private/alpharegion_p.h"
+
+using Plasma::AlphaRegion;
+
+Q_DECLARE_METATYPE(QVector<quint32>)
+
+void AlphaRegionTest::findRunEnd_data()
+{
+    QTest::addColumn<QVector<quint32> >("pixels");
+    QTest::addColumn<int>("from");
+    QTest::addColumn<bool>("opaque");
+    QTest::addColumn<int>("end");
+
+    const quint32 t = 0x00ffffff;
+    const quint32 o = 0x01000000;
+    QTest::newRow("empty") << QVector<quint32>() << 0 << true << 0;
+    QTest::newRow("all transparent") << (QVector<quint32>() << t << t << t << t << t << t << t) << 0 << false << 7;
+    QTest::newRow("all opaque") << (QVector<quint32>() << o << o << o << o << o << o << o << o) << 0 << true << 8;
+    QTest::newRow("opaque after a block") << (QVector<quint32>() << t << t << t << t << t << o << t) << 0 << false << 5;
+    QTest::newRow("transparent in a block") << (QVector<quint32>() << o << o << t << o << o << o) << 0 << true << 2;
+    QTest::newRow("from the middle") << (QVector<quint32>() << t << o << o << o << o << o << o << t << t) << 1 << true << 7;
+    QTest::newRow("already ended") << (QVector<quint32>() << t << o) << 1 << false << 1;
+}
+
+void AlphaRegionTest::findRunEnd()
+{
+    QFETCH(QVector<quint32>, pixels);
+    QFETCH(int, from);
+    QFETCH(bool, opaque);
+    QFETCH(int, end);
+
+    QCOMPARE(AlphaRegion::findRunEnd(pixels.constData(), from, pixels.count(), opaque), end);
+}
+
+void AlphaRegionTest::fromImage_data()
+{
+    QTest::addColumn<QImage>("image");
+
+    QImage transparent(37, 21, QImage::Format_ARGB32_Premultiplied);
+    transparent.fill(Qt::transparent);
+    QTest::newRow("transparent") << transparent;
+
+    QImage opaque(37, 21, QImage::Format_ARGB32_Premultiplied);
+    opaque.fill(Qt::red);
+    QTest::newRow("opaque") << opaque;
+
+    QImage frame(101, 67, QImage::Format_ARGB32_Premultiplied);
+    frame.fill(Qt::transparent);
+    QPainter painter(&frame);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(QColor(0, 0, 0, 100));
+    painter.drawRoundedRect(QRectF(1.5, 2, 97, 60), 9, 9);
+    painter.setCompositionMode(QPainter::CompositionMode_Clear);
+    painter.drawEllipse(QRectF(30, 20, 21, 13));
+    painter.end();
+    QTest::newRow("rounded frame with a hole") << frame;
+
+    QImage noise(53, 19, QImage::Format_ARGB32);
+    qsrand(42);
+    for (int y = 0; y < noise.height(); ++y) {
+        for (int x = 0; x < noise.width(); ++x) {
+            noise.setPixel(x, y, qrand() % 3 ? qRgba(10, 20, 30, qrand() % 4) : 0);
+        }
+    }
+    QTest::newRow("noise") << noise;
+}
+
+void AlphaRegionTest::fromImage()
+{
+    QFETCH(QImage, image);
+
+    // what FrameSvg::mask() used to do
+    const QRegion expected(QBitmap(QPixmap::fromImage(image).alphaChannel().createMaskFromColor(Qt::black)));
+    const QRegion region = AlphaRegion::fromImage(image);
+    QCOMPARE(region.boundingRect(), expected.boundingRect());
+    QVERIFY((region ^ expected).isEmpty());
+}
+
+QTEST_MAIN(AlphaRegionTest)
@@ -0,0 +1,101 @@
+/******************************************************************************
+*   Copyright 2016 The KDE Community                                          *
+*                                                                             *
+*   This library is free software; you can redistribute it and/or             *
+*   modify it under the terms of the GNU Library General Public               *
+*   License as published by the Free Software Foundation; either              *
+*   version 2 of the License, or (at your option) any later version.          *
+*                                                                             *
+*   This library is distributed in the hope that it will be useful,           *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU          *
+*   Library General Public License for more details.                          *
+*                                                                             *
+*   You should have received a copy of the GNU Library General Public License *
+*   along with this library; see the file COPYING.LIB.  If not, write to      *
+*   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+*   Boston, MA 02110-1301, USA.                                               *
+******************************************************************************/
+
+#include "framemetricstest.h"
+
+#include "plasma/private/framemetrics_p.h"
+#include "plasma/private/svgelementsindex_p.h"
+
+using Plasma::FrameMetrics;
+using Plasma::SvgElementsIndex;
+
+static const QString s_image = QStringLiteral("/usr/share/plasma/desktoptheme/default/widgets/background.svgz");
+
+static FrameMetrics testMetrics()
+{
+    FrameMetrics metrics;
+    metrics.topHeight = 10;
+    metrics.leftWidth = 11;
+    metrics.rightWidth = 12;
+    metrics.bottomHeight = 0;
+    metrics.topMargin = 4;
+    metrics.leftMargin = 11;
+    metrics.rightMargin = 12;
+    metrics.bottomMargin = -1;
+    metrics.hints = FrameMetrics::TileCenter | FrameMetrics::Overlay | FrameMetrics::OverlayPosBottom;
+    return metrics;
+}
+
+static void compareMetrics(const FrameMetrics &actual, const FrameMetrics &expected)
+{
+    QCOMPARE(actual.topHeight, expected.topHeight);
+    QCOMPARE(actual.leftWidth, expected.leftWidth);
+    QCOMPARE(actual.rightWidth, expected.rightWidth);
+    QCOMPARE(actual.bottomHeight, expected.bottomHeight);
+    QCOMPARE(actual.topMargin, expected.topMargin);
+    QCOMPARE(actual.leftMargin, expected.leftMargin);
+    QCOMPARE(actual.rightMargin, expected.rightMargin);
+    QCOMPARE(actual.bottomMargin, expected.bottomMargin);
+    QCOMPARE(actual.hints, expected.hints);
+}
+
+void FrameMetricsTest::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+}
+
+void FrameMetricsTest::notSaved()
+{
+    SvgElementsIndex index(m_dir.path() + QLatin1String("/notsaved"));
+
+    FrameMetrics metrics;
+    QVERIFY(!metrics.load(index, s_image, QStringLiteral("north-"), 1));
+}
+
+void FrameMetricsTest::saveAndLoad()
+{
+    SvgElementsIndex index(m_dir.path() + QLatin1String("/pending"));
+    testMetrics().save(index, s_image, QStringLiteral("north-"), 1);
+
+    FrameMetrics metrics;
+    QVERIFY(metrics.load(index, s_image, QStringLiteral("north-"), 1));
+    compareMetrics(metrics, testMetrics());
+
+    // other prefixes and scale factors are measured on their own
+    QVERIFY(!metrics.load(index, s_image, QStringLiteral("south-"), 1));
+    QVERIFY(!metrics.load(index, s_image, QStringLiteral("north-"), 2));
+    QVERIFY(!metrics.load(index, s_image, QString(), 1));
+}
+
+void FrameMetricsTest::saveAndReload()
+{
+    const QString fileName = m_dir.path() + QLatin1String("/reload");
+    {
+        SvgElementsIndex index(fileName);
+        testMetrics().save(index, s_image, QString(), 1);
+        QVERIFY(index.save());
+    }
+
+    SvgElementsIndex index(fileName);
+    FrameMetrics metrics;
+    QVERIFY(metrics.load(index, s_image, QString(), 1));
+    compareMetrics(metrics, testMetrics());
+}
+
+QTEST_MAIN(FrameMetricsTest)
@@ -18,6 +18,7 @@
 *********************************************************************************/
 
 #include "framesvgtest.h"
+#include <QPainter>
 #include <QStandardPaths>
 
 
@@ -75,4 +76,86 @@ void FrameSvgTest::setTheme()
     delete frameSvg;
 }
 
+void FrameSvgTest::interactiveResizing()
+{
+    m_frameSvg->setInteractiveResizing(true);
+
+    QCOMPARE(m_frameSvg->image(QSize(100, 100)).size(), QSize(100, 100));
+    // resized: rendered to the size bucket
+    QCOMPARE(m_frameSvg->image(QSize(103, 97)).size(), QSize(104, 104));
+    QCOMPARE(m_frameSvg->image(QSize(300, 17)).size(), QSize(320, 18));
+    QCOMPARE(m_frameSvg->image(QSize(9, 15)).size(), QSize(9, 15));
+
+    // settled: back to the exact size
+    QSignalSpy spy(m_frameSvg, SIGNAL(repaintNeeded()));
+    QVERIFY(spy.wait());
+    QCOMPARE(m_frameSvg->image(QSize(103, 97)).size(), QSize(103, 97));
+
+    m_frameSvg->setInteractiveResizing(false);
+}
+
+void FrameSvgTest::ninePatch()
+{
+    m_frameSvg->resizeFrame(QSize(111, 111));
+    const QImage small = m_frameSvg->framePixmap().toImage();
+    const int ninePatches = m_frameSvg->theme()->cacheStatistics().value(QStringLiteral("ninePatches")).toInt();
+    QVERIFY(ninePatches > 0);
+
+    // another size is composed from the same patches
+    m_frameSvg->resizeFrame(QSize(211, 157));
+    const QImage large = m_frameSvg->framePixmap().toImage();
+    QCOMPARE(large.size(), QSize(211, 157));
+    QCOMPARE(m_frameSvg->theme()->cacheStatistics().value(QStringLiteral("ninePatches")).toInt(), ninePatches);
+
+    // and the corners don't depend on it
+    QCOMPARE(large.copy(0, 0, 20, 20), small.copy(0, 0, 20, 20));
+}
+
+void FrameSvgTest::stretchedFrame()
+{
+    Plasma::Svg svg;
+    svg.setImagePath(QFINDTESTDATA("data/background.svgz"));
+    const int left = svg.elementSize(QStringLiteral("left")).width();
+    const int right = svg.elementSize(QStringLiteral("right")).width();
+    const int top = svg.elementSize(QStringLiteral("top")).height();
+    const int bottom = svg.elementSize(QStringLiteral("bottom")).height();
+
+    // much bigger than the elements, the center and the stretched borders
+    // are as sharp as when painted from the svg
+    const QSize size(613, 419);
+    m_frameSvg->resizeFrame(size);
+    const QImage frame = m_frameSvg->framePixmap().toImage().convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    QCOMPARE(frame.size(), size);
+
+    const QRect center(left, top, size.width() - left - right, size.height() - top - bottom);
+    const QRect topSide(left, 0, center.width(), top);
+    foreach (const QRect &section, QList<QRect>() << center << topSide) {
+        QImage expected(section.size(), QImage::Format_ARGB32_Premultiplied);
+        expected.fill(Qt::transparent);
+        QPainter p(&expected);
+        svg.paint(&p, QRect(QPoint(0, 0), section.size()), section == center ? QStringLiteral("center") : QStringLiteral("top"));
+        p.end();
+
+        QCOMPARE(frame.copy(section), expected);
+    }
+}
+
+void FrameSvgTest::trimCaches()
+{
+    m_frameSvg->resizeFrame(QSize(120, 80));
+    const QImage before = m_frameSvg->framePixmap().toImage();
+
+    Plasma::Theme *theme = m_frameSvg->theme();
+    QVERIFY(theme->cacheStatistics().value(QStringLiteral("renderedFrameBytes")).toLongLong() > 0);
+    const int evicted = theme->cacheStatistics().value(QStringLiteral("framesEvicted")).toInt();
+
+    theme->trimCaches();
+    QCOMPARE(theme->cacheStatistics().value(QStringLiteral("renderedFrameBytes")).toLongLong(), qint64(0));
+    QVERIFY(theme->cacheStatistics().value(QStringLiteral("framesEvicted")).toInt() > evicted);
+
+    // the frame keeps its measures and is rendered again
+    QCOMPARE(m_frameSvg->contentsRect(), QRectF(26, 26, 68, 28));
+    QCOMPARE(m_frameSvg->framePixmap().toImage(), before);
+}
+
 QTEST_MAIN(FrameSvgTest)
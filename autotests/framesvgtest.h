@@ -38,6 +38,10 @@ private Q_SLOTS:
     void margins();
     void contentsRect();
     void setTheme();
+    void interactiveResizing();
+    void ninePatch();
+    void stretchedFrame();
+    void trimCaches();
 
 private:
     Plasma::FrameSvg *m_frameSvg;
@@ -0,0 +1,119 @@
+/******************************************************************************
+*   Copyright 2016 The KDE Community                                          *
+*                                                                             *
+*   This library is free software; you can redistribute it and/or             *
+*   modify it under the terms of the GNU Library General Public               *
+*   License as published by the Free Software Foundation; either              *
+*   version 2 of the License, or (at your option) any later version.          *
+*                                                                             *
+*   This library is distributed in the hope that it will be useful,           *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU          *
+*   Library General Public License for more details.                          *
+*                                                                             *
+*   You should have received a copy of the GNU Library General Public License *
+*   along with this library; see the file COPYING.LIB.  If not, write to      *
+*   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+*   Boston, MA 02110-1301, USA.                                               *
+******************************************************************************/
+
+#include "imagecolorizertest.h"
+
+#include <QPixmap>
+
+#include <kiconeffect.h>
+
+#include "plasma/private/imagecolorizer_p.h"
+
+using Plasma::ImageColorizer;
+
+QImage ImageColorizerTest::randomImage(const QSize &size, QImage::Format format) const
+{
+    QImage image(size, QImage::Format_ARGB32);
+    qsrand(size.width() * size.height());
+    for (int y = 0; y < size.height(); ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < size.width(); ++x) {
+            line[x] = qRgba(qrand() % 256, qrand() % 256, qrand() % 256, qrand() % 256);
+        }
+    }
+
+    return image.convertToFormat(format);
+}
+
+void ImageColorizerTest::sameAsKIconEffect_data()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<int>("format");
+    QTest::addColumn<QColor>("color");
+
+    QTest::newRow("premultiplied") << QSize(64, 64) << int(QImage::Format_ARGB32_Premultiplied) << QColor(49, 54, 59);
+    QTest::newRow("straight alpha") << QSize(64, 64) << int(QImage::Format_ARGB32) << QColor(239, 240, 241);
+    QTest::newRow("opaque") << QSize(64, 64) << int(QImage::Format_RGB32) << QColor(61, 174, 233);
+    QTest::newRow("odd width") << QSize(13, 7) << int(QImage::Format_ARGB32_Premultiplied) << QColor(Qt::red);
+    QTest::newRow("single pixel") << QSize(1, 1) << int(QImage::Format_ARGB32_Premultiplied) << QColor(Qt::white);
+    QTest::newRow("16 bits") << QSize(32, 32) << int(QImage::Format_RGB16) << QColor(Qt::black);
+}
+
+void ImageColorizerTest::sameAsKIconEffect()
+{
+    QFETCH(QSize, size);
+    QFETCH(int, format);
+    QFETCH(QColor, color);
+
+    QImage expected = randomImage(size, QImage::Format(format));
+    QImage image = expected;
+
+    KIconEffect::colorize(expected, color, 1.0);
+    ImageColorizer::colorize(image, color);
+
+    QCOMPARE(image, expected);
+}
+
+void ImageColorizerTest::paddedScanLines()
+{
+    const QImage source = randomImage(QSize(10, 10), QImage::Format_ARGB32_Premultiplied);
+
+    // 2 pixels of padding at the end of every line
+    QVector<uchar> buffer(12 * 4 * 10, 0x55);
+    QImage image(buffer.data(), 10, 10, 12 * 4, QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < 10; ++y) {
+        memcpy(image.scanLine(y), source.constScanLine(y), 10 * 4);
+    }
+
+    QImage expected = source;
+    KIconEffect::colorize(expected, Qt::blue, 1.0);
+    ImageColorizer::colorize(image, Qt::blue);
+
+    QCOMPARE(image, expected);
+    for (int y = 0; y < 10; ++y) {
+        QCOMPARE(buffer.at(y * 12 * 4 + 10 * 4), uchar(0x55));
+    }
+}
+
+void ImageColorizerTest::benchmarkKIconEffect()
+{
+    // what Svg used to do after rendering an element
+    const QPixmap rendered = QPixmap::fromImage(randomImage(QSize(256, 256), QImage::Format_ARGB32_Premultiplied));
+
+    QBENCHMARK {
+        QImage image = rendered.toImage();
+        KIconEffect::colorize(image, QColor(49, 54, 59), 1.0);
+        QPixmap pixmap = QPixmap::fromImage(image);
+        Q_UNUSED(pixmap);
+    }
+}
+
+void ImageColorizerTest::benchmarkImageColorizer()
+{
+    const QImage rendered = randomImage(QSize(256, 256), QImage::Format_ARGB32_Premultiplied);
+
+    QBENCHMARK {
+        QImage image = rendered;
+        ImageColorizer::colorize(image, QColor(49, 54, 59));
+        QPixmap pixmap = QPixmap::fromImage(image);
+        Q_UNUSED(pixmap);
+    }
+}
+
+QTEST_MAIN(ImageColorizerTest)
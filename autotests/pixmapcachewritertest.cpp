@@ -0,0 +1,268 @@
+/******************************************************************************
+*   Copyright 2016 The KDE Community                                          *
+*                                                                             *
+*   This library is free software; you can redistribute it and/or             *
+*   modify it under the terms of the GNU Library General Public               *
+*   License as published by the Free Software Foundation; either              *
+*   version 2 of the License, or (at your option) any later version.          *
+*                                                                             *
+*   This library is distributed in the hope that it will be useful,           *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU          *
+*   Library General Public License for more details.                          *
+*                                                                             *
+*   You should have received a copy of the GNU Library General Public License *
+*   along with this library; see the file COPYING.LIB.  If not, write to      *
+*   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+*   Boston, MA 02110-1301, USA.                                               *
+******************************************************************************/
+
+#include "pixmapcachewritertest.h"
+
+#include "plasma/private/pixmapcachewriter_p.h"
+
+using Plasma::PixmapCacheKey;
+using Plasma::PixmapCacheOwner;
+using Plasma::PixmapCacheWriter;
+using Plasma::PixmapStore;
+
+static QPixmap testPixmap(int width, int height, const QColor &color)
+{
+    QPixmap pixmap(width, height);
+    pixmap.fill(color);
+    return pixmap;
+}
+
+static PixmapCacheKey testKey(int i, const QSize &size = QSize(16, 16))
+{
+    return PixmapCacheKey::svgElement(QStringLiteral("widgets/background"), QStringLiteral("element%1").arg(i),
+                                      size, 0, 1, 0);
+}
+
+QString PixmapCacheWriterTest::storeFile(const QString &name) const
+{
+    return m_dir.path() + QLatin1Char('/') + name;
+}
+
+void PixmapCacheWriterTest::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+}
+
+void PixmapCacheWriterTest::pendingLookups()
+{
+    PixmapCacheWriter writer;
+    QVERIFY(writer.isEmpty());
+
+    QPixmap pixmap;
+    QVERIFY(!writer.find(testKey(1), &pixmap));
+
+    writer.insert(testKey(1), testPixmap(16, 16, Qt::red), PixmapCacheOwner(this, 1));
+    QCOMPARE(writer.count(), 1);
+    QCOMPARE(writer.size(), qint64(16 * 16 * 4));
+
+    QVERIFY(writer.find(testKey(1), &pixmap));
+    QCOMPARE(pixmap.size(), QSize(16, 16));
+
+    QImage image;
+    QVERIFY(writer.find(testKey(1), &image));
+    QCOMPARE(image.pixel(0, 0), QColor(Qt::red).rgb());
+
+    QVERIFY(writer.find(testKey(1).toString(), &pixmap));
+    QVERIFY(!writer.find(testKey(2).toString(), &pixmap));
+
+    // nowhere to write to, flushing keeps everything
+    writer.flush();
+    QCOMPARE(writer.count(), 1);
+}
+
+void PixmapCacheWriterTest::writeInBatches()
+{
+    PixmapStore store(storeFile(QStringLiteral("batches")), 1024 * 1024);
+    PixmapCacheWriter writer;
+    writer.setStore(&store);
+    // 4 images per batch
+    writer.setBatchSize(4 * 16 * 16 * 4);
+
+    for (int i = 0; i < 10; ++i) {
+        writer.insert(testKey(i), testPixmap(16, 16, Qt::blue), PixmapCacheOwner(this, i));
+    }
+
+    QSignalSpy flushed(&writer, SIGNAL(flushed()));
+    writer.flush();
+    QVERIFY(flushed.wait());
+    QVERIFY(writer.isEmpty());
+    QCOMPARE(writer.size(), qint64(0));
+
+    QImage image;
+    for (int i = 0; i < 10; ++i) {
+        QVERIFY(store.findImage(testKey(i).toString(), &image));
+        QCOMPARE(image.size(), QSize(16, 16));
+    }
+
+    // written for the other processes as well
+    PixmapStore other(storeFile(QStringLiteral("batches")), 1024 * 1024);
+    QVERIFY(other.findImage(testKey(9).toString(), &image));
+}
+
+void PixmapCacheWriterTest::lookupsWhileWriting()
+{
+    PixmapStore store(storeFile(QStringLiteral("lookups")), 1024 * 1024);
+    PixmapCacheWriter writer;
+    writer.setStore(&store);
+    writer.setBatchSize(1);
+
+    for (int i = 0; i < 20; ++i) {
+        writer.insert(testKey(i), testPixmap(16, 16, Qt::green), PixmapCacheOwner(this, i));
+    }
+
+    QSignalSpy flushed(&writer, SIGNAL(flushed()));
+    writer.flush();
+
+    // every image is in the queue or in the store, whatever the writer is doing
+    while (flushed.isEmpty()) {
+        for (int i = 0; i < 20; ++i) {
+            QImage image;
+            QVERIFY(writer.find(testKey(i), &image) || store.findImage(testKey(i).toString(), &image));
+        }
+        QCoreApplication::processEvents();
+    }
+
+    QVERIFY(writer.isEmpty());
+}
+
+void PixmapCacheWriterTest::newestOfOwner()
+{
+    PixmapStore store(storeFile(QStringLiteral("owner")), 1024 * 1024);
+    PixmapCacheWriter writer;
+    writer.setStore(&store);
+
+    // an element of a Svg being resized
+    writer.insert(testKey(1, QSize(16, 16)), testPixmap(16, 16, Qt::red), PixmapCacheOwner(this, 1));
+    writer.insert(testKey(1, QSize(20, 20)), testPixmap(20, 20, Qt::red), PixmapCacheOwner(this, 1));
+    writer.insert(testKey(1, QSize(24, 24)), testPixmap(24, 24, Qt::red), PixmapCacheOwner(this, 1));
+    writer.insert(testKey(2), testPixmap(16, 16, Qt::red), PixmapCacheOwner(this, 2));
+    QCOMPARE(writer.count(), 4);
+
+    writer.waitForDone();
+    QVERIFY(writer.isEmpty());
+
+    QImage image;
+    QVERIFY(!store.findImage(testKey(1, QSize(16, 16)).toString(), &image));
+    QVERIFY(!store.findImage(testKey(1, QSize(20, 20)).toString(), &image));
+    QVERIFY(store.findImage(testKey(1, QSize(24, 24)).toString(), &image));
+    QVERIFY(store.findImage(testKey(2).toString(), &image));
+}
+
+void PixmapCacheWriterTest::customKeys()
+{
+    PixmapStore store(storeFile(QStringLiteral("custom")), 1024 * 1024);
+    PixmapCacheWriter writer;
+    writer.setStore(&store);
+
+    // the keys and ids of the public Theme API, kept as given
+    writer.insert(PixmapCacheKey::custom(QStringLiteral("applet_16")), testPixmap(16, 16, Qt::red), PixmapCacheOwner(this, QStringLiteral("applet")));
+    writer.insert(PixmapCacheKey::custom(QStringLiteral("applet_24")), testPixmap(24, 24, Qt::red), PixmapCacheOwner(this, QStringLiteral("applet")));
+    writer.insert(PixmapCacheKey::custom(QStringLiteral("other_16")), testPixmap(16, 16, Qt::red), PixmapCacheOwner(this, QStringLiteral("other")));
+    QCOMPARE(PixmapCacheKey::custom(QStringLiteral("applet_16")).toString(), QStringLiteral("applet_16"));
+    QVERIFY(!(PixmapCacheKey::custom(QStringLiteral("applet_16")) == PixmapCacheKey::custom(QStringLiteral("applet_24"))));
+    QCOMPARE(writer.count(), 3);
+
+    QPixmap pixmap;
+    QVERIFY(writer.find(QStringLiteral("applet_16"), &pixmap));
+    QCOMPARE(pixmap.size(), QSize(16, 16));
+
+    writer.waitForDone();
+    QVERIFY(writer.isEmpty());
+
+    // only the newest one of the same id
+    QImage image;
+    QVERIFY(!store.findImage(QStringLiteral("applet_16"), &image));
+    QVERIFY(store.findImage(QStringLiteral("applet_24"), &image));
+    QVERIFY(store.findImage(QStringLiteral("other_16"), &image));
+}
+
+void PixmapCacheWriterTest::replacedWhileWriting()
+{
+    PixmapStore store(storeFile(QStringLiteral("replaced")), 1024 * 1024);
+    PixmapCacheWriter writer;
+    writer.setStore(&store);
+
+    writer.insert(testKey(1), testPixmap(16, 16, Qt::red), PixmapCacheOwner(this, 1));
+    writer.flush();
+    // the red one is being written, the blue one has to follow
+    writer.insert(testKey(1), testPixmap(16, 16, Qt::blue), PixmapCacheOwner(this, 1));
+
+    writer.waitForDone();
+    QVERIFY(writer.isEmpty());
+
+    QImage image;
+    QVERIFY(store.findImage(testKey(1).toString(), &image));
+    QCOMPARE(image.pixel(0, 0), QColor(Qt::blue).rgb());
+}
+
+void PixmapCacheWriterTest::ceiling()
+{
+    PixmapCacheWriter writer;
+    writer.setCeiling(3 * 16 * 16 * 4);
+
+    for (int i = 0; i < 5; ++i) {
+        writer.insert(testKey(i), testPixmap(16, 16, Qt::red), PixmapCacheOwner(this, i));
+    }
+
+    // nothing can be written, the oldest ones are dropped
+    QCOMPARE(writer.count(), 3);
+    QVERIFY(writer.size() <= writer.ceiling());
+
+    QPixmap pixmap;
+    QVERIFY(!writer.find(testKey(0), &pixmap));
+    QVERIFY(!writer.find(testKey(1), &pixmap));
+    QVERIFY(writer.find(testKey(4), &pixmap));
+}
+
+void PixmapCacheWriterTest::clear()
+{
+    PixmapStore store(storeFile(QStringLiteral("clear")), 1024 * 1024);
+    PixmapCacheWriter writer;
+    writer.setStore(&store);
+
+    for (int i = 0; i < 5; ++i) {
+        writer.insert(testKey(i), testPixmap(16, 16, Qt::red), PixmapCacheOwner(this, i));
+    }
+    writer.flush();
+    writer.clear();
+    QVERIFY(writer.isEmpty());
+    QCOMPARE(writer.size(), qint64(0));
+
+    // the notification of the batch written before clearing changes nothing
+    QSignalSpy flushed(&writer, SIGNAL(flushed()));
+    QVERIFY(!flushed.wait(200));
+    QVERIFY(writer.isEmpty());
+}
+
+void PixmapCacheWriterTest::discard()
+{
+    PixmapStore store(storeFile(QStringLiteral("discard")), 1024 * 1024);
+    PixmapCacheWriter writer;
+    writer.setStore(&store);
+
+    writer.insert(testKey(1), testPixmap(16, 16, Qt::red), PixmapCacheOwner(this, 1), PixmapStore::ColorDependent);
+    writer.insert(testKey(2), testPixmap(16, 16, Qt::red), PixmapCacheOwner(this, 2));
+    writer.flush();
+    writer.insert(testKey(3), testPixmap(16, 16, Qt::red), PixmapCacheOwner(this, 3), PixmapStore::ColorDependent);
+    writer.insert(testKey(4), testPixmap(16, 16, Qt::red), PixmapCacheOwner(this, 4));
+
+    // the batch being written is done before anything is dropped
+    writer.discard(PixmapStore::ColorDependent);
+    QVERIFY(store.discard(PixmapStore::ColorDependent));
+    writer.waitForDone();
+
+    QImage image;
+    QVERIFY(!writer.find(testKey(3), &image));
+    QVERIFY(!store.findImage(testKey(1).toString(), &image));
+    QVERIFY(!store.findImage(testKey(3).toString(), &image));
+    QVERIFY(store.findImage(testKey(2).toString(), &image));
+    QVERIFY(store.findImage(testKey(4).toString(), &image));
+}
+
+QTEST_MAIN(PixmapCacheWriterTest)
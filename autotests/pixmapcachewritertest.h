@@ -0,0 +1,49 @@
+/******************************************************************************
+*   Copyright 2016 The KDE Community                                          *
+*                                                                             *
+*   This library is free software; you can redistribute it and/or             *
+*   modify it under the terms of the GNU Library General Public               *
+*   License as published by the Free Software Foundation; either              *
+*   version 2 of the License, or (at your option) any later version.          *
+*                                                                             *
+*   This library is distributed in the hope that it will be useful,           *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU          *
+*   Library General Public License for more details.                          *
+*                                                                             *
+*   You should have received a copy of the GNU Library General Public License *
+*   along with this library; see the file COPYING.LIB.  If not, write to      *
+*   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+*   Boston, MA 02110-1301, USA.                                               *
+******************************************************************************/
+
+#ifndef PIXMAPCACHEWRITERTEST_H
+#define PIXMAPCACHEWRITERTEST_H
+
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+
+class PixmapCacheWriterTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void pendingLookups();
+    void writeInBatches();
+    void lookupsWhileWriting();
+    void newestOfOwner();
+    void customKeys();
+    void replacedWhileWriting();
+    void ceiling();
+    void clear();
+    void discard();
+
+private:
+    QString storeFile(const QString &name) const;
+
+    QTemporaryDir m_dir;
+};
+
+#endif
@@ -0,0 +1,258 @@
+/******************************************************************************
+*   Copyright 2016 The KDE Community                                          *
+*                                                                             *
+*   This library is free software; you can redistribute it and/or             *
+*   modify it under the terms of the GNU Library General Public               *
+*   License as published by the Free Software Foundation; either              *
+*   version 2 of the License, or (at your option) any later version.          *
+*                                                                             *
+*   This library is distributed in the hope that it will be useful,           *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU          *
+*   Library General Public License for more details.                          *
+*                                                                             *
+*   You should have received a copy of the GNU Library General Public License *
+*   along with this library; see the file COPYING.LIB.  If not, write to      *
+*   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+*   Boston, MA 02110-1301, USA.                                               *
+******************************************************************************/
+
+#include "pixmapstoretest.h"
+
+#include "plasma/private/pixmapstore_p.h"
+
+using Plasma::PixmapStore;
+
+static QImage testImage(int width, int height, QRgb color)
+{
+    QImage image(width, height, QImage::Format_ARGB32_Premultiplied);
+    image.fill(color);
+    image.setPixel(0, 0, qRgba(1, 2, 3, 255));
+    return image;
+}
+
+QString PixmapStoreTest::storeFile(const QString &name) const
+{
+    return m_dir.path() + QLatin1Char('/') + name;
+}
+
+void PixmapStoreTest::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+}
+
+void PixmapStoreTest::pendingLookups()
+{
+    PixmapStore store(storeFile(QStringLiteral("pending")), 1024 * 1024);
+    QVERIFY(!store.isDirty());
+
+    QImage image;
+    QVERIFY(!store.findImage(QStringLiteral("background"), &image));
+
+    store.insertImage(QStringLiteral("background"), testImage(10, 20, qRgba(0, 0, 255, 255)));
+    QVERIFY(store.isDirty());
+
+    QVERIFY(store.findImage(QStringLiteral("background"), &image));
+    QCOMPARE(image, testImage(10, 20, qRgba(0, 0, 255, 255)));
+}
+
+void PixmapStoreTest::saveAndReload()
+{
+    const QString fileName = storeFile(QStringLiteral("reload"));
+    {
+        PixmapStore store(fileName, 1024 * 1024);
+        for (int i = 1; i <= 20; ++i) {
+            store.insertImage(QStringLiteral("image%1").arg(i), testImage(i, 2 * i, qRgba(i, 0, 0, 255)));
+        }
+        // converted, indexed images can't be mapped as they are
+        store.insertImage(QStringLiteral("indexed"), testImage(8, 8, qRgba(0, 255, 0, 255)).convertToFormat(QImage::Format_Indexed8));
+        QVERIFY(store.save());
+        QVERIFY(!store.isDirty());
+        QVERIFY(store.size() > 0);
+        QVERIFY(store.lastModifiedTime().isValid());
+    }
+
+    PixmapStore store(fileName, 1024 * 1024);
+    QImage image;
+    for (int i = 1; i <= 20; ++i) {
+        QVERIFY(store.findImage(QStringLiteral("image%1").arg(i), &image));
+        QCOMPARE(image, testImage(i, 2 * i, qRgba(i, 0, 0, 255)));
+        // the rows are aligned in the file
+        QCOMPARE(quintptr(image.constBits()) % 16, quintptr(0));
+    }
+
+    QVERIFY(store.findImage(QStringLiteral("indexed"), &image));
+    QCOMPARE(image.format(), QImage::Format_ARGB32_Premultiplied);
+    QCOMPARE(image.pixel(4, 4), qRgba(0, 255, 0, 255));
+
+    QPixmap pixmap;
+    QVERIFY(store.findPixmap(QStringLiteral("image5"), &pixmap));
+    QCOMPARE(pixmap.size(), QSize(5, 10));
+
+    QVERIFY(!store.findImage(QStringLiteral("image0"), &image));
+    QVERIFY(!store.findImage(QStringLiteral("image"), &image));
+}
+
+void PixmapStoreTest::hitsDontCopy()
+{
+    PixmapStore store(storeFile(QStringLiteral("views")), 1024 * 1024);
+    store.insertImage(QStringLiteral("background"), testImage(64, 64, qRgba(0, 0, 255, 255)));
+    QVERIFY(store.save());
+
+    QImage first;
+    QImage second;
+    QVERIFY(store.findImage(QStringLiteral("background"), &first));
+    QVERIFY(store.findImage(QStringLiteral("background"), &second));
+    QCOMPARE(first.constBits(), second.constBits());
+
+    // writing to a view detaches it, the mapped pixels stay untouched
+    first.setPixel(1, 1, qRgba(255, 0, 0, 255));
+    QVERIFY(first.constBits() != second.constBits());
+    QCOMPARE(second.pixel(1, 1), qRgba(0, 0, 255, 255));
+
+    QImage third;
+    QVERIFY(store.findImage(QStringLiteral("background"), &third));
+    QCOMPARE(third.pixel(1, 1), qRgba(0, 0, 255, 255));
+}
+
+void PixmapStoreTest::otherWriter()
+{
+    const QString fileName = storeFile(QStringLiteral("writers"));
+    PixmapStore store(fileName, 1024 * 1024);
+    store.insertImage(QStringLiteral("mine"), testImage(4, 4, qRgba(0, 0, 255, 255)));
+    QVERIFY(store.save());
+
+    {
+        // as another process would
+        PixmapStore other(fileName, 1024 * 1024);
+        QImage image;
+        QVERIFY(other.findImage(QStringLiteral("mine"), &image));
+
+        other.insertImage(QStringLiteral("theirs"), testImage(6, 6, qRgba(255, 0, 0, 255)));
+        other.insertImage(QStringLiteral("mine"), testImage(4, 4, qRgba(0, 255, 0, 255)));
+        QVERIFY(other.save());
+    }
+
+    // seen at the first miss
+    QImage image;
+    QVERIFY(store.findImage(QStringLiteral("theirs"), &image));
+    QCOMPARE(image, testImage(6, 6, qRgba(255, 0, 0, 255)));
+    QVERIFY(store.findImage(QStringLiteral("mine"), &image));
+    QCOMPARE(image, testImage(4, 4, qRgba(0, 255, 0, 255)));
+}
+
+void PixmapStoreTest::viewsOutliveTheFile()
+{
+    const QString fileName = storeFile(QStringLiteral("outlive"));
+    QImage image;
+    {
+        PixmapStore store(fileName, 1024 * 1024);
+        store.insertImage(QStringLiteral("background"), testImage(32, 32, qRgba(0, 0, 255, 255)));
+        QVERIFY(store.save());
+        QVERIFY(store.findImage(QStringLiteral("background"), &image));
+
+        store.clear();
+        QImage cleared;
+        QVERIFY(!store.findImage(QStringLiteral("background"), &cleared));
+    }
+
+    QVERIFY(QFile::remove(fileName));
+    QCOMPARE(image, testImage(32, 32, qRgba(0, 0, 255, 255)));
+}
+
+void PixmapStoreTest::budget()
+{
+    const QString fileName = storeFile(QStringLiteral("budget"));
+    // a bit more than 4 images of 64x64
+    PixmapStore store(fileName, 4 * 64 * 64 * 4 + 2048);
+
+    store.insertImage(QStringLiteral("used"), testImage(64, 64, qRgba(0, 0, 255, 255)));
+    store.insertImage(QStringLiteral("unused"), testImage(64, 64, qRgba(0, 0, 255, 255)));
+    QVERIFY(store.save());
+
+    QImage image;
+    QVERIFY(store.findImage(QStringLiteral("used"), &image));
+
+    for (int i = 0; i < 3; ++i) {
+        store.insertImage(QStringLiteral("new%1").arg(i), testImage(64, 64, qRgba(0, i, 0, 255)));
+        QVERIFY(store.save());
+        QVERIFY(store.size() <= store.budget());
+    }
+
+    // the file has been rewritten with the used image only
+    QVERIFY(store.findImage(QStringLiteral("used"), &image));
+    QVERIFY(!store.findImage(QStringLiteral("unused"), &image));
+    QVERIFY(store.findImage(QStringLiteral("new2"), &image));
+
+    PixmapStore other(fileName, store.budget());
+    QVERIFY(other.findImage(QStringLiteral("used"), &image));
+    QVERIFY(!other.findImage(QStringLiteral("unused"), &image));
+}
+
+void PixmapStoreTest::clear()
+{
+    const QString fileName = storeFile(QStringLiteral("clear"));
+    PixmapStore store(fileName, 1024 * 1024);
+    store.insertImage(QStringLiteral("background"), testImage(8, 8, qRgba(0, 0, 255, 255)));
+    QVERIFY(store.save());
+
+    PixmapStore other(fileName, 1024 * 1024);
+    QImage image;
+    QVERIFY(other.findImage(QStringLiteral("background"), &image));
+
+    store.clear();
+    QVERIFY(!store.findImage(QStringLiteral("background"), &image));
+    // the other process notices the file has been replaced
+    QVERIFY(!other.findImage(QStringLiteral("background"), &image));
+}
+
+void PixmapStoreTest::discard()
+{
+    const QString fileName = storeFile(QStringLiteral("discard"));
+    PixmapStore store(fileName, 1024 * 1024);
+    store.insertImage(QStringLiteral("plain"), testImage(8, 8, qRgba(255, 0, 0, 255)));
+    store.insertImage(QStringLiteral("colored"), testImage(8, 8, qRgba(0, 255, 0, 255)), PixmapStore::ColorDependent);
+    QVERIFY(store.save());
+    store.insertImage(QStringLiteral("pending"), testImage(8, 8, qRgba(0, 0, 255, 255)), PixmapStore::ColorDependent);
+
+    PixmapStore other(fileName, 1024 * 1024);
+    QImage image;
+    QVERIFY(other.findImage(QStringLiteral("colored"), &image));
+    const qint64 size = store.size();
+
+    QVERIFY(store.discard(PixmapStore::ColorDependent));
+    QVERIFY(!store.findImage(QStringLiteral("colored"), &image));
+    QVERIFY(!store.findImage(QStringLiteral("pending"), &image));
+    QVERIFY(store.findImage(QStringLiteral("plain"), &image));
+    QCOMPARE(image, testImage(8, 8, qRgba(255, 0, 0, 255)));
+    QVERIFY(store.size() < size);
+
+    // the other process sees the new file, and has nothing left to discard
+    QVERIFY(!other.findImage(QStringLiteral("colored"), &image));
+    QVERIFY(other.findImage(QStringLiteral("plain"), &image));
+    const QDateTime lastModified = other.lastModifiedTime();
+    QVERIFY(other.discard(PixmapStore::ColorDependent));
+    QCOMPARE(other.lastModifiedTime(), lastModified);
+}
+
+void PixmapStoreTest::ignoreForeignFiles()
+{
+    const QString fileName = storeFile(QStringLiteral("foreign"));
+    {
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(QByteArray(4096, 'x'));
+    }
+
+    PixmapStore store(fileName, 1024 * 1024);
+    QImage image;
+    QVERIFY(!store.findImage(QStringLiteral("background"), &image));
+
+    store.insertImage(QStringLiteral("background"), testImage(8, 8, qRgba(0, 0, 255, 255)));
+    QVERIFY(store.save());
+
+    PixmapStore other(fileName, 1024 * 1024);
+    QVERIFY(other.findImage(QStringLiteral("background"), &image));
+}
+
+QTEST_MAIN(PixmapStoreTest)
@@ -0,0 +1,163 @@
+/******************************************************************************
+*   Copyright 2016 The KDE Community                                          *
+*                                                                             *
+*   This library is free software; you can redistribute it and/or             *
+*   modify it under the terms of the GNU Library General Public               *
+*   License as published by the Free Software Foundation; either              *
+*   version 2 of the License, or (at your option) any later version.          *
+*                                                                             *
+*   This library is distributed in the hope that it will be useful,           *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU          *
+*   Library General Public License for more details.                          *
+*                                                                             *
+*   You should have received a copy of the GNU Library General Public License *
+*   along with this library; see the file COPYING.LIB.  If not, write to      *
+*   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+*   Boston, MA 02110-1301, USA.                                               *
+******************************************************************************/
+
+#include "renderprefetchertest.h"
+
+#include <QStandardPaths>
+
+#include "plasma/framesvg.h"
+#include "plasma/renderprefetcher.h"
+#include "plasma/svg.h"
+#include "plasma/theme.h"
+
+void RenderPrefetcherTest::initTestCase()
+{
+    QStandardPaths::enableTestMode(true);
+    m_cacheDir = QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    m_cacheDir.removeRecursively();
+}
+
+void RenderPrefetcherTest::cleanupTestCase()
+{
+    m_cacheDir.removeRecursively();
+}
+
+void RenderPrefetcherTest::emptyBatch()
+{
+    Plasma::RenderPrefetcher prefetcher;
+    QSignalSpy spy(&prefetcher, SIGNAL(finished()));
+
+    prefetcher.start();
+    QVERIFY(prefetcher.isRunning());
+    QVERIFY(spy.wait());
+    QVERIFY(!prefetcher.isRunning());
+    QCOMPARE(prefetcher.pendingCount(), 0);
+}
+
+void RenderPrefetcherTest::prefetch()
+{
+    const QString path = QFINDTESTDATA("data/background.svgz");
+
+    Plasma::RenderPrefetcher prefetcher;
+    QSignalSpy spy(&prefetcher, SIGNAL(finished()));
+
+    prefetcher.addImage(path, QString(), QSize(64, 64));
+    prefetcher.addImage(path, QStringLiteral("center"), QSize(32, 32), 2.0);
+    prefetcher.addFrame(path, QString(), QSize(100, 100));
+    QCOMPARE(prefetcher.pendingCount(), 3);
+
+    prefetcher.start();
+    QVERIFY(spy.wait());
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(prefetcher.pendingCount(), 0);
+
+    Plasma::Theme theme;
+    theme.resetCacheStatistics();
+
+    // what was rendered is what an Svg and a FrameSvg look up
+    Plasma::Svg svg;
+    svg.setImagePath(path);
+    QCOMPARE(svg.image(QSize(64, 64)).size(), QSize(64, 64));
+
+    Plasma::Svg multipleImages;
+    multipleImages.setImagePath(path);
+    multipleImages.setDevicePixelRatio(2.0);
+    multipleImages.setContainsMultipleImages(true);
+    QCOMPARE(multipleImages.image(QSize(32, 32), QStringLiteral("center")).size(), QSize(64, 64));
+
+    Plasma::FrameSvg frameSvg;
+    frameSvg.setImagePath(path);
+    frameSvg.resizeFrame(QSize(100, 100));
+    QCOMPARE(frameSvg.framePixmap().size(), QSize(100, 100));
+
+    // all of them found in the cache, none rendered again
+    const QVariantMap statistics = theme.cacheStatistics();
+    QCOMPARE(statistics.value(QStringLiteral("pixmapCacheMisses")).toInt(), 0);
+    QCOMPARE(statistics.value(QStringLiteral("pixmapCacheHits")).toInt() +
+             statistics.value(QStringLiteral("pendingPixmapHits")).toInt(), 3);
+}
+
+void RenderPrefetcherTest::startWhileRunning()
+{
+    const QString path = QFINDTESTDATA("data/background.svgz");
+
+    Plasma::RenderPrefetcher prefetcher;
+    QSignalSpy spy(&prefetcher, SIGNAL(finished()));
+
+    prefetcher.addFrame(path, QString(), QSize(120, 80));
+    prefetcher.start();
+
+    // queued for the next batch
+    prefetcher.addFrame(path, QString(), QSize(80, 120));
+    prefetcher.start();
+    QCOMPARE(prefetcher.pendingCount(), 2);
+
+    QVERIFY(spy.wait());
+    QCOMPARE(prefetcher.pendingCount(), 1);
+
+    prefetcher.start();
+    QVERIFY(spy.wait());
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(prefetcher.pendingCount(), 0);
+}
+
+void RenderPrefetcherTest::parallelFrames()
+{
+    const QString path = QFINDTESTDATA("data/background.svgz");
+    const QList<QSize> sizes = QList<QSize>() << QSize(100, 100) << QSize(300, 40) << QSize(40, 300) << QSize(57, 91);
+
+    Plasma::RenderPrefetcher prefetcher;
+    QSignalSpy spy(&prefetcher, SIGNAL(finished()));
+
+    foreach (const QSize &size, sizes) {
+        prefetcher.addFrame(path, QString(), size);
+        prefetcher.addFrame(path, QString(), size, 2.0);
+    }
+    // twice in the same batch
+    prefetcher.addFrame(path, QString(), sizes.first());
+
+    prefetcher.start();
+    QVERIFY(spy.wait());
+    QCOMPARE(prefetcher.pendingCount(), 0);
+
+    // the frames composed in parallel are the ones composed one by one
+    foreach (const QSize &size, sizes) {
+        foreach (qreal ratio, QList<qreal>() << 1.0 << 2.0) {
+            // gone before the cached one is created, so they don't share their frame
+            QImage expected;
+            {
+                Plasma::FrameSvg uncached;
+                uncached.setImagePath(path);
+                uncached.setUsingRenderingCache(false);
+                uncached.setDevicePixelRatio(ratio);
+                uncached.resizeFrame(size);
+                expected = uncached.framePixmap().toImage();
+            }
+            QCOMPARE(expected.size(), size * ratio);
+
+            Plasma::FrameSvg cached;
+            cached.setImagePath(path);
+            cached.setDevicePixelRatio(ratio);
+            cached.resizeFrame(size);
+            QCOMPARE(cached.framePixmap().toImage(), expected);
+        }
+    }
+}
+
+QTEST_MAIN(RenderPrefetcherTest)
@@ -0,0 +1,82 @@
+/******************************************************************************
+*   Copyright 2016 The KDE Community                                          *
+*                                                                             *
+*   This library is free software; you can redistribute it and/or             *
+*   modify it under the terms of the GNU Library General Public               *
+*   License as published by the Free Software Foundation; either              *
+*   version 2 of the License, or (at your option) any later version.          *
+*                                                                             *
+*   This library is distributed in the hope that it will be useful,           *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU          *
+*   Library General Public License for more details.                          *
+*                                                                             *
+*   You should have received a copy of the GNU Library General Public License *
+*   along with this library; see the file COPYING.LIB.  If not, write to      *
+*   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+*   Boston, MA 02110-1301, USA.                                               *
+******************************************************************************/
+
+#include "stylesheettemplatetest.h"
+
+#include "plasma/private/stylesheettemplate_p.h"
+
+using Plasma::StyleSheetTemplate;
+
+static StyleSheetTemplate::Values testValues()
+{
+    StyleSheetTemplate::Values values(StyleSheetTemplate::PlaceholderCount);
+    for (int i = 0; i < StyleSheetTemplate::PlaceholderCount; ++i) {
+        values[i] = QStringLiteral("#%1").arg(i, 6, 10, QLatin1Char('0'));
+    }
+    values[StyleSheetTemplate::FontSize] = QStringLiteral("10pt");
+    values[StyleSheetTemplate::FontFamily] = QStringLiteral("Noto Sans");
+    return values;
+}
+
+void StyleSheetTemplateTest::fill_data()
+{
+    QTest::addColumn<QString>("css");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("empty") << QString() << QString();
+    QTest::newRow("no placeholder") << QStringLiteral("body { margin: 50%; }") << QStringLiteral("body { margin: 50%; }");
+    QTest::newRow("placeholder") << QStringLiteral(".ColorScheme-Text{color:%textcolor;}")
+                                 << QStringLiteral(".ColorScheme-Text{color:#000000;}");
+    QTest::newRow("only a placeholder") << QStringLiteral("%fontsize") << QStringLiteral("10pt");
+    QTest::newRow("adjacent") << QStringLiteral("%fontsize%fontfamily") << QStringLiteral("10ptNoto Sans");
+    QTest::newRow("unknown") << QStringLiteral("%foo %textcolorx %") << QStringLiteral("%foo #000000x %");
+    QTest::newRow("link") << QStringLiteral("a:link{color:%link;} a:visited{color:%visitedlink;}")
+                          << QStringLiteral("a:link{color:#000007;} a:visited{color:#000004;}");
+    QTest::newRow("highlight") << QStringLiteral("%highlightcolor %highlightedtextcolor")
+                               << QStringLiteral("#000002 #000003");
+}
+
+void StyleSheetTemplateTest::fill()
+{
+    QFETCH(QString, css);
+    QFETCH(QString, expected);
+
+    const StyleSheetTemplate styleSheet(css);
+    QCOMPARE(styleSheet.isEmpty(), css.isEmpty());
+    QCOMPARE(styleSheet.fill(testValues()), expected);
+}
+
+void StyleSheetTemplateTest::sameAsReplacing()
+{
+    // every placeholder, as the style sheets of the theme used to be generated
+    QString css;
+    for (int i = 0; i < StyleSheetTemplate::PlaceholderCount; ++i) {
+        css += QStringLiteral(".Rule%1{color:%2;}").arg(i).arg(StyleSheetTemplate::name(StyleSheetTemplate::Placeholder(i)));
+    }
+
+    const StyleSheetTemplate::Values values = testValues();
+    QString replaced = css;
+    for (int i = 0; i < StyleSheetTemplate::PlaceholderCount; ++i) {
+        replaced.replace(StyleSheetTemplate::name(StyleSheetTemplate::Placeholder(i)), values.at(i));
+    }
+
+    QCOMPARE(StyleSheetTemplate(css).fill(values), replaced);
+}
+
+QTEST_MAIN(StyleSheetTemplateTest)
@@ -0,0 +1,218 @@
+/******************************************************************************
+*   Copyright 2016 The KDE Community                                          *
+*                                                                             *
+*   This library is free software; you can redistribute it and/or             *
+*   modify it under the terms of the GNU Library General Public               *
+*   License as published by the Free Software Foundation; either              *
+*   version 2 of the License, or (at your option) any later version.          *
+*                                                                             *
+*   This library is distributed in the hope that it will be useful,           *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU          *
+*   Library General Public License for more details.                          *
+*                                                                             *
+*   You should have received a copy of the GNU Library General Public License *
+*   along with this library; see the file COPYING.LIB.  If not, write to      *
+*   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+*   Boston, MA 02110-1301, USA.                                               *
+******************************************************************************/
+
+#include "svgelementsindextest.h"
+
+#include "plasma/private/svgelementsindex_p.h"
+
+using Plasma::SvgElementsIndex;
+
+static const QString s_image = QStringLiteral("/usr/share/plasma/desktoptheme/default/widgets/background.svgz");
+
+QString SvgElementsIndexTest::indexFile(const QString &name) const
+{
+    return m_dir.path() + QLatin1Char('/') + name;
+}
+
+void SvgElementsIndexTest::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+}
+
+void SvgElementsIndexTest::pendingLookups()
+{
+    SvgElementsIndex index(indexFile(QStringLiteral("pending")));
+    QVERIFY(!index.isDirty());
+
+    QRectF rect;
+    QVERIFY(!index.findRect(s_image, QStringLiteral("Natural_center_0_1"), rect));
+
+    index.insertRect(s_image, QStringLiteral("Natural_center_0_1"), QRectF(1, 2, 30, 40));
+    index.insertInvalid(s_image, QStringLiteral("Natural_hint-compose-over-border_0_1"));
+    QVERIFY(index.isDirty());
+
+    QVERIFY(index.findRect(s_image, QStringLiteral("Natural_center_0_1"), rect));
+    QCOMPARE(rect, QRectF(1, 2, 30, 40));
+    QVERIFY(index.isInvalid(s_image, QStringLiteral("Natural_hint-compose-over-border_0_1")));
+    QVERIFY(!index.isInvalid(s_image, QStringLiteral("Natural_center_0_1")));
+    QCOMPARE(index.keys(s_image), QStringList() << QStringLiteral("Natural_center_0_1"));
+}
+
+void SvgElementsIndexTest::saveAndReload()
+{
+    const QString fileName = indexFile(QStringLiteral("reload"));
+    {
+        SvgElementsIndex index(fileName);
+        for (int i = 0; i < 100; ++i) {
+            index.insertRect(s_image, QStringLiteral("element%1").arg(i), QRectF(i, i, 10 + i, 20 + i));
+        }
+        index.insertInvalid(s_image, QStringLiteral("Natural_hint-stretch-borders_0_1"));
+        index.insertSizeHint(s_image, QStringLiteral("icon"), QSize(32, 32));
+        index.insertSizeHint(s_image, QStringLiteral("icon"), QSize(16, 16));
+        QVERIFY(index.save());
+        QVERIFY(!index.isDirty());
+
+        // lookups now go through the mapped file
+        QRectF rect;
+        QVERIFY(index.findRect(s_image, QStringLiteral("element42"), rect));
+        QCOMPARE(rect, QRectF(42, 42, 52, 62));
+    }
+
+    SvgElementsIndex index(fileName);
+    QRectF rect;
+    for (int i = 0; i < 100; ++i) {
+        QVERIFY(index.findRect(s_image, QStringLiteral("element%1").arg(i), rect));
+        QCOMPARE(rect, QRectF(i, i, 10 + i, 20 + i));
+    }
+    QVERIFY(!index.findRect(s_image, QStringLiteral("element100"), rect));
+    QVERIFY(!index.findRect(QStringLiteral("/other.svg"), QStringLiteral("element1"), rect));
+    QVERIFY(index.isInvalid(s_image, QStringLiteral("Natural_hint-stretch-borders_0_1")));
+    QCOMPARE(index.keys(s_image).count(), 100);
+
+    const QHash<QString, QVector<QSize> > hints = index.sizeHints(s_image);
+    QCOMPARE(hints.value(QStringLiteral("icon")), QVector<QSize>() << QSize(16, 16) << QSize(32, 32));
+}
+
+void SvgElementsIndexTest::mergeWithOtherWriter()
+{
+    const QString fileName = indexFile(QStringLiteral("merge"));
+    SvgElementsIndex first(fileName);
+    SvgElementsIndex second(fileName);
+
+    first.insertRect(s_image, QStringLiteral("first"), QRectF(0, 0, 1, 1));
+    second.insertRect(s_image, QStringLiteral("second"), QRectF(0, 0, 2, 2));
+    QVERIFY(first.save());
+    QVERIFY(second.save());
+
+    SvgElementsIndex index(fileName);
+    QRectF rect;
+    QVERIFY(index.findRect(s_image, QStringLiteral("first"), rect));
+    QCOMPARE(rect, QRectF(0, 0, 1, 1));
+    QVERIFY(index.findRect(s_image, QStringLiteral("second"), rect));
+    QCOMPARE(rect, QRectF(0, 0, 2, 2));
+}
+
+void SvgElementsIndexTest::removeImage()
+{
+    const QString fileName = indexFile(QStringLiteral("remove"));
+    const QString otherImage = QStringLiteral("/other.svg");
+    {
+        SvgElementsIndex index(fileName);
+        index.insertRect(s_image, QStringLiteral("element"), QRectF(0, 0, 1, 1));
+        index.insertRect(otherImage, QStringLiteral("element"), QRectF(0, 0, 1, 1));
+        QVERIFY(index.save());
+    }
+
+    SvgElementsIndex index(fileName);
+    index.remove(s_image);
+
+    QRectF rect;
+    QVERIFY(!index.findRect(s_image, QStringLiteral("element"), rect));
+    QVERIFY(index.findRect(otherImage, QStringLiteral("element"), rect));
+    QVERIFY(index.save());
+
+    SvgElementsIndex reloaded(fileName);
+    QVERIFY(!reloaded.findRect(s_image, QStringLiteral("element"), rect));
+    QVERIFY(reloaded.findRect(otherImage, QStringLiteral("element"), rect));
+}
+
+void SvgElementsIndexTest::tag()
+{
+    const QString fileName = indexFile(QStringLiteral("tag"));
+    {
+        SvgElementsIndex index(fileName);
+        QVERIFY(index.tag().isEmpty());
+        index.setTag(QStringLiteral("/usr/share/icons/breeze"));
+        QVERIFY(index.isDirty());
+        QVERIFY(index.save());
+    }
+
+    SvgElementsIndex index(fileName);
+    QCOMPARE(index.tag(), QStringLiteral("/usr/share/icons/breeze"));
+}
+
+void SvgElementsIndexTest::ignoreForeignFiles()
+{
+    // e.g. a KConfig based cache left over from an older version
+    const QString fileName = indexFile(QStringLiteral("foreign"));
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("[Global]\ncurrentIconThemePath=/usr/share/icons/breeze\n");
+    file.close();
+
+    SvgElementsIndex index(fileName);
+    QVERIFY(index.tag().isEmpty());
+    QVERIFY(index.keys(s_image).isEmpty());
+
+    index.insertRect(s_image, QStringLiteral("element"), QRectF(0, 0, 1, 1));
+    QVERIFY(index.save());
+
+    SvgElementsIndex reloaded(fileName);
+    QRectF rect;
+    QVERIFY(reloaded.findRect(s_image, QStringLiteral("element"), rect));
+}
+
+void SvgElementsIndexTest::ignoreCorruptFiles_data()
+{
+    QTest::addColumn<int>("offset");
+
+    // the header is 40 bytes, followed by the only image record
+    QTest::newRow("tag length") << 36;
+    QTest::newRow("path length") << 52;
+    QTest::newRow("rect count") << 60;
+    QTest::newRow("hint count") << 76;
+}
+
+void SvgElementsIndexTest::ignoreCorruptFiles()
+{
+    QFETCH(int, offset);
+
+    const QString fileName = indexFile(QStringLiteral("corrupt"));
+    QFile::remove(fileName);
+    {
+        SvgElementsIndex index(fileName);
+        index.setTag(QStringLiteral("tag"));
+        index.insertRect(s_image, QStringLiteral("element"), QRectF(0, 0, 1, 1));
+        index.insertSizeHint(s_image, QStringLiteral("element"), QSize(16, 16));
+        QVERIFY(index.save());
+    }
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.seek(offset));
+    const quint32 garbage = 0x7fffffff;
+    QCOMPARE(file.write(reinterpret_cast<const char *>(&garbage), sizeof(garbage)), qint64(sizeof(garbage)));
+    file.close();
+
+    SvgElementsIndex index(fileName);
+    QCOMPARE(index.size(), qint64(0));
+    QVERIFY(index.tag().isEmpty());
+    QVERIFY(index.keys(s_image).isEmpty());
+    QVERIFY(index.sizeHints(s_image).isEmpty());
+
+    // and it gets rewritten
+    index.insertRect(s_image, QStringLiteral("element"), QRectF(0, 0, 1, 1));
+    QVERIFY(index.save());
+
+    SvgElementsIndex reloaded(fileName);
+    QRectF rect;
+    QVERIFY(reloaded.findRect(s_image, QStringLiteral("element"), rect));
+}
+
+QTEST_MAIN(SvgElementsIndexTest)
@@ -0,0 +1,256 @@
+/******************************************************************************
+*   Copyright 2016 The KDE Community                                          *
+*                                                                             *
+*   This library is free software; you can redistribute it and/or             *
+*   modify it under the terms of the GNU Library General Public               *
+*   License as published by the Free Software Foundation; either              *
+*   version 2 of the License, or (at your option) any later version.          *
+*                                                                             *
+*   This library is distributed in the hope that it will be useful,           *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU          *
+*   Library General Public License for more details.                          *
+*                                                                             *
+*   You should have received a copy of the GNU Library General Public License *
+*   along with this library; see the file COPYING.LIB.  If not, write to      *
+*   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+*   Boston, MA 02110-1301, USA.                                               *
+******************************************************************************/
+
+#include "svgloadertest.h"
+
+#include <QBuffer>
+#include <QDirIterator>
+#include <QSvgRenderer>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+#include <KCompressionDevice>
+
+#include "plasma/private/svgdocument_p.h"
+#include "plasma/private/svgloader_p.h"
+
+using Plasma::SvgDocument;
+using Plasma::SvgLoader;
+
+// What SharedSvgRenderer::load used to do: rewrite the style sheet with
+// QXmlStreamReader/Writer, parse, then scan the whole file with a QRegExp
+static QStringList legacyLoad(QSvgRenderer &renderer, const QByteArray &contents, const QString &styleSheet)
+{
+    if (!styleSheet.isEmpty() && contents.contains("current-color-scheme")) {
+        QByteArray processedContents;
+        QXmlStreamReader reader(contents);
+
+        QBuffer buffer(&processedContents);
+        buffer.open(QIODevice::WriteOnly);
+        QXmlStreamWriter writer(&buffer);
+        while (!reader.atEnd()) {
+            if (reader.readNext() == QXmlStreamReader::StartElement &&
+                reader.qualifiedName() == QLatin1String("style") &&
+                reader.attributes().value(QLatin1String("id")) == QLatin1String("current-color-scheme")) {
+                writer.writeStartElement(QLatin1String("style"));
+                writer.writeAttributes(reader.attributes());
+                writer.writeCharacters(styleSheet);
+                writer.writeEndElement();
+                while (reader.tokenType() != QXmlStreamReader::EndElement) {
+                    reader.readNext();
+                }
+            } else if (reader.tokenType() != QXmlStreamReader::Invalid) {
+                writer.writeCurrentToken(reader);
+            }
+        }
+        buffer.close();
+        renderer.load(processedContents);
+    } else {
+        renderer.load(contents);
+    }
+
+    QStringList ids;
+    const QString contentsAsString(QString::fromLatin1(contents));
+    QRegExp idExpr(QLatin1String("id\\s*=\\s*(['\"])(\\d+-\\d+-.*)\\1"));
+    idExpr.setMinimal(true);
+
+    int pos = 0;
+    while ((pos = idExpr.indexIn(contentsAsString, pos)) != -1) {
+        const QString elementId = idExpr.cap(2);
+        if (renderer.boundsOnElement(elementId).isValid()) {
+            ids << elementId;
+        }
+        pos += idExpr.matchedLength();
+    }
+
+    return ids;
+}
+
+static QStringList singlePassLoad(QSvgRenderer &renderer, const QByteArray &contents, const QString &styleSheet)
+{
+    QStringList sizeHintedIds;
+    renderer.load(SvgLoader::process(contents, styleSheet, &sizeHintedIds));
+
+    QStringList ids;
+    foreach (const QString &elementId, sizeHintedIds) {
+        if (renderer.boundsOnElement(elementId).isValid()) {
+            ids << elementId;
+        }
+    }
+
+    return ids;
+}
+
+void SvgLoaderTest::initTestCase()
+{
+    m_styleSheet = QStringLiteral(".ColorScheme-Text { color:#31363b; } .ColorScheme-Background { color:#eff0f1; }");
+
+    const QString themesDir = QFINDTESTDATA("../src/desktoptheme");
+    QVERIFY(!themesDir.isEmpty());
+
+    QDirIterator it(themesDir, QStringList() << QStringLiteral("*.svg") << QStringLiteral("*.svgz"), QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString path = it.next();
+        KCompressionDevice file(path, KCompressionDevice::GZip);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        m_themeSvgs.insert(path, file.readAll());
+    }
+
+    QVERIFY(!m_themeSvgs.isEmpty());
+}
+
+void SvgLoaderTest::styleSheet()
+{
+    const QByteArray svg("<svg xmlns=\"http://www.w3.org/2000/svg\"><defs>"
+                         "<style id=\"current-color-scheme\" type=\"text/css\">.ColorScheme-Text { color:#000000; }</style>"
+                         "</defs><rect id=\"16-16-icon\" width=\"16\" height=\"16\"/></svg>");
+    QStringList ids;
+    const QByteArray processed = SvgLoader::process(svg, QStringLiteral(".ColorScheme-Text { color:#ff0000; } a > b"), &ids);
+
+    QVERIFY(processed.contains("<style id=\"current-color-scheme\" type=\"text/css\">.ColorScheme-Text { color:#ff0000; } a &gt; b</style>"));
+    QVERIFY(!processed.contains("#000000"));
+    QCOMPARE(ids, QStringList() << QStringLiteral("16-16-icon"));
+}
+
+void SvgLoaderTest::selfClosingStyle()
+{
+    const QByteArray svg("<svg><style id='current-color-scheme'/><g id=\"22-22-a\"/></svg>");
+    QStringList ids;
+    const QByteArray processed = SvgLoader::process(svg, QStringLiteral(".a{}"), &ids);
+
+    QCOMPARE(processed, QByteArray("<svg><style id='current-color-scheme'>.a{}</style><g id=\"22-22-a\"/></svg>"));
+    QCOMPARE(ids, QStringList() << QStringLiteral("22-22-a"));
+}
+
+void SvgLoaderTest::ignoreCommentsAndCData()
+{
+    const QByteArray svg("<?xml version=\"1.0\"?><!DOCTYPE svg [ <!ENTITY e \"<g id='8-8-entity'/>\"> ]>"
+                         "<svg><!-- <g id=\"8-8-comment\"/> --><style><![CDATA[ <g id=\"8-8-cdata\"/> ]]></style>"
+                         "<g id=\"8-8-real\"/><g id=\"8-x-notahint\"/><g xml:id=\"8-8-otherattribute\"/></svg>");
+    QStringList ids;
+    SvgLoader::process(svg, QString(), &ids);
+
+    QCOMPARE(ids, QStringList() << QStringLiteral("8-8-real"));
+}
+
+void SvgLoaderTest::unchangedWithoutStyleSheet()
+{
+    const QByteArray svg("<svg><style id=\"current-color-scheme\">.a{}</style></svg>");
+
+    QVERIFY(SvgLoader::process(svg, QString()).isSharedWith(svg));
+
+    const QByteArray noColorScheme("<svg><style id=\"other\">.a{}</style></svg>");
+    QVERIFY(SvgLoader::process(noColorScheme, QStringLiteral(".b{}")).isSharedWith(noColorScheme));
+}
+
+void SvgLoaderTest::sameAsLegacyLoader()
+{
+    QHashIterator<QString, QByteArray> it(m_themeSvgs);
+    while (it.hasNext()) {
+        it.next();
+
+        QSvgRenderer legacyRenderer;
+        QStringList legacyIds = legacyLoad(legacyRenderer, it.value(), m_styleSheet);
+        QSvgRenderer renderer;
+        QStringList ids = singlePassLoad(renderer, it.value(), m_styleSheet);
+
+        legacyIds.sort();
+        ids.sort();
+        QVERIFY2(renderer.isValid() == legacyRenderer.isValid(), qPrintable(it.key()));
+        QVERIFY2(ids == legacyIds, qPrintable(it.key()));
+        QCOMPARE(renderer.defaultSize(), legacyRenderer.defaultSize());
+    }
+}
+
+void SvgLoaderTest::colorSchemeClasses()
+{
+    const QByteArray svg("<svg><path class=\"ColorScheme-Text\"/><g class=\"foo  ColorScheme-Highlight\">"
+                         "<path class='ColorScheme-Text'/></g><!-- <path class=\"ColorScheme-Background\"/> --></svg>");
+    QStringList classes;
+    SvgLoader::process(svg, QString(), 0, &classes);
+
+    QCOMPARE(classes, QStringList() << QStringLiteral("ColorScheme-Text") << QStringLiteral("ColorScheme-Highlight"));
+}
+
+void SvgLoaderTest::documentContents()
+{
+    QHashIterator<QString, QByteArray> it(m_themeSvgs);
+    while (it.hasNext()) {
+        it.next();
+
+        const SvgDocument::Ptr document = SvgDocument::fromContents(it.value());
+        QVERIFY2(document->contents(m_styleSheet) == SvgLoader::process(it.value(), m_styleSheet), qPrintable(it.key()));
+
+        QStringList ids;
+        SvgLoader::process(it.value(), QString(), &ids);
+        QCOMPARE(document->sizeHintedIds(), ids);
+    }
+}
+
+void SvgLoaderTest::documentWithoutColorScheme()
+{
+    const QByteArray svg("<svg><style id=\"other\">.a{}</style><path class=\"ColorScheme-Text\"/></svg>");
+    const SvgDocument::Ptr document = SvgDocument::fromContents(svg);
+
+    QVERIFY(!document->usesColorScheme());
+    QVERIFY(document->effectiveStyleSheet(m_styleSheet).isEmpty());
+    QCOMPARE(document->contents(QString()), svg);
+}
+
+void SvgLoaderTest::effectiveStyleSheet()
+{
+    const QByteArray svg("<svg><style id=\"current-color-scheme\">.ColorScheme-Text{color:#000000;}</style>"
+                         "<path class=\"ColorScheme-Text\"/><style id=\"current-color-scheme\"/></svg>");
+    const SvgDocument::Ptr document = SvgDocument::fromContents(svg);
+    QVERIFY(document->usesColorScheme());
+
+    const QString normal = QStringLiteral(".ColorScheme-Text{color:#31363b;}.ColorScheme-Background{color:#eff0f1;}");
+    const QString button = QStringLiteral(".ColorScheme-Text{color:#31363b;}.ColorScheme-Background{color:#fcfcfc;}");
+    const QString complementary = QStringLiteral(".ColorScheme-Text{color:#eff0f1;}.ColorScheme-Background{color:#31363b;}");
+
+    QCOMPARE(document->effectiveStyleSheet(normal), QStringLiteral(".ColorScheme-Text{color:#31363b;}"));
+    QCOMPARE(document->effectiveStyleSheet(button), document->effectiveStyleSheet(normal));
+    QVERIFY(document->effectiveStyleSheet(complementary) != document->effectiveStyleSheet(normal));
+
+    QCOMPARE(document->contents(document->effectiveStyleSheet(normal)),
+             QByteArray("<svg><style id=\"current-color-scheme\">.ColorScheme-Text{color:#31363b;}</style>"
+                        "<path class=\"ColorScheme-Text\"/><style id=\"current-color-scheme\">.ColorScheme-Text{color:#31363b;}</style></svg>"));
+}
+
+void SvgLoaderTest::benchmarkLegacyLoader()
+{
+    QBENCHMARK {
+        foreach (const QByteArray &contents, m_themeSvgs) {
+            QSvgRenderer renderer;
+            legacyLoad(renderer, contents, m_styleSheet);
+        }
+    }
+}
+
+void SvgLoaderTest::benchmarkSinglePassLoader()
+{
+    QBENCHMARK {
+        foreach (const QByteArray &contents, m_themeSvgs) {
+            QSvgRenderer renderer;
+            singlePassLoad(renderer, contents, m_styleSheet);
+        }
+    }
+}
+
+QTEST_MAIN(SvgLoaderTest)
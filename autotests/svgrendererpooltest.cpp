@@ -0,0 +1,167 @@
+/******************************************************************************
+*   Copyright 2016 The KDE Community                                          *
+*                                                                             *
+*   This library is free software; you can redistribute it and/or             *
+*   modify it under the terms of the GNU Library General Public               *
+*   License as published by the Free Software Foundation; either              *
+*   version 2 of the License, or (at your option) any later version.          *
+*                                                                             *
+*   This library is distributed in the hope that it will be useful,           *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU          *
+*   Library General Public License for more details.                          *
+*                                                                             *
+*   You should have received a copy of the GNU Library General Public License *
+*   along with this library; see the file COPYING.LIB.  If not, write to      *
+*   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+*   Boston, MA 02110-1301, USA.                                               *
+******************************************************************************/
+
+#include "svgrendererpooltest.h"
+
+#include <QStandardPaths>
+
+#include <KConfig>
+#include <KConfigGroup>
+
+#include "plasma/svg.h"
+
+static Plasma::Svg *loadedSvg(const QString &path)
+{
+    Plasma::Svg *svg = new Plasma::Svg;
+    svg->setImagePath(path);
+    // parses the file
+    svg->isValid();
+    return svg;
+}
+
+void SvgRendererPoolTest::initTestCase()
+{
+    QStandardPaths::enableTestMode(true);
+    m_cacheDir = QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    m_cacheDir.removeRecursively();
+
+    // before the pool reads them: room for one or two of the files below
+    KConfig config(QStringLiteral("plasmarc"));
+    KConfigGroup group(&config, "CachePolicies");
+    group.writeEntry("SvgRendererCacheKb", 20);
+    group.writeEntry("SvgRendererGracePeriod", 1);
+    config.sync();
+
+    // about 14, 10 and 26 KB once parsed
+    m_paths << QFINDTESTDATA("data/background.svgz")
+            << QFINDTESTDATA("data/icons/test-theme/apps/48/konversation.svg")
+            << QFINDTESTDATA("data/icons/test-theme/apps/32/tst-plasma-framework-test-icon.svg");
+
+    m_theme = new Plasma::Theme(this);
+}
+
+void SvgRendererPoolTest::cleanupTestCase()
+{
+    delete m_theme;
+    m_cacheDir.removeRecursively();
+}
+
+int SvgRendererPoolTest::statistic(const char *name) const
+{
+    return m_theme->cacheStatistics().value(QLatin1String(name)).toInt();
+}
+
+void SvgRendererPoolTest::inUseRenderersAreKept()
+{
+    QList<Plasma::Svg *> svgs;
+    foreach (const QString &path, m_paths) {
+        svgs << loadedSvg(path);
+    }
+
+    // way over the budget, but all in use
+    QCOMPARE(statistic("renderers"), 3);
+    QCOMPARE(statistic("unusedRenderers"), 0);
+    QCOMPARE(statistic("unusedRendererBytes"), 0);
+    QVERIFY(statistic("rendererBytes") > 20 * 1024);
+
+    // the same file again shares the renderer
+    Plasma::Svg *again = loadedSvg(m_paths.first());
+    QCOMPARE(statistic("renderers"), 3);
+    delete again;
+    QCOMPARE(statistic("unusedRenderers"), 0);
+
+    qDeleteAll(svgs);
+    QTRY_COMPARE(statistic("renderers"), 0);
+}
+
+void SvgRendererPoolTest::evictionOverBudget()
+{
+    QList<Plasma::Svg *> svgs;
+    foreach (const QString &path, m_paths) {
+        svgs << loadedSvg(path);
+    }
+    QCOMPARE(statistic("renderers"), 3);
+
+    // within the budget: kept for the grace period
+    delete svgs.takeFirst();
+    QCOMPARE(statistic("unusedRenderers"), 1);
+    QCOMPARE(statistic("renderers"), 3);
+
+    // both unused ones don't fit: the least recently used one goes
+    delete svgs.takeFirst();
+    QCOMPARE(statistic("unusedRenderers"), 1);
+    QCOMPARE(statistic("renderers"), 2);
+    QVERIFY(statistic("unusedRendererBytes") <= 20 * 1024);
+
+    // bigger than the whole budget: nothing unused is kept
+    delete svgs.takeFirst();
+    QCOMPARE(statistic("unusedRenderers"), 0);
+    QCOMPARE(statistic("renderers"), 0);
+    QCOMPARE(statistic("unusedRendererBytes"), 0);
+}
+
+void SvgRendererPoolTest::gracePeriodExpiry()
+{
+    m_theme->resetCacheStatistics();
+
+    Plasma::Svg *svg = loadedSvg(m_paths.at(1));
+    delete svg;
+    QCOMPARE(statistic("unusedRenderers"), 1);
+
+    // reused within the grace period
+    svg = loadedSvg(m_paths.at(1));
+    QCOMPARE(statistic("unusedRenderers"), 0);
+    QCOMPARE(statistic("renderers"), 1);
+    QCOMPARE(statistic("renderersReused"), 1);
+    delete svg;
+
+    // dropped once it expires
+    QCOMPARE(statistic("unusedRenderers"), 1);
+    QTRY_COMPARE(statistic("unusedRenderers"), 0);
+    QCOMPARE(statistic("renderers"), 0);
+}
+
+void SvgRendererPoolTest::colorGroupChange()
+{
+    // uses the color scheme: one renderer per color group
+    Plasma::Svg *svg = loadedSvg(QFINDTESTDATA("data/icons/test-theme/apps/22/tst-plasma-framework-test-icon.svg"));
+    QCOMPARE(statistic("renderers"), 1);
+    QCOMPARE(statistic("unusedRenderers"), 0);
+
+    // the renderer of the previous colors is given back to the pool
+    svg->setColorGroup(Plasma::Theme::ComplementaryColorGroup);
+    svg->isValid();
+    QCOMPARE(statistic("renderers"), 2);
+    QCOMPARE(statistic("unusedRenderers"), 1);
+    QVERIFY(statistic("unusedRendererBytes") > 0);
+    QVERIFY(statistic("unusedRendererBytes") <= 20 * 1024);
+
+    // and reused when switching back
+    svg->setColorGroup(Plasma::Theme::NormalColorGroup);
+    svg->isValid();
+    QCOMPARE(statistic("renderers"), 2);
+    QCOMPARE(statistic("unusedRenderers"), 1);
+
+    delete svg;
+    QCOMPARE(statistic("unusedRenderers"), 2);
+    QVERIFY(statistic("unusedRendererBytes") <= 20 * 1024);
+    QTRY_COMPARE(statistic("renderers"), 0);
+}
+
+QTEST_MAIN(SvgRendererPoolTest)
@@ -0,0 +1,103 @@
+/******************************************************************************
+*   Copyright 2016 The KDE Community                                          *
+*                                                                             *
+*   This library is free software; you can redistribute it and/or             *
+*   modify it under the terms of the GNU Library General Public               *
+*   License as published by the Free Software Foundation; either              *
+*   version 2 of the License, or (at your option) any later version.          *
+*                                                                             *
+*   This library is distributed in the hope that it will be useful,           *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU          *
+*   Library General Public License for more details.                          *
+*                                                                             *
+*   You should have received a copy of the GNU Library General Public License *
+*   along with this library; see the file COPYING.LIB.  If not, write to      *
+*   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+*   Boston, MA 02110-1301, USA.                                               *
+******************************************************************************/
+
+#include "svgsizehintstest.h"
+
+#include "plasma/private/svgsizehints_p.h"
+
+using Plasma::SvgSizeHints;
+
+void SvgSizeHintsTest::parse_data()
+{
+    QTest::addColumn<QString>("id");
+    QTest::addColumn<bool>("valid");
+    QTest::addColumn<QSize>("expectedHint");
+    QTest::addColumn<QString>("expectedElementId");
+
+    QTest::newRow("hinted") << "16-22-go-home" << true << QSize(16, 22) << "go-home";
+    QTest::newRow("plain") << "go-home" << false << QSize() << QString();
+    QTest::newRow("no element") << "16-22-" << false << QSize() << QString();
+    QTest::newRow("no height") << "16--home" << false << QSize() << QString();
+    QTest::newRow("not a number") << "a-22-home" << false << QSize() << QString();
+    QTest::newRow("empty size") << "0-22-home" << false << QSize() << QString();
+}
+
+void SvgSizeHintsTest::parse()
+{
+    QFETCH(QString, id);
+    QFETCH(bool, valid);
+
+    QSize hint;
+    QString elementId;
+    QCOMPARE(SvgSizeHints::parse(id, hint, elementId), valid);
+    if (valid) {
+        QFETCH(QSize, expectedHint);
+        QFETCH(QString, expectedElementId);
+        QCOMPARE(hint, expectedHint);
+        QCOMPARE(elementId, expectedElementId);
+    }
+}
+
+void SvgSizeHintsTest::bestFit_data()
+{
+    QTest::addColumn<QString>("elementId");
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<QString>("result");
+
+    QTest::newRow("exact") << "home" << QSize(22, 22) << "22-22-home";
+    QTest::newRow("smaller") << "home" << QSize(10, 10) << "16-16-home";
+    QTest::newRow("between") << "home" << QSize(23, 20) << "32-32-home";
+    QTest::newRow("wide") << "home" << QSize(40, 8) << "48-16-home";
+    QTest::newRow("too big") << "home" << QSize(64, 64) << QString();
+    QTest::newRow("other element") << "panel" << QSize(10, 10) << "24-24-panel";
+    QTest::newRow("unknown element") << "hom" << QSize(10, 10) << QString();
+}
+
+void SvgSizeHintsTest::bestFit()
+{
+    QFETCH(QString, elementId);
+    QFETCH(QSize, size);
+    QFETCH(QString, result);
+
+    const SvgSizeHints hints(QStringList()
+                             << QStringLiteral("32-32-home")
+                             << QStringLiteral("16-16-home")
+                             << QStringLiteral("48-16-home")
+                             << QStringLiteral("22-22-home")
+                             << QStringLiteral("22-22-home")
+                             << QStringLiteral("home")
+                             << QStringLiteral("24-24-panel"));
+
+    QCOMPARE(hints.bestFit(elementId, size), result);
+}
+
+void SvgSizeHintsTest::fromIndex()
+{
+    QHash<QString, QVector<QSize> > indexHints;
+    indexHints[QStringLiteral("home")] << QSize(32, 32) << QSize(16, 16) << QSize();
+
+    const SvgSizeHints hints(indexHints);
+    QVERIFY(!hints.isEmpty());
+    QCOMPARE(hints.bestFit(QStringLiteral("home"), QSize(20, 20)), QStringLiteral("32-32-home"));
+    QCOMPARE(hints.bestFit(QStringLiteral("home"), QSize(1, 1)), QStringLiteral("16-16-home"));
+
+    QVERIFY(SvgSizeHints(QStringList()).isEmpty());
+}
+
+QTEST_MAIN(SvgSizeHintsTest)
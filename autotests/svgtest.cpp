@@ -0,0 +1,122 @@
+/******************************************************************************
+*   Copyright 2016 The KDE Community                                          *
+*                                                                             *
+*   This library is free software; you can redistribute it and/or             *
+*   modify it under the terms of the GNU Library General Public               *
+*   License as published by the Free Software Foundation; either              *
+*   version 2 of the License, or (at your option) any later version.          *
+*                                                                             *
+*   This library is distributed in the hope that it will be useful,           *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU          *
+*   Library General Public License for more details.                          *
+*                                                                             *
+*   You should have received a copy of the GNU Library General Public License *
+*   along with this library; see the file COPYING.LIB.  If not, write to      *
+*   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+*   Boston, MA 02110-1301, USA.                                               *
+******************************************************************************/
+
+#include "svgtest.h"
+
+#include <QStandardPaths>
+
+#include "plasma/svg.h"
+
+void SvgTest::initTestCase()
+{
+    QStandardPaths::enableTestMode(true);
+    m_cacheDir = QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    m_cacheDir.removeRecursively();
+
+    m_path = QFINDTESTDATA("data/background.svgz");
+}
+
+void SvgTest::cleanupTestCase()
+{
+    m_cacheDir.removeRecursively();
+}
+
+void SvgTest::requestCachedImage()
+{
+    Plasma::Svg svg;
+    svg.setImagePath(m_path);
+    // puts it in the cache
+    const QImage expected = svg.image(QSize(40, 40));
+    QVERIFY(!expected.isNull());
+
+    QSignalSpy spy(&svg, SIGNAL(imageReady(int,QImage)));
+    const int request = svg.requestImage(QSize(40, 40));
+
+    // emitted before returning
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.first().at(0).toInt(), request);
+    QCOMPARE(spy.first().at(1).value<QImage>(), expected);
+}
+
+void SvgTest::requestImage()
+{
+    Plasma::Svg svg;
+    svg.setImagePath(m_path);
+
+    QSignalSpy spy(&svg, SIGNAL(imageReady(int,QImage)));
+    const int request = svg.requestImage(QSize(50, 70), QStringLiteral("center"));
+    QCOMPARE(spy.count(), 0);
+
+    QVERIFY(spy.wait());
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.first().at(0).toInt(), request);
+
+    // the same pixels image() renders
+    Plasma::Svg uncached;
+    uncached.setImagePath(m_path);
+    uncached.setUsingRenderingCache(false);
+    const QImage expected = uncached.image(QSize(50, 70), QStringLiteral("center"));
+    QVERIFY(!expected.isNull());
+    QCOMPARE(spy.first().at(1).value<QImage>(), expected);
+}
+
+void SvgTest::cancelImageRequest()
+{
+    Plasma::Svg svg;
+    svg.setImagePath(m_path);
+
+    QSignalSpy spy(&svg, SIGNAL(imageReady(int,QImage)));
+    const int request = svg.requestImage(QSize(60, 60));
+    QCOMPARE(spy.count(), 0);
+
+    svg.cancelImageRequest(request);
+    QVERIFY(!spy.wait(500));
+    QCOMPARE(spy.count(), 0);
+}
+
+void SvgTest::concurrentImageRequests()
+{
+    Plasma::Svg svg;
+    svg.setImagePath(m_path);
+
+    QSignalSpy spy(&svg, SIGNAL(imageReady(int,QImage)));
+    QHash<int, QSize> sizes;
+    foreach (const QSize &size, QList<QSize>() << QSize(20, 20) << QSize(30, 45) << QSize(90, 30) << QSize(64, 64)) {
+        sizes.insert(svg.requestImage(size), size);
+    }
+    QCOMPARE(sizes.count(), 4);
+    QCOMPARE(spy.count(), 0);
+
+    while (spy.count() < sizes.count()) {
+        QVERIFY(spy.wait());
+    }
+    QCOMPARE(spy.count(), sizes.count());
+
+    // every request answered once, with its own image
+    QSet<int> answered;
+    foreach (const QList<QVariant> &arguments, spy) {
+        const int request = arguments.at(0).toInt();
+        QVERIFY(sizes.contains(request));
+        QVERIFY(!answered.contains(request));
+        answered.insert(request);
+        QCOMPARE(arguments.at(1).value<QImage>().size(), sizes.value(request));
+    }
+}
+
+QTEST_MAIN(SvgTest)
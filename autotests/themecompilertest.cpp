@@ -0,0 +1,138 @@
+/******************************************************************************
+*   Copyright 2016 The KDE Community                                          *
+*                                                                             *
+*   This library is free software; you can redistribute it and/or             *
+*   modify it under the terms of the GNU Library General Public               *
+*   License as published by the Free Software Foundation; either              *
+*   version 2 of the License, or (at your option) any later version.          *
+*                                                                             *
+*   This library is distributed in the hope that it will be useful,           *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU          *
+*   Library General Public License for more details.                          *
+*                                                                             *
+*   You should have received a copy of the GNU Library General Public License *
+*   along with this library; see the file COPYING.LIB.  If not, write to      *
+*   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+*   Boston, MA 02110-1301, USA.                                               *
+******************************************************************************/
+
+#include "themecompilertest.h"
+
+#include <QProcess>
+#include <QStandardPaths>
+
+#include <KConfig>
+#include <KConfigGroup>
+
+#include "plasma/svg.h"
+#include "plasma/theme.h"
+
+static const char *const s_elements[] = {"center", "top", "left", "topleft", "bottomright", "hint-left-margin"};
+
+void ThemeCompilerTest::initTestCase()
+{
+    QStandardPaths::enableTestMode(true);
+    QVERIFY(m_dataDir.isValid());
+
+    // the themes are looked up in the temporary data dir
+    qputenv("XDG_DATA_DIRS", QFile::encodeName(m_dataDir.path()) + ":" + qgetenv("XDG_DATA_DIRS"));
+
+    // measured by parsing the svg
+    int renderersCreated = 0;
+    m_expected = elementRects(QString(), QFINDTESTDATA("data/background.svgz"), &renderersCreated);
+    QVERIFY(renderersCreated > 0);
+}
+
+void ThemeCompilerTest::cleanupTestCase()
+{
+    removeThemeCaches(QStringLiteral("compiledtheme"));
+    removeThemeCaches(QStringLiteral("mismatchedtheme"));
+}
+
+QString ThemeCompilerTest::createTheme(const QString &name, const QString &version)
+{
+    const QString themeDir = m_dataDir.path() + QStringLiteral("/plasma/desktoptheme/") + name;
+    if (!QDir().mkpath(themeDir + QStringLiteral("/widgets")) ||
+        !QFile::copy(QFINDTESTDATA("data/background.svgz"), themeDir + QStringLiteral("/widgets/background.svgz"))) {
+        return QString();
+    }
+
+    KConfig metadata(themeDir + QStringLiteral("/metadata.desktop"), KConfig::SimpleConfig);
+    KConfigGroup group(&metadata, "Desktop Entry");
+    group.writeEntry("Name", name);
+    group.writeEntry("X-KDE-PluginInfo-Name", name);
+    group.writeEntry("X-KDE-PluginInfo-Version", version);
+    group.writeEntry("X-Plasma-API", "5.0");
+    metadata.sync();
+
+    // what plasma_compile_theme() does at build time
+    const int exitCode = QProcess::execute(QStringLiteral(PLASMA_THEMECOMPILER),
+                                           QStringList() << themeDir << themeDir + QStringLiteral("/elements.index"));
+    if (exitCode != 0 || !QFile::exists(themeDir + QStringLiteral("/elements.index"))) {
+        return QString();
+    }
+
+    removeThemeCaches(name);
+    return themeDir;
+}
+
+QList<QRectF> ThemeCompilerTest::elementRects(const QString &themeName, const QString &imagePath, int *renderersCreated) const
+{
+    QScopedPointer<Plasma::Theme> theme(themeName.isEmpty() ? new Plasma::Theme : new Plasma::Theme(themeName));
+    theme->resetCacheStatistics();
+
+    Plasma::Svg svg;
+    svg.setTheme(theme.data());
+    svg.setContainsMultipleImages(true);
+    svg.setImagePath(imagePath);
+
+    QList<QRectF> rects;
+    rects << QRectF(QPointF(0, 0), svg.size());
+    for (const char *element : s_elements) {
+        rects << svg.elementRect(QLatin1String(element));
+    }
+    // known to be missing
+    rects << svg.elementRect(QStringLiteral("overlay"));
+
+    *renderersCreated = theme->cacheStatistics().value(QStringLiteral("renderersCreated")).toInt();
+    return rects;
+}
+
+void ThemeCompilerTest::removeThemeCaches(const QString &themeName) const
+{
+    QDir cacheDir(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation));
+    const QStringList patterns = QStringList() << QStringLiteral("plasma_theme_") + themeName + QStringLiteral("_*")
+                                               << QStringLiteral("plasma-svgelements-") + themeName + QStringLiteral("_*");
+    foreach (const QString &file, cacheDir.entryList(patterns, QDir::Files)) {
+        cacheDir.remove(file);
+    }
+}
+
+void ThemeCompilerTest::compiledIndex()
+{
+    QVERIFY(!createTheme(QStringLiteral("compiledtheme"), QStringLiteral("1.0")).isEmpty());
+
+    // the same rects, without parsing the svg
+    int renderersCreated = -1;
+    QCOMPARE(elementRects(QStringLiteral("compiledtheme"), QStringLiteral("widgets/background"), &renderersCreated), m_expected);
+    QCOMPARE(renderersCreated, 0);
+}
+
+void ThemeCompilerTest::versionMismatch()
+{
+    const QString themeDir = createTheme(QStringLiteral("mismatchedtheme"), QStringLiteral("1.0"));
+    QVERIFY(!themeDir.isEmpty());
+
+    // the theme has been updated since its index was compiled
+    KConfig metadata(themeDir + QStringLiteral("/metadata.desktop"), KConfig::SimpleConfig);
+    KConfigGroup(&metadata, "Desktop Entry").writeEntry("X-KDE-PluginInfo-Version", "1.1");
+    metadata.sync();
+
+    // the index is ignored, the rects are measured from the svg
+    int renderersCreated = -1;
+    QCOMPARE(elementRects(QStringLiteral("mismatchedtheme"), QStringLiteral("widgets/background"), &renderersCreated), m_expected);
+    QVERIFY(renderersCreated > 0);
+}
+
+QTEST_MAIN(ThemeCompilerTest)
@@ -0,0 +1,102 @@
+/******************************************************************************
+*   Copyright 2016 The KDE Community                                          *
+*                                                                             *
+*   This library is free software; you can redistribute it and/or             *
+*   modify it under the terms of the GNU Library General Public               *
+*   License as published by the Free Software Foundation; either              *
+*   version 2 of the License, or (at your option) any later version.          *
+*                                                                             *
+*   This library is distributed in the hope that it will be useful,           *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU          *
+*   Library General Public License for more details.                          *
+*                                                                             *
+*   You should have received a copy of the GNU Library General Public License *
+*   along with this library; see the file COPYING.LIB.  If not, write to      *
+*   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+*   Boston, MA 02110-1301, USA.                                               *
+******************************************************************************/
+
+#include "themefileindextest.h"
+
+#include <QStandardPaths>
+
+#include "plasma/private/themefileindex_p.h"
+
+using Plasma::ThemeFileIndex;
+
+static const char s_theme[] = "themefileindextest";
+
+void ThemeFileIndexTest::createFile(const QString &relativePath)
+{
+    const QString path = m_themeDir + relativePath;
+    QVERIFY(QDir().mkpath(QFileInfo(path).absolutePath()));
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("<svg/>");
+}
+
+void ThemeFileIndexTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+
+    m_themeDir = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) +
+                 QLatin1String("/plasma/desktoptheme/") + QLatin1String(s_theme);
+    QDir(m_themeDir).removeRecursively();
+
+    createFile(QStringLiteral("/metadata.desktop"));
+    createFile(QStringLiteral("/widgets/background.svgz"));
+    createFile(QStringLiteral("/widgets/tooltip.svg"));
+    createFile(QStringLiteral("/opaque/widgets/background.svgz"));
+    createFile(QStringLiteral("/translucent/dialogs/background.svgz"));
+}
+
+void ThemeFileIndexTest::cleanupTestCase()
+{
+    QDir(m_themeDir).removeRecursively();
+}
+
+void ThemeFileIndexTest::locate()
+{
+    ThemeFileIndex *index = ThemeFileIndex::self();
+    const QString theme = QLatin1String(s_theme);
+
+    QCOMPARE(index->locate(theme, QStringLiteral("/widgets/background.svgz")), m_themeDir + QLatin1String("/widgets/background.svgz"));
+    QCOMPARE(index->locate(theme, QStringLiteral("/metadata.desktop")), m_themeDir + QLatin1String("/metadata.desktop"));
+
+    // misses
+    QVERIFY(index->locate(theme, QStringLiteral("/widgets/tooltip.svgz")).isEmpty());
+    QVERIFY(index->locate(theme, QStringLiteral("/widgets")).isEmpty());
+    QVERIFY(index->locate(theme, QStringLiteral("widgets/background.svgz")).isEmpty());
+    QVERIFY(index->locate(QStringLiteral("themefileindextest-none"), QStringLiteral("/widgets/background.svgz")).isEmpty());
+    QVERIFY(index->locate(QString(), QStringLiteral("/widgets/background.svgz")).isEmpty());
+
+    QCOMPARE(index->files(theme).count(), 5);
+}
+
+void ThemeFileIndexTest::variants()
+{
+    ThemeFileIndex *index = ThemeFileIndex::self();
+    const QString theme = QLatin1String(s_theme);
+
+    QCOMPARE(index->locate(theme, QStringLiteral("/opaque/widgets/background.svgz")), m_themeDir + QLatin1String("/opaque/widgets/background.svgz"));
+    QCOMPARE(index->locate(theme, QStringLiteral("/translucent/dialogs/background.svgz")), m_themeDir + QLatin1String("/translucent/dialogs/background.svgz"));
+    QVERIFY(index->locate(theme, QStringLiteral("/locolor/widgets/background.svgz")).isEmpty());
+}
+
+void ThemeFileIndexTest::fileAdded()
+{
+    ThemeFileIndex *index = ThemeFileIndex::self();
+    const QString theme = QLatin1String(s_theme);
+    QVERIFY(index->locate(theme, QStringLiteral("/widgets/panel-background.svgz")).isEmpty());
+
+    QSignalSpy changed(index, SIGNAL(themeChanged(QString)));
+    createFile(QStringLiteral("/widgets/panel-background.svgz"));
+
+    QTRY_VERIFY_WITH_TIMEOUT(!changed.isEmpty(), 10000);
+    QCOMPARE(changed.first().first().toString(), theme);
+    QCOMPARE(index->locate(theme, QStringLiteral("/widgets/panel-background.svgz")), m_themeDir + QLatin1String("/widgets/panel-background.svgz"));
+}
+
+QTEST_MAIN(ThemeFileIndexTest)
@@ -21,6 +21,7 @@
 #include <QStandardPaths>
 #include <QApplication>
 
+#include <KColorScheme>
 #include <KIconLoader>
 #include <KIconTheme>
 
@@ -195,6 +196,179 @@ void ThemeTest::testColors()
                             Plasma::Theme::ComplementaryColorGroup), QColor(237,21,24));
 }
 
+void ThemeTest::colorTable()
+{
+    // the colors looked up once per group are the ones of the color scheme
+    const KSharedConfigPtr colors = KSharedConfig::openConfig(QFINDTESTDATA("data/plasma/desktoptheme/testtheme/colors"));
+    const KColorScheme::ColorSet sets[] = {KColorScheme::Window, KColorScheme::Button, KColorScheme::View, KColorScheme::Complementary};
+    const KColorScheme selection(QPalette::Active, KColorScheme::Selection, colors);
+
+    for (int group = Plasma::Theme::NormalColorGroup; group <= Plasma::Theme::ComplementaryColorGroup; ++group) {
+        const KColorScheme scheme(QPalette::Active, sets[group], colors);
+        QList<QPair<Plasma::Theme::ColorRole, QColor> > expected;
+        expected << qMakePair(Plasma::Theme::TextColor, scheme.foreground(KColorScheme::NormalText).color())
+                 << qMakePair(Plasma::Theme::BackgroundColor, scheme.background(KColorScheme::NormalBackground).color())
+                 << qMakePair(Plasma::Theme::HoverColor, scheme.decoration(KColorScheme::HoverColor).color())
+                 << qMakePair(Plasma::Theme::HighlightColor, selection.background(KColorScheme::NormalBackground).color())
+                 << qMakePair(Plasma::Theme::FocusColor, scheme.decoration(KColorScheme::FocusColor).color())
+                 << qMakePair(Plasma::Theme::LinkColor, scheme.foreground(KColorScheme::LinkText).color())
+                 << qMakePair(Plasma::Theme::VisitedLinkColor, scheme.foreground(KColorScheme::VisitedText).color())
+                 << qMakePair(Plasma::Theme::HighlightedTextColor, selection.foreground(KColorScheme::NormalText).color())
+                 << qMakePair(Plasma::Theme::PositiveTextColor, scheme.foreground(KColorScheme::PositiveText).color())
+                 << qMakePair(Plasma::Theme::NeutralTextColor, scheme.foreground(KColorScheme::NeutralText).color())
+                 << qMakePair(Plasma::Theme::NegativeTextColor, scheme.foreground(KColorScheme::NegativeText).color());
+
+        for (int i = 0; i < expected.count(); ++i) {
+            QCOMPARE(m_theme->color(expected.at(i).first, Plasma::Theme::ColorGroup(group)), expected.at(i).second);
+        }
+    }
+
+    // without colors of its own, a theme follows the system colors and
+    // builds its table again when they change
+    Plasma::Theme systemColors(QStringLiteral("themetest-no-such-theme"));
+    KConfigGroup window(KSharedConfig::openConfig(), "Colors:Window");
+    window.writeEntry("ForegroundNormal", QColor(1, 2, 3));
+    window.sync();
+    QEvent paletteChange(QEvent::ApplicationPaletteChange);
+    QCoreApplication::sendEvent(QCoreApplication::instance(), &paletteChange);
+    QCOMPARE(systemColors.color(Plasma::Theme::TextColor), QColor(1, 2, 3));
+
+    window.writeEntry("ForegroundNormal", QColor(4, 5, 6));
+    window.sync();
+    QCoreApplication::sendEvent(QCoreApplication::instance(), &paletteChange);
+    QCOMPARE(systemColors.color(Plasma::Theme::TextColor), QColor(4, 5, 6));
+
+    // the caches of the other tests are only discarded once all of it is done
+    QSignalSpy spy(m_theme, SIGNAL(themeChanged()));
+    window.deleteEntry("ForegroundNormal");
+    window.sync();
+    QCoreApplication::sendEvent(QCoreApplication::instance(), &paletteChange);
+    QVERIFY(spy.wait());
+}
+
+void ThemeTest::cacheStatistics()
+{
+    m_theme->resetCacheStatistics();
+
+    QVariantMap statistics = m_theme->cacheStatistics();
+    QCOMPARE(statistics.value(QStringLiteral("pixmapCacheHits")).toInt(), 0);
+    QCOMPARE(statistics.value(QStringLiteral("pixmapCacheMisses")).toInt(), 0);
+    QVERIFY(statistics.contains(QStringLiteral("pixmapCacheBytes")));
+    QVERIFY(statistics.contains(QStringLiteral("rendererBytes")));
+    QVERIFY(statistics.value(QStringLiteral("renderTimes")).toMap().isEmpty());
+
+    // a size not rendered yet
+    m_svg->resize(37, 37);
+    m_svg->pixmap();
+
+    statistics = m_theme->cacheStatistics();
+    QCOMPARE(statistics.value(QStringLiteral("pixmapCacheMisses")).toInt(), 1);
+    QCOMPARE(statistics.value(QStringLiteral("renderTimes")).toMap().count(), 1);
+
+    const QVariantList renderTimes = statistics.value(QStringLiteral("renderTimes")).toMap().first().toList();
+    int renders = 0;
+    foreach (const QVariant &count, renderTimes) {
+        renders += count.toInt();
+    }
+    QCOMPARE(renders, 1);
+
+    m_svg->pixmap();
+
+    statistics = m_theme->cacheStatistics();
+    QCOMPARE(statistics.value(QStringLiteral("pixmapCacheMisses")).toInt(), 1);
+    QCOMPARE(statistics.value(QStringLiteral("pixmapCacheHits")).toInt() +
+             statistics.value(QStringLiteral("pendingPixmapHits")).toInt(), 1);
+}
+
+void ThemeTest::insertIntoCacheWithId()
+{
+    QPixmap small(16, 16);
+    small.fill(Qt::red);
+    QPixmap big(32, 32);
+    big.fill(Qt::blue);
+
+    // queued until written, but found right away
+    m_theme->insertIntoCache(QStringLiteral("themetest_small"), small, QStringLiteral("themetest"));
+    QPixmap found;
+    QVERIFY(m_theme->findInCache(QStringLiteral("themetest_small"), found));
+    QCOMPARE(found.size(), QSize(16, 16));
+
+    m_theme->insertIntoCache(QStringLiteral("themetest_big"), big, QStringLiteral("themetest"));
+    QVERIFY(m_theme->findInCache(QStringLiteral("themetest_big"), found));
+    QCOMPARE(found.size(), QSize(32, 32));
+}
+
+void ThemeTest::insertedPixmapsFollowColors()
+{
+    QPixmap pixmap(16, 16);
+    pixmap.fill(Qt::green);
+
+    m_theme->insertIntoCache(QStringLiteral("themetest_colors"), pixmap);
+    m_theme->insertIntoCache(QStringLiteral("themetest_colors_queued"), pixmap, QStringLiteral("themetest_colors"));
+    QPixmap found;
+    QVERIFY(m_theme->findInCache(QStringLiteral("themetest_colors"), found));
+    QVERIFY(m_theme->findInCache(QStringLiteral("themetest_colors_queued"), found));
+
+    // the theme can't know whether they were painted with the colors
+    QSignalSpy spy(m_theme, SIGNAL(themeChanged()));
+    QEvent paletteChange(QEvent::ApplicationPaletteChange);
+    QCoreApplication::sendEvent(QCoreApplication::instance(), &paletteChange);
+    QVERIFY(spy.wait());
+
+    QVERIFY(!m_theme->findInCache(QStringLiteral("themetest_colors"), found));
+    QVERIFY(!m_theme->findInCache(QStringLiteral("themetest_colors_queued"), found));
+}
+
+void ThemeTest::staleCaches()
+{
+    const QDir cacheDir(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation));
+    const QString themeName = m_theme->themeName();
+    const QStringList pixmapFiles = QStringList() << QStringLiteral("plasma_theme_") + themeName + QStringLiteral("_*.pixmaps");
+
+    QPixmap pixmap(16, 16);
+    pixmap.fill(Qt::yellow);
+
+    // written to the cache named after the current fingerprint
+    m_theme->insertIntoCache(QStringLiteral("themetest_stale"), pixmap);
+    QTRY_COMPARE(cacheDir.entryList(pixmapFiles, QDir::Files).count(), 1);
+    const QString oldFile = cacheDir.entryList(pixmapFiles, QDir::Files).first();
+
+    // caches of an older fingerprint, of before the fingerprints, files QSaveFile
+    // is still writing and the cache of another theme
+    const QStringList staleFiles = QStringList()
+            << QStringLiteral("plasma_theme_") + themeName + QStringLiteral(".kcache")
+            << QStringLiteral("plasma-svgelements-") + themeName + QStringLiteral("_0123456789abcdef");
+    const QStringList keptFiles = QStringList()
+            << oldFile + QStringLiteral(".Ab12Cd")
+            << QStringLiteral("plasma-svgelements-") + themeName + QStringLiteral("_0123456789abcdef.Xy34Zw")
+            << QStringLiteral("plasma_theme_") + themeName + QStringLiteral("-other_0123456789abcdef.pixmaps");
+    foreach (const QString &file, staleFiles + keptFiles) {
+        QFile f(cacheDir.absoluteFilePath(file));
+        QVERIFY(f.open(QIODevice::WriteOnly));
+    }
+
+    // another icon theme changes the fingerprint
+    QSignalSpy spy(m_theme, SIGNAL(themeChanged()));
+    const QString iconTheme = KIconLoader::global()->theme()->internalName();
+    KIconTheme::forceThemeForTests(iconTheme == QLatin1String("test-theme") ? QStringLiteral("test-theme-two") : QStringLiteral("test-theme"));
+    for (int i = 0; i < KIconLoader::LastGroup; i++) {
+        KIconLoader::emitChange(KIconLoader::Group(i));
+    }
+    QVERIFY(spy.wait());
+
+    m_theme->insertIntoCache(QStringLiteral("themetest_stale"), pixmap);
+    QTRY_VERIFY(!cacheDir.exists(oldFile));
+    QTRY_COMPARE(cacheDir.entryList(pixmapFiles, QDir::Files).count(), 1);
+    QVERIFY(cacheDir.entryList(pixmapFiles, QDir::Files).first() != oldFile);
+
+    foreach (const QString &file, staleFiles) {
+        QTRY_VERIFY2(!cacheDir.exists(file), qPrintable(file));
+    }
+    foreach (const QString &file, keptFiles) {
+        QVERIFY2(cacheDir.exists(file), qPrintable(file));
+        QFile::remove(cacheDir.absoluteFilePath(file));
+    }
+}
 
 QTEST_MAIN(ThemeTest)
 
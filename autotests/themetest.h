@@ -35,6 +35,11 @@ public Q_SLOTS:
 private Q_SLOTS:
     void loadSvgIcon();
     void testColors();
+    void colorTable();
+    void cacheStatistics();
+    void insertIntoCacheWithId();
+    void insertedPixmapsFollowColors();
+    void staleCaches();
 
 private:
     Plasma::Svg *m_svg;
@@ -0,0 +1,107 @@
+/******************************************************************************
+*   Copyright 2016 The KDE Community                                          *
+*                                                                             *
+*   This library is free software; you can redistribute it and/or             *
+*   modify it under the terms of the GNU Library General Public               *
+*   License as published by the Free Software Foundation; either              *
+*   version 2 of the License, or (at your option) any later version.          *
+*                                                                             *
+*   This library is distributed in the hope that it will be useful,           *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU          *
+*   Library General Public License for more details.                          *
+*                                                                             *
+*   You should have received a copy of the GNU Library General Public License *
+*   along with this library; see the file COPYING.LIB.  If not, write to      *
+*   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+*   Boston, MA 02110-1301, USA.                                               *
+******************************************************************************/
+
+#include "wallpapercataloguetest.h"
+
+#include "plasma/private/wallpapercatalogue_p.h"
+
+using Plasma::WallpaperCatalogue;
+
+void WallpaperCatalogueTest::parseSize_data()
+{
+    QTest::addColumn<QString>("fileName");
+    QTest::addColumn<bool>("valid");
+    QTest::addColumn<QSize>("size");
+
+    QTest::newRow("size") << QStringLiteral("1920x1080.png") << true << QSize(1920, 1080);
+    QTest::newRow("other suffix") << QStringLiteral("1920x1080.jpg") << false << QSize();
+    QTest::newRow("no width") << QStringLiteral("x1080.png") << false << QSize();
+    QTest::newRow("no height") << QStringLiteral("1920x.png") << false << QSize();
+    QTest::newRow("not a size") << QStringLiteral("screenshot.png") << false << QSize();
+    QTest::newRow("zero") << QStringLiteral("0x1080.png") << false << QSize();
+}
+
+void WallpaperCatalogueTest::parseSize()
+{
+    QFETCH(QString, fileName);
+    QFETCH(bool, valid);
+    QFETCH(QSize, size);
+
+    QSize parsed;
+    QCOMPARE(WallpaperCatalogue::parseSize(fileName, QStringLiteral(".png"), &parsed), valid);
+    if (valid) {
+        QCOMPARE(parsed, size);
+    }
+}
+
+void WallpaperCatalogueTest::bestFit_data()
+{
+    QTest::addColumn<QSize>("screen");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("exact") << QSize(1920, 1080) << QStringLiteral("1920x1080.png");
+    QTest::newRow("smallest covering") << QSize(640, 480) << QStringLiteral("1024x768.png");
+    QTest::newRow("same aspect ratio") << QSize(1366, 768) << QStringLiteral("1920x1080.png");
+    QTest::newRow("other aspect ratio") << QSize(1280, 1024) << QStringLiteral("1920x1080.png");
+    QTest::newRow("none covering") << QSize(5120, 2880) << QStringLiteral("3840x2160.png");
+    QTest::newRow("portrait") << QSize(1080, 1920) << QStringLiteral("3840x2160.png");
+}
+
+void WallpaperCatalogueTest::bestFit()
+{
+    QFETCH(QSize, screen);
+    QFETCH(QString, expected);
+
+    WallpaperCatalogue catalogue;
+    catalogue.addImages(QStringLiteral("/images"), QStringList()
+                        << QStringLiteral("1024x768.png") << QStringLiteral("1920x1080.png")
+                        << QStringLiteral("1920x1200.png") << QStringLiteral("3840x2160.png")
+                        << QStringLiteral("metadata.desktop"), QStringLiteral(".png"));
+
+    QCOMPARE(catalogue.sizes().count(), 4);
+    QCOMPARE(catalogue.bestFit(screen), QStringLiteral("/images/") + expected);
+    // remembered
+    QCOMPARE(catalogue.bestFit(screen), QStringLiteral("/images/") + expected);
+}
+
+void WallpaperCatalogueTest::priority()
+{
+    WallpaperCatalogue catalogue;
+    catalogue.addImage(QSize(1920, 1080), QStringLiteral("/home/images/1920x1080.png"));
+    QCOMPARE(catalogue.bestFit(QSize(1024, 768)), QStringLiteral("/home/images/1920x1080.png"));
+
+    catalogue.addImage(QSize(1920, 1080), QStringLiteral("/usr/images/1920x1080.png"));
+    catalogue.addImage(QSize(1024, 768), QStringLiteral("/usr/images/1024x768.png"));
+
+    // a new image is picked up by the sizes already asked for
+    QCOMPARE(catalogue.bestFit(QSize(1024, 768)), QStringLiteral("/usr/images/1024x768.png"));
+    QCOMPARE(catalogue.bestFit(QSize(1920, 1080)), QStringLiteral("/home/images/1920x1080.png"));
+}
+
+void WallpaperCatalogueTest::empty()
+{
+    WallpaperCatalogue catalogue;
+    QVERIFY(catalogue.isEmpty());
+    QVERIFY(catalogue.bestFit(QSize(1920, 1080)).isEmpty());
+
+    catalogue.addImage(QSize(1920, 1080), QStringLiteral("/images/1920x1080.png"));
+    QVERIFY(catalogue.bestFit(QSize()).isEmpty());
+}
+
+QTEST_MAIN(WallpaperCatalogueTest)
@@ -40,6 +40,7 @@
 IconItem::IconItem(QQuickItem *parent)
     : QQuickItem(parent),
       m_svgIcon(0),
+      m_svgIconRequest(0),
       m_status(Plasma::Svg::Normal),
       m_smooth(false),
       m_active(false),
@@ -112,6 +113,7 @@ void IconItem::setSource(const QVariant &source)
                 m_svgIcon->setStatus(m_status);
                 m_svgIcon->setDevicePixelRatio((window() ? window()->devicePixelRatio() : qApp->devicePixelRatio()));
                 connect(m_svgIcon, &Plasma::Svg::repaintNeeded, this, &IconItem::schedulePixmapUpdate);
+                connect(m_svgIcon, &Plasma::Svg::imageReady, this, &IconItem::svgImageReady);
             }
 
             if (m_usesPlasmaTheme) {
@@ -420,8 +422,14 @@ void IconItem::loadPixmap()
         return;
     } else if (m_svgIcon) {
         m_svgIcon->resize(size, size);
+        if (m_svgIconRequest) {
+            m_svgIcon->cancelImageRequest(m_svgIconRequest);
+            m_svgIconRequest = 0;
+        }
+
+        QString element;
         if (m_svgIcon->hasElement(m_svgIconName)) {
-            result = m_svgIcon->pixmap(m_svgIconName);
+            element = m_svgIconName;
         } else if (!m_svgIconName.isEmpty()) {
             const auto *iconTheme = KIconLoader::global()->theme();
             QString iconPath;
@@ -437,7 +445,19 @@ void IconItem::loadPixmap()
             if (!iconPath.isEmpty()) {
                 m_svgIcon->setImagePath(iconPath);
             }
-            result = m_svgIcon->pixmap();
+        }
+
+        if (m_sizeChanged && !m_iconPixmap.isNull() && !m_svgIconName.isEmpty()) {
+            //only resized: keep showing the old pixmap until the new one is rendered,
+            //-1 means the request is being made and the image was in the cache
+            m_svgIconRequest = -1;
+            const int request = m_svgIcon->requestImage(QSize(size, size), element);
+            if (m_svgIconRequest == -1) {
+                m_svgIconRequest = request;
+            }
+            return;
+        } else if (!m_svgIconName.isEmpty()) {
+            result = m_svgIcon->pixmap(element);
         }
     } else if (!m_icon.isNull()) {
         result = m_icon.pixmap(QSize(size, size) * (window() ? window()->devicePixelRatio() : qApp->devicePixelRatio()));
@@ -450,6 +470,23 @@ void IconItem::loadPixmap()
         return;
     }
 
+    updateIconPixmap(result);
+}
+
+void IconItem::svgImageReady(int request, const QImage &image)
+{
+    if (request != m_svgIconRequest && m_svgIconRequest != -1) {
+        return;
+    }
+
+    m_svgIconRequest = 0;
+    //it's the same icon at the new size, don't animate
+    m_sizeChanged = true;
+    updateIconPixmap(QPixmap::fromImage(image));
+}
+
+void IconItem::updateIconPixmap(QPixmap result)
+{
     if (!isEnabled()) {
         result = KIconLoader::global()->iconEffect()->apply(result, KIconLoader::Desktop, KIconLoader::DisabledState);
     } else if (m_active) {
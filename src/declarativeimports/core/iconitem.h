@@ -164,14 +164,18 @@ private Q_SLOTS:
     void animationFinished();
     void valueChanged(const QVariant &value);
     void enabledChanged();
+    void svgImageReady(int request, const QImage &image);
 
 private:
     void loadPixmap();
+    void updateIconPixmap(QPixmap result);
 
     //all the ways we can set an source. Only one of them will be valid
     QIcon m_icon;
     Plasma::Svg *m_svgIcon;
     QString m_svgIconName;
+    //svg icon rendered for the new size, while the old one is still shown
+    int m_svgIconRequest;
     QPixmap m_pixmapIcon;
     QImage m_imageIcon;
     //this contains the raw variant it was passed
@@ -37,7 +37,8 @@ namespace Plasma
 SvgItem::SvgItem(QQuickItem *parent)
     : QQuickItem(parent),
       m_smooth(false),
-      m_textureChanged(false)
+      m_textureChanged(false),
+      m_imageRequest(0)
 {
     setFlag(QQuickItem::ItemHasContents, true);
     connect(&m_units, &Units::devicePixelRatioChanged, this, &SvgItem::updateDevicePixelRatio);
@@ -86,6 +87,10 @@ QSizeF SvgItem::naturalSize() const
 void SvgItem::setSvg(Plasma::Svg *svg)
 {
     if (m_svg) {
+        if (m_imageRequest) {
+            m_svg.data()->cancelImageRequest(m_imageRequest);
+            m_imageRequest = 0;
+        }
         disconnect(m_svg.data(), 0, this, 0);
     }
     m_svg = svg;
@@ -95,6 +100,7 @@ void SvgItem::setSvg(Plasma::Svg *svg)
         connect(svg, SIGNAL(repaintNeeded()), this, SLOT(updateNeeded()));
         connect(svg, SIGNAL(repaintNeeded()), this, SIGNAL(naturalSizeChanged()));
         connect(svg, SIGNAL(sizeChanged()), this, SIGNAL(naturalSizeChanged()));
+        connect(svg, &Svg::imageReady, this, &SvgItem::imageReady);
     }
 
     if (implicitWidth() <= 0) {
@@ -154,7 +160,8 @@ QSGNode *SvgItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *updateP
     //if !m_smooth and size is approximate simply change the textureNode.rect without
     //updating the material
 
-    if (m_textureChanged || textureNode->texture()->textureSize() != QSize(width(), height())) {
+    //while a new image is being rendered the old one is stretched to the new size
+    if (m_textureChanged) {
         //despite having a valid size sometimes we still get a null QImage from Plasma::Svg
         //loading a null texture to an atlas fatals
         //Dave E fixed this in Qt in 5.3.something onwards but we need this for now
@@ -169,10 +176,10 @@ QSGNode *SvgItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *updateP
         }
         textureNode->setTexture(texture);
         m_textureChanged = false;
-
-        textureNode->setRect(0, 0, width(), height());
     }
 
+    textureNode->setRect(0, 0, width(), height());
+
     return textureNode;
 }
 
@@ -201,8 +208,23 @@ void SvgItem::updateDevicePixelRatio()
     }
 }
 
+void SvgItem::imageReady(int request, const QImage &image)
+{
+    //-1 means the request is being made and the image was in the cache
+    if (request != m_imageRequest && m_imageRequest != -1) {
+        return;
+    }
+
+    m_imageRequest = 0;
+    m_image = image;
+    m_textureChanged = true;
+    update();
+}
+
 void SvgItem::scheduleImageUpdate()
 {
+    //the content changed, the old image can't be shown in the meantime
+    m_image = QImage();
     polish();
     update();
 }
@@ -213,16 +235,33 @@ void SvgItem::updatePolish()
 
     if (m_svg) {
         //setContainsMultipleImages has to be done there since m_frameSvg can be shared with somebody else
-        m_textureChanged = true;
         m_svg.data()->setContainsMultipleImages(!m_elementID.isEmpty());
-        m_image = m_svg.data()->image(QSize(width(), height()), m_elementID);
+
+        if (m_imageRequest) {
+            m_svg.data()->cancelImageRequest(m_imageRequest);
+            m_imageRequest = 0;
+        }
+
+        if (m_image.isNull()) {
+            //nothing to show meanwhile, render right away
+            m_textureChanged = true;
+            m_image = m_svg.data()->image(QSize(width(), height()), m_elementID);
+        } else {
+            //only resized: keep showing the old image until the new one is rendered
+            m_imageRequest = -1;
+            const int request = m_svg.data()->requestImage(QSize(width(), height()), m_elementID);
+            if (m_imageRequest == -1) {
+                m_imageRequest = request;
+            }
+        }
     }
 }
 
 void SvgItem::geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry)
 {
     if (newGeometry.size() != oldGeometry.size() && newGeometry.isValid()) {
-        scheduleImageUpdate();
+        polish();
+        update();
     }
 
     QQuickItem::geometryChanged(newGeometry, oldGeometry);
@@ -95,6 +95,7 @@ protected Q_SLOTS:
 /// @cond INTERNAL_DOCS
     void updateNeeded();
     void updateDevicePixelRatio();
+    void imageReady(int request, const QImage &image);
 /// @endcond
 
 private:
@@ -108,6 +109,8 @@ private:
     bool m_textureChanged;
     Units m_units;
     QImage m_image;
+    //request for the image at the new size, while the old one is still shown
+    int m_imageRequest;
 };
 }
 
@@ -22,32 +22,70 @@
 #include "private/framesvg_p.h"
 
 #include <QAtomicInt>
-#include <QBitmap>
 #include <QCryptographicHash>
 #include <QPainter>
 #include <QRegion>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QSet>
 #include <QSize>
 #include <QStringBuilder>
+#include <QThreadPool>
 #include <QTimer>
 
 #include <QDebug>
 
 #include "theme.h"
+#include "private/alpharegion_p.h"
+#include "private/cachestatistics_p.h"
+#include "private/framebackgroundcache_p.h"
 #include "private/svg_p.h"
+#include "private/svgrasterizer_p.h"
+#include "private/theme_p.h"
 #include "private/framesvg_helpers.h"
 #include "debug_p.h"
 
 namespace Plasma
 {
 
-QHash<ThemePrivate *, QHash<QString, FrameData *> > FrameSvgPrivate::s_sharedFrames;
+QHash<ThemePrivate *, QHash<PixmapCacheKey, FrameData *> > FrameSvgPrivate::s_sharedFrames;
+QHash<ThemePrivate *, QHash<PixmapCacheKey, NinePatch::Ptr> > FrameSvgPrivate::s_ninePatches;
+QHash<ThemePrivate *, QHash<PixmapCacheKey, FrameMetrics> > FrameSvgPrivate::s_frameMetrics;
 
 // Any attempt to generate a frame whose width or height is larger than this
 // will be rejected
 static const int MAX_FRAME_SIZE = 100000;
 
+// Composes one frame of a batch in a worker thread
+class FrameComposer : public QRunnable
+{
+public:
+    FrameComposer(const FrameComposition &composition, QImage &image, QSemaphore &done)
+        : m_composition(composition),
+          m_image(image),
+          m_done(done)
+    {
+    }
+
+    void run() Q_DECL_OVERRIDE
+    {
+        m_image = FrameSvgPrivate::composeFrame(m_composition);
+        m_done.release();
+    }
+
+private:
+    const FrameComposition m_composition;
+    QImage &m_image;
+    QSemaphore &m_done;
+};
+
 FrameData::~FrameData()
 {
+    // null once the application is exiting
+    if (FrameBackgroundCache *backgrounds = FrameBackgroundCache::self()) {
+        backgrounds->remove(this);
+    }
+
     foreach (FrameSvg *frame, references.keys()) {
         frame->d->frames.remove(prefix);
     }
@@ -80,7 +118,7 @@ void FrameSvg::setImagePath(const QString &path)
     if (fd->refcount() == 1) {
         // we're the only user of it, let's remove it from the shared keys
         // we don't want to deref it, however, as we'll still be using it
-        const QString oldKey = d->cacheId(fd, d->prefix);
+        const PixmapCacheKey oldKey = d->cacheId(fd, d->prefix);
         FrameSvgPrivate::s_sharedFrames[fd->theme].remove(oldKey);
     } else {
         // others are using this frame, so deref it for ourselves
@@ -93,8 +131,8 @@ void FrameSvg::setImagePath(const QString &path)
     if (!fd) {
         // we need to replace our frame, start by looking in the frame cache
         FrameData *oldFd = d->frames[d->prefix];
-        const QString key = d->cacheId(oldFd, d->prefix);
-        fd = FrameSvgPrivate::s_sharedFrames[theme()->d].value(key);
+        const PixmapCacheKey key = d->cacheId(oldFd, d->prefix);
+        fd = FrameSvgPrivate::sharedFrame(theme()->d, key);
 
         if (fd) {
             // we found one, so ref it and use it; we also don't need to (or want to!)
@@ -114,7 +152,7 @@ void FrameSvg::setImagePath(const QString &path)
     setContainsMultipleImages(true);
     if (updateNeeded) {
         // ensure our frame is in the cache
-        const QString key = d->cacheId(fd, d->prefix);
+        const PixmapCacheKey key = d->cacheId(fd, d->prefix);
         FrameSvgPrivate::s_sharedFrames[theme()->d].insert(key, fd);
         fd->theme = theme()->d;
 
@@ -133,14 +171,14 @@ void FrameSvg::setEnabledBorders(const EnabledBorders borders)
 
     FrameData *fd = d->frames[d->prefix];
 
-    const QString oldKey = d->cacheId(fd, d->prefix);
+    const PixmapCacheKey oldKey = d->cacheId(fd, d->prefix);
     const EnabledBorders oldBorders = fd->enabledBorders;
     fd->enabledBorders = borders;
-    const QString newKey = d->cacheId(fd, d->prefix);
+    const PixmapCacheKey newKey = d->cacheId(fd, d->prefix);
     fd->enabledBorders = oldBorders;
 
     //qCDebug(LOG_PLASMA) << "looking for" << newKey;
-    FrameData *newFd = FrameSvgPrivate::s_sharedFrames[theme()->d].value(newKey);
+    FrameData *newFd = FrameSvgPrivate::sharedFrame(theme()->d, newKey);
     if (newFd) {
         //qCDebug(LOG_PLASMA) << "FOUND IT!" << newFd->refcount;
         // we've found a math, so insert that new one and ref it ..
@@ -149,7 +187,7 @@ void FrameSvg::setEnabledBorders(const EnabledBorders borders)
 
         //.. then deref the old one and if it's no longer used, get rid of it
         if (fd->deref(this)) {
-            //const QString oldKey = d->cacheId(fd, d->prefix);
+            //const PixmapCacheKey oldKey = d->cacheId(fd, d->prefix);
             //qCDebug(LOG_PLASMA) << "1. Removing it" << oldKey << fd->refcount;
             FrameSvgPrivate::s_sharedFrames[fd->theme].remove(oldKey);
             delete fd;
@@ -236,8 +274,8 @@ void FrameSvg::setElementPrefix(const QString &prefix)
         if (oldFrameData) {
             FrameData *newFd = 0;
             if (!oldFrameData->frameSize.isEmpty()) {
-                const QString key = d->cacheId(oldFrameData, d->prefix);
-                newFd = FrameSvgPrivate::s_sharedFrames[theme()->d].value(key);
+                const PixmapCacheKey key = d->cacheId(oldFrameData, d->prefix);
+                newFd = FrameSvgPrivate::sharedFrame(theme()->d, key);
                 if (newFd && newFd->devicePixelRatio != devicePixelRatio()) {
                     newFd = 0;
                 }
@@ -257,7 +295,7 @@ void FrameSvg::setElementPrefix(const QString &prefix)
             if (cache) {
                 // we have to cache after inserting the frame since the cacheId requires the
                 // frame to be in the frames collection already
-                const QString key = d->cacheId(oldFrameData, d->prefix);
+                const PixmapCacheKey key = d->cacheId(oldFrameData, d->prefix);
                 //qCDebug(LOG_PLASMA) << this << "     1. inserting as" << key;
 
                 FrameSvgPrivate::s_sharedFrames[theme()->d].insert(key, newFd);
@@ -277,7 +315,7 @@ void FrameSvg::setElementPrefix(const QString &prefix)
         d->frames.remove(oldPrefix);
         if (oldFrameData) {
             if (oldFrameData->deref(this)) {
-                const QString oldKey = d->cacheId(oldFrameData, oldPrefix);
+                const PixmapCacheKey oldKey = d->cacheId(oldFrameData, oldPrefix);
                 FrameSvgPrivate::s_sharedFrames[oldFrameData->theme].remove(oldKey);
                 delete oldFrameData;
             }
@@ -342,14 +380,18 @@ void FrameSvg::resizeFrame(const QSizeF &size)
         return;
     }
 
-    const QString oldKey = d->cacheId(fd, d->prefix);
+    if (isInteractiveResizing()) {
+        Svg::d->startResizing();
+    }
+
+    const PixmapCacheKey oldKey = d->cacheId(fd, d->prefix);
     const QSize currentSize = fd->frameSize;
     fd->frameSize = size.toSize();
-    const QString newKey = d->cacheId(fd, d->prefix);
+    const PixmapCacheKey newKey = d->cacheId(fd, d->prefix);
     fd->frameSize = currentSize;
 
     //qCDebug(LOG_PLASMA) << "looking for" << newKey;
-    FrameData *newFd = FrameSvgPrivate::s_sharedFrames[theme()->d].value(newKey);
+    FrameData *newFd = FrameSvgPrivate::sharedFrame(theme()->d, newKey);
     if (newFd) {
         //qCDebug(LOG_PLASMA) << "FOUND IT!" << newFd->refcount;
         // we've found a math, so insert that new one and ref it ..
@@ -358,7 +400,7 @@ void FrameSvg::resizeFrame(const QSizeF &size)
 
         //.. then deref the old one and if it's no longer used, get rid of it
         if (fd->deref(this)) {
-            //const QString oldKey = d->cacheId(fd, d->prefix);
+            //const PixmapCacheKey oldKey = d->cacheId(fd, d->prefix);
             //qCDebug(LOG_PLASMA) << "1. Removing it" << oldKey << fd->refcount;
             FrameSvgPrivate::s_sharedFrames[fd->theme].remove(oldKey);
             delete fd;
@@ -500,19 +542,17 @@ QPixmap FrameSvg::alphaMask() const
 QRegion FrameSvg::mask() const
 {
     FrameData *frame = d->frames[d->prefix];
-    QString id = d->cacheId(frame, QString());
+    const PixmapCacheKey id = d->cacheId(frame, d->prefix);
 
-    QRegion* obj = frame->cachedMasks.object(id);
-    QRegion result;
-
-    if (!obj) {
-        obj = new QRegion(QBitmap(d->alphaMask().alphaChannel().createMaskFromColor(Qt::black)));
-        result = *obj;
-        frame->cachedMasks.insert(id, obj);
-    }
-    else {
-        result = *obj;
+    // identical frames, e.g. the panels of two screens, share their mask
+    QCache<PixmapCacheKey, QRegion> &masks = theme()->d->frameMasks;
+    const QRegion *obj = masks.object(id);
+    if (obj) {
+        return *obj;
     }
+
+    const QRegion result = AlphaRegion::fromImage(d->alphaMask().toImage());
+    masks.insert(id, new QRegion(result));
     return result;
 }
 
@@ -541,8 +581,9 @@ void FrameSvg::clearCache()
         if (frame != p) {
             //TODO: should we clear from the Theme pixmap cache as well?
             if (p->deref(this)) {
-                const QString key = d->cacheId(p, it.key());
+                const PixmapCacheKey key = d->cacheId(p, it.key());
                 FrameSvgPrivate::s_sharedFrames[p->theme].remove(key);
+                FrameBackgroundCache::self()->remove(p);
                 p->cachedBackground = QPixmap();
             }
 
@@ -556,6 +597,8 @@ QPixmap FrameSvg::framePixmap()
     FrameData *frame = d->frames[d->prefix];
     if (frame->cachedBackground.isNull()) {
         d->generateBackground(frame);
+    } else {
+        FrameBackgroundCache::self()->touch(frame);
     }
 
     return frame->cachedBackground;
@@ -569,6 +612,8 @@ void FrameSvg::paintFrame(QPainter *painter, const QRectF &target, const QRectF
         if (frame->cachedBackground.isNull()) {
             return;
         }
+    } else {
+        FrameBackgroundCache::self()->touch(frame);
     }
 
     painter->drawPixmap(target, frame->cachedBackground, source.isValid() ? source : target);
@@ -582,6 +627,8 @@ void FrameSvg::paintFrame(QPainter *painter, const QPointF &pos)
         if (frame->cachedBackground.isNull()) {
             return;
         }
+    } else {
+        FrameBackgroundCache::self()->touch(frame);
     }
 
     painter->drawPixmap(pos, frame->cachedBackground);
@@ -603,7 +650,7 @@ FrameSvgPrivate::~FrameSvgPrivate()
             // we remove all references from this widget to the frame, and delete it if we're the
             // last user
             if (it.value()->removeRefs(q)) {
-                const QString key = cacheId(it.value(), it.key());
+                const PixmapCacheKey key = cacheId(it.value(), it.key());
 #ifdef DEBUG_FRAMESVG_CACHE
 #ifndef NDEBUG
                 // qCDebug(LOG_PLASMA) << "2. Removing it" << key << it.value() << it.value()->refcount() << s_sharedFrames[theme()->d].contains(key);
@@ -627,7 +674,7 @@ FrameSvgPrivate::~FrameSvgPrivate()
     }
 
 #ifdef DEBUG_FRAMESVG_CACHE
-    QHashIterator<QString, FrameData *> it2(s_sharedFrames[theme()->d]);
+    QHashIterator<PixmapCacheKey, FrameData *> it2(s_sharedFrames[theme()->d]);
     int shares = 0;
     while (it2.hasNext()) {
         it2.next();
@@ -682,11 +729,11 @@ QPixmap FrameSvgPrivate::alphaMask()
         prefix = maskPrefix % oldPrefix;
 
         if (!frames.contains(prefix)) {
-            const QString key = cacheId(frame, prefix);
+            const PixmapCacheKey key = cacheId(frame, prefix);
             // see if we can find a suitable candidate in the shared frames
             // if successful, ref and insert, otherwise create a new one
             // and insert that into both the shared frames and our frames.
-            FrameData *maskFrame = s_sharedFrames[q->theme()->d].value(key);
+            FrameData *maskFrame = sharedFrame(q->theme()->d, key);
 
             if (maskFrame) {
                 maskFrame->ref(q);
@@ -704,14 +751,15 @@ QPixmap FrameSvgPrivate::alphaMask()
         FrameData *maskFrame = frames[prefix];
         maskFrame->enabledBorders = frame->enabledBorders;
         if (maskFrame->cachedBackground.isNull() || maskFrame->frameSize != frameSize(frame)) {
-            const QString oldKey = cacheId(maskFrame, prefix);
+            const PixmapCacheKey oldKey = cacheId(maskFrame, prefix);
             maskFrame->frameSize = frameSize(frame).toSize();
-            const QString newKey = cacheId(maskFrame, prefix);
+            const PixmapCacheKey newKey = cacheId(maskFrame, prefix);
             if (s_sharedFrames[q->theme()->d].contains(oldKey)) {
                 s_sharedFrames[q->theme()->d].remove(oldKey);
                 s_sharedFrames[q->theme()->d].insert(newKey, maskFrame);
             }
 
+            FrameBackgroundCache::self()->remove(maskFrame);
             maskFrame->cachedBackground = QPixmap();
 
             generateBackground(maskFrame);
@@ -727,46 +775,109 @@ QPixmap FrameSvgPrivate::alphaMask()
 
 void FrameSvgPrivate::generateBackground(FrameData *frame)
 {
-    if (!frame->cachedBackground.isNull() || !q->hasElementPrefix(q->prefix())) {
+    PendingBackground pending;
+    if (!beginBackground(frame, pending)) {
         return;
     }
 
-    const QString id = cacheId(frame, prefix);
+    if (!pending.frameCached) {
+        generateFrameBackground(frame);
+    }
 
-    bool frameCached = !frame->cachedBackground.isNull();
-    bool overlayCached = false;
-    const bool overlayAvailable = !prefix.startsWith(QLatin1String("mask-")) && q->hasElement(prefix % QLatin1String("overlay"));
-    QPixmap overlay;
-    if (q->isUsingRenderingCache()) {
-        frameCached = q->theme()->findInCache(id, frame->cachedBackground) && !frame->cachedBackground.isNull();
+    finishBackground(pending);
+}
+
+void FrameSvgPrivate::generateBackgrounds(const QList<FrameSvg *> &svgs)
+{
+    QList<PendingBackground> pending;
+    QList<FrameSvgPrivate *> owners;
+    QVector<FrameComposition> compositions;
+    QSet<FrameData *> started;
+
+    // Everything touching the svgs or the cache happens here, in the GUI thread
+    foreach (FrameSvg *svg, svgs) {
+        FrameSvgPrivate *d = svg->d;
+        FrameData *frame = d->frames.value(d->prefix);
+        // frames shared by several svgs of the batch are generated once
+        if (!frame || started.contains(frame)) {
+            continue;
+        }
+
+        PendingBackground background;
+        if (!d->beginBackground(frame, background)) {
+            continue;
+        }
 
-        if (overlayAvailable) {
-            overlayCached = q->theme()->findInCache(QLatin1String("overlay_") % id, overlay) && !overlay.isNull();
+        FrameComposition composition;
+        if (!background.frameCached) {
+            d->prepareComposition(frame, composition);
         }
+
+        started.insert(frame);
+        pending << background;
+        owners << d;
+        compositions << composition;
     }
 
-    if (!frameCached) {
-        generateFrameBackground(frame);
+    const QVector<QImage> images = composeFrames(compositions);
+
+    // in the order of the batch, as if framePixmap() was called on each svg in turn
+    for (int i = 0; i < pending.count(); ++i) {
+        if (compositions.at(i).isValid()) {
+            owners.at(i)->installBackground(pending.at(i).frame, images.at(i));
+        }
+        owners.at(i)->finishBackground(pending[i]);
     }
+}
+
+bool FrameSvgPrivate::beginBackground(FrameData *frame, PendingBackground &pending)
+{
+    if (!frame->cachedBackground.isNull() || !q->hasElementPrefix(q->prefix())) {
+        return false;
+    }
+
+    const PixmapCacheKey id = cacheId(frame, prefix);
+
+    pending.frame = frame;
+    pending.frameCached = !frame->cachedBackground.isNull();
+    pending.overlayCached = false;
+    if (q->isUsingRenderingCache()) {
+        pending.frameCached = q->theme()->d->findInCache(id, frame->cachedBackground) && !frame->cachedBackground.isNull();
+
+        if (frameMetrics().hasHint(FrameMetrics::Overlay)) {
+            pending.overlayCached = q->theme()->d->findInCache(id.withType(PixmapCacheKey::FrameOverlay), pending.overlay) &&
+                                    !pending.overlay.isNull();
+        }
+    }
+
+    return true;
+}
+
+void FrameSvgPrivate::finishBackground(PendingBackground &pending)
+{
+    FrameData *frame = pending.frame;
+    const FrameMetrics metrics = frameMetrics();
+    const bool overlayAvailable = metrics.hasHint(FrameMetrics::Overlay);
+    QPixmap &overlay = pending.overlay;
 
     //Overlays
     QSize overlaySize;
     QPoint actualOverlayPos = QPoint(0, 0);
-    if (overlayAvailable && !overlayCached) {
+    if (overlayAvailable && !pending.overlayCached) {
         overlaySize = q->elementSize(prefix % QLatin1String("overlay"));
 
-        if (q->hasElement(prefix % QLatin1String("hint-overlay-pos-right"))) {
+        if (metrics.hasHint(FrameMetrics::OverlayPosRight)) {
             actualOverlayPos.setX(frame->frameSize.width() - overlaySize.width());
-        } else if (q->hasElement(prefix % QLatin1String("hint-overlay-pos-bottom"))) {
+        } else if (metrics.hasHint(FrameMetrics::OverlayPosBottom)) {
             actualOverlayPos.setY(frame->frameSize.height() - overlaySize.height());
             //Stretched or Tiled?
-        } else if (q->hasElement(prefix % QLatin1String("hint-overlay-stretch"))) {
+        } else if (metrics.hasHint(FrameMetrics::OverlayStretch)) {
             overlaySize = frameSize(frame).toSize();
         } else {
-            if (q->hasElement(prefix % QLatin1String("hint-overlay-tile-horizontal"))) {
+            if (metrics.hasHint(FrameMetrics::OverlayTileHorizontal)) {
                 overlaySize.setWidth(frameSize(frame).width());
             }
-            if (q->hasElement(prefix % QLatin1String("hint-overlay-tile-vertical"))) {
+            if (metrics.hasHint(FrameMetrics::OverlayTileVertical)) {
                 overlaySize.setHeight(frameSize(frame).height());
             }
         }
@@ -775,8 +886,8 @@ void FrameSvgPrivate::generateBackground(FrameData *frame)
         QPainter overlayPainter(&overlay);
         overlayPainter.setCompositionMode(QPainter::CompositionMode_SourceIn);
         //Tiling?
-        if (q->hasElement(prefix % QLatin1String("hint-overlay-tile-horizontal")) ||
-                q->hasElement(prefix % QLatin1String("hint-overlay-tile-vertical"))) {
+        if (metrics.hasHint(FrameMetrics::OverlayTileHorizontal) ||
+                metrics.hasHint(FrameMetrics::OverlayTileVertical)) {
 
             QSize s = q->size();
             q->resize(q->elementSize(prefix % QLatin1String("overlay")));
@@ -790,8 +901,8 @@ void FrameSvgPrivate::generateBackground(FrameData *frame)
         overlayPainter.end();
     }
 
-    if (!frameCached) {
-        cacheFrame(prefix, frame->cachedBackground, overlayCached ? overlay : QPixmap());
+    if (!pending.frameCached) {
+        cacheFrame(prefix, frame->cachedBackground, pending.overlayCached ? overlay : QPixmap());
     }
 
     if (!overlay.isNull()) {
@@ -799,49 +910,251 @@ void FrameSvgPrivate::generateBackground(FrameData *frame)
         p.setCompositionMode(QPainter::CompositionMode_SourceOver);
         p.drawPixmap(actualOverlayPos, overlay, QRect(actualOverlayPos, overlaySize));
     }
+
+    FrameBackgroundCache::self()->touch(frame);
 }
 
 void FrameSvgPrivate::generateFrameBackground(FrameData *frame)
 {
     //qCDebug(LOG_PLASMA) << "generating background";
+    FrameComposition composition;
+    if (prepareComposition(frame, composition)) {
+        installBackground(frame, composeFrame(composition));
+    }
+}
+
+bool FrameSvgPrivate::prepareComposition(FrameData *frame, FrameComposition &composition)
+{
     const QSize size = frameSize(frame).toSize() * q->devicePixelRatio();
 
     if (!size.isValid()) {
 #ifndef NDEBUG
         // qCDebug(LOG_PLASMA) << "Invalid frame size" << size;
 #endif
-        return;
+        return false;
     }
     if (size.width() >= MAX_FRAME_SIZE || size.height() >= MAX_FRAME_SIZE) {
         qCWarning(LOG_PLASMA) << "Not generating frame background for a size whose width or height is more than" << MAX_FRAME_SIZE << size;
-        return;
+        return false;
     }
 
-    frame->cachedBackground = QPixmap(size);
-    frame->cachedBackground.fill(Qt::transparent);
-    QPainter p(&frame->cachedBackground);
+    composition.patches = ninePatch(frame);
+    composition.size = size;
+    composition.tileCenter = frame->tileCenter;
+    composition.stretchBorders = frame->stretchBorders;
+    composition.composeOverBorder = frame->composeOverBorder;
+
+    const QRect contentRect = contentGeometry(frame, size);
+    if (!contentRect.isEmpty()) {
+        composition.sections[NinePatch::Center] = frame->composeOverBorder ? QRect(QPoint(0, 0), size)
+                                                  : FrameSvgHelpers::sectionRect(FrameSvg::NoBorder, contentRect, size);
+    }
+
+    const QSize borderSize = frame->frameSize * q->devicePixelRatio();
+    const FrameSvg::EnabledBorders borders[] = {
+        FrameSvg::LeftBorder | FrameSvg::TopBorder,
+        FrameSvg::RightBorder | FrameSvg::TopBorder,
+        FrameSvg::LeftBorder | FrameSvg::BottomBorder,
+        FrameSvg::RightBorder | FrameSvg::BottomBorder,
+        FrameSvg::LeftBorder,
+        FrameSvg::RightBorder,
+        FrameSvg::TopBorder,
+        FrameSvg::BottomBorder
+    };
+    for (const FrameSvg::EnabledBorders &border : borders) {
+        composition.sections[ninePatchPart(border)] = FrameSvgHelpers::sectionRect(border, contentRect, borderSize);
+    }
+
+    renderStretchedPatches(frame, composition);
+
+    // without mask elements the frame would be its own mask, which it's still being composed into
+    if (frame->composeOverBorder && q->hasElement(QLatin1String("mask-") % prefix % QLatin1String("center"))) {
+        composition.mask = alphaMask().toImage();
+    }
+
+    return true;
+}
+
+QImage FrameSvgPrivate::composeFrame(const FrameComposition &composition)
+{
+    QImage image(composition.size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter p(&image);
     p.setCompositionMode(QPainter::CompositionMode_Source);
     p.setRenderHint(QPainter::SmoothPixmapTransform);
 
-    QRect contentRect = contentGeometry(frame, size);
-    paintCenter(p, frame, contentRect, size);
+    const NinePatch &patches = *composition.patches;
+    patches.draw(p, NinePatch::Center, composition.sections[NinePatch::Center], composition.tileCenter);
+
+    if (composition.composeOverBorder) {
+        if (!composition.mask.isNull()) {
+            p.setCompositionMode(QPainter::CompositionMode_DestinationIn);
+            p.drawImage(QRect(QPoint(0, 0), composition.size), composition.mask);
+        }
+        p.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    }
 
-    paintCorner(p, frame, FrameSvg::LeftBorder|FrameSvg::TopBorder, contentRect);
-    paintCorner(p, frame, FrameSvg::RightBorder|FrameSvg::TopBorder, contentRect);
-    paintCorner(p, frame, FrameSvg::LeftBorder|FrameSvg::BottomBorder, contentRect);
-    paintCorner(p, frame, FrameSvg::RightBorder|FrameSvg::BottomBorder, contentRect);
+    // Corners
+    patches.draw(p, NinePatch::TopLeft, composition.sections[NinePatch::TopLeft], false);
+    patches.draw(p, NinePatch::TopRight, composition.sections[NinePatch::TopRight], false);
+    patches.draw(p, NinePatch::BottomLeft, composition.sections[NinePatch::BottomLeft], false);
+    patches.draw(p, NinePatch::BottomRight, composition.sections[NinePatch::BottomRight], false);
 
     // Sides
-    const int leftHeight = q->elementSize(prefix % QLatin1String("left")).height();
-    paintBorder(p, frame, FrameSvg::LeftBorder, QSize(frame->leftWidth, leftHeight) * q->devicePixelRatio(), contentRect);
-    paintBorder(p, frame, FrameSvg::RightBorder, QSize(frame->rightWidth, leftHeight) * q->devicePixelRatio(), contentRect);
+    patches.draw(p, NinePatch::Left, composition.sections[NinePatch::Left], !composition.stretchBorders);
+    patches.draw(p, NinePatch::Right, composition.sections[NinePatch::Right], !composition.stretchBorders);
+    patches.draw(p, NinePatch::Top, composition.sections[NinePatch::Top], !composition.stretchBorders);
+    patches.draw(p, NinePatch::Bottom, composition.sections[NinePatch::Bottom], !composition.stretchBorders);
+    p.end();
+
+    return image;
+}
+
+QVector<QImage> FrameSvgPrivate::composeFrames(const QVector<FrameComposition> &compositions)
+{
+    QVector<QImage> images(compositions.count());
+    QSemaphore done;
+    int running = 0;
+
+    // The workers only get the frames they can start right away: the pool is
+    // shared with the svg renders, waiting for those to be done would block
+    // the GUI thread, so whatever they can't take is composed right here
+    for (int i = 1; i < compositions.count(); ++i) {
+        if (!compositions.at(i).isValid()) {
+            continue;
+        }
+
+        FrameComposer *composer = new FrameComposer(compositions.at(i), images[i], done);
+        if (SvgRasterJob::pool()->tryStart(composer)) {
+            ++running;
+        } else {
+            delete composer;
+            images[i] = composeFrame(compositions.at(i));
+        }
+    }
+
+    if (!compositions.isEmpty() && compositions.first().isValid()) {
+        images[0] = composeFrame(compositions.first());
+    }
+
+    done.acquire(running);
+    return images;
+}
+
+void FrameSvgPrivate::installBackground(FrameData *frame, const QImage &image) const
+{
+    frame->cachedBackground = QPixmap::fromImage(image);
+    frame->cachedBackground.setDevicePixelRatio(q->devicePixelRatio());
+}
+
+NinePatch::Ptr FrameSvgPrivate::ninePatch(FrameData *frame)
+{
+    PixmapCacheKey key = PixmapCacheKey::frame(PixmapCacheKey::FramePatches, q->imagePath(), prefix, QSize(),
+                                               frame->enabledBorders, q->scaleFactor(), q->devicePixelRatio());
+    key.status = q->status();
+    key.colorGroup = q->colorGroup();
+
+    QHash<PixmapCacheKey, NinePatch::Ptr> &patches = s_ninePatches[q->theme()->d];
+    NinePatch::Ptr ninePatch = patches.value(key);
+    if (ninePatch) {
+        return ninePatch;
+    }
+
+    // Rasterized once at the sizes the frames are made of, whatever the size
+    // of the frame: the corners at the size of the borders, the sides and the
+    // center at the size of their elements, see renderStretchedPatches()
+    const qreal ratio = q->devicePixelRatio();
+    ninePatch = new NinePatch;
+
+    const QString centerElementId = prefix % QLatin1String("center");
+    ninePatch->setPatch(NinePatch::Center, renderPatch(centerElementId, q->elementSize(centerElementId) * ratio));
 
     const int topWidth = q->elementSize(prefix % QLatin1String("top")).width();
-    paintBorder(p, frame, FrameSvg::TopBorder, QSize(topWidth, frame->topHeight) * q->devicePixelRatio(), contentRect);
-    paintBorder(p, frame, FrameSvg::BottomBorder, QSize(topWidth, frame->bottomHeight) * q->devicePixelRatio(), contentRect);
+    const int leftHeight = q->elementSize(prefix % QLatin1String("left")).height();
+    ninePatch->setPatch(NinePatch::Top, renderPatch(frame, FrameSvg::TopBorder, QSize(topWidth, frame->topHeight) * ratio));
+    ninePatch->setPatch(NinePatch::Bottom, renderPatch(frame, FrameSvg::BottomBorder, QSize(topWidth, frame->bottomHeight) * ratio));
+    ninePatch->setPatch(NinePatch::Left, renderPatch(frame, FrameSvg::LeftBorder, QSize(frame->leftWidth, leftHeight) * ratio));
+    ninePatch->setPatch(NinePatch::Right, renderPatch(frame, FrameSvg::RightBorder, QSize(frame->rightWidth, leftHeight) * ratio));
+
+    ninePatch->setPatch(NinePatch::TopLeft, renderPatch(frame, FrameSvg::TopBorder|FrameSvg::LeftBorder,
+                                                        QSize(frame->leftWidth, frame->topHeight) * ratio));
+    ninePatch->setPatch(NinePatch::TopRight, renderPatch(frame, FrameSvg::TopBorder|FrameSvg::RightBorder,
+                                                         QSize(frame->rightWidth, frame->topHeight) * ratio));
+    ninePatch->setPatch(NinePatch::BottomLeft, renderPatch(frame, FrameSvg::BottomBorder|FrameSvg::LeftBorder,
+                                                           QSize(frame->leftWidth, frame->bottomHeight) * ratio));
+    ninePatch->setPatch(NinePatch::BottomRight, renderPatch(frame, FrameSvg::BottomBorder|FrameSvg::RightBorder,
+                                                            QSize(frame->rightWidth, frame->bottomHeight) * ratio));
+
+    patches.insert(key, ninePatch);
+    return ninePatch;
+}
+
+void FrameSvgPrivate::renderStretchedPatches(FrameData *frame, FrameComposition &composition) const
+{
+    // Scaled up, the shared patches would blur gradients and details that used
+    // to be painted from the svg at the size of the frame: the stretched ones
+    // bigger than their sections are rendered again for this frame only
+    NinePatch::Ptr stretched;
+    const auto renderStretched = [&](NinePatch::Part part, const QString &elementId) {
+        const QSize patchSize = composition.patches->patch(part).size();
+        const QSize sectionSize = composition.sections[part].size();
+        if (patchSize.isEmpty() || sectionSize.isEmpty() ||
+            (sectionSize.width() <= patchSize.width() && sectionSize.height() <= patchSize.height())) {
+            return;
+        }
+
+        if (!stretched) {
+            stretched = new NinePatch(*composition.patches);
+        }
+        stretched->setPatch(part, renderPatch(elementId, sectionSize));
+    };
+
+    if (!frame->tileCenter) {
+        renderStretched(NinePatch::Center, prefix % QLatin1String("center"));
+    }
+
+    if (frame->stretchBorders) {
+        const FrameSvg::EnabledBorders sides[] = {
+            FrameSvg::TopBorder,
+            FrameSvg::BottomBorder,
+            FrameSvg::LeftBorder,
+            FrameSvg::RightBorder
+        };
+        for (const FrameSvg::EnabledBorders &side : sides) {
+            renderStretched(ninePatchPart(side), prefix % FrameSvgHelpers::borderToElementId(side));
+        }
+    }
+
+    if (stretched) {
+        composition.patches = stretched;
+    }
+}
+
+QImage FrameSvgPrivate::renderPatch(FrameData *frame, FrameSvg::EnabledBorders borders, const QSize &size) const
+{
+    if (!(frame->enabledBorders & borders)) {
+        return QImage();
+    }
+
+    return renderPatch(prefix % FrameSvgHelpers::borderToElementId(borders), size);
+}
+
+QImage FrameSvgPrivate::renderPatch(const QString &elementId, const QSize &size) const
+{
+    if (size.isEmpty() || !q->hasElement(elementId)) {
+        return QImage();
+    }
+
+    QImage patch(size, QImage::Format_ARGB32_Premultiplied);
+    patch.fill(Qt::transparent);
+
+    QPainter p(&patch);
+    p.setCompositionMode(QPainter::CompositionMode_Source);
+    q->paint(&p, QRect(QPoint(0, 0), size), elementId);
     p.end();
 
-    frame->cachedBackground.setDevicePixelRatio(q->devicePixelRatio());
+    return patch;
 }
 
 QRect FrameSvgPrivate::contentGeometry(FrameData* frame, const QSize& size) const
@@ -860,78 +1173,47 @@ QRect FrameSvgPrivate::contentGeometry(FrameData* frame, const QSize& size) cons
     return contentRect;
 }
 
-void FrameSvgPrivate::paintCenter(QPainter& p, FrameData* frame, const QRect& contentRect, const QSize& fullSize)
-{
-    if (!contentRect.isEmpty()) {
-        const QString centerElementId = prefix % QLatin1String("center");
-        if (frame->tileCenter) {
-            QSize centerTileSize = q->elementSize(centerElementId);
-            QPixmap center(centerTileSize);
-            center.fill(Qt::transparent);
-
-            QPainter centerPainter(&center);
-            centerPainter.setCompositionMode(QPainter::CompositionMode_Source);
-            q->paint(&centerPainter, QRect(QPoint(0, 0), centerTileSize),centerElementId);
-
-            if (frame->composeOverBorder) {
-                p.drawTiledPixmap(QRect(QPoint(0, 0), fullSize), center);
-            } else {
-                p.drawTiledPixmap(FrameSvgHelpers::sectionRect(FrameSvg::NoBorder, contentRect, fullSize * q->devicePixelRatio()), center);
-            }
-        } else {
-            if (frame->composeOverBorder) {
-                q->paint(&p, QRect(QPoint(0, 0), fullSize),
-                         centerElementId);
-            } else {
-                q->paint(&p, FrameSvgHelpers::sectionRect(FrameSvg::NoBorder, contentRect, fullSize * q->devicePixelRatio()), centerElementId);
-            }
-        }
-    }
-
-    if (frame->composeOverBorder) {
-        p.setCompositionMode(QPainter::CompositionMode_DestinationIn);
-        p.drawPixmap(QRect(QPoint(0, 0), fullSize), alphaMask());
-        p.setCompositionMode(QPainter::CompositionMode_SourceOver);
-    }
-}
-
-void FrameSvgPrivate::paintBorder(QPainter& p, FrameData* frame, const FrameSvg::EnabledBorders borders, const QSize& size, const QRect& contentRect) const
+NinePatch::Part FrameSvgPrivate::ninePatchPart(FrameSvg::EnabledBorders borders)
 {
-    QString side = prefix % FrameSvgHelpers::borderToElementId(borders);
-    if (frame->enabledBorders & borders && q->hasElement(side) && !size.isEmpty()) {
-        if (frame->stretchBorders) {
-            q->paint(&p, FrameSvgHelpers::sectionRect(borders, contentRect, frame->frameSize * q->devicePixelRatio()), side);
-        } else {
-            QPixmap px(size);
-            px.fill(Qt::transparent);
-
-            QPainter sidePainter(&px);
-            sidePainter.setCompositionMode(QPainter::CompositionMode_Source);
-            q->paint(&sidePainter, QRect(QPoint(0, 0), size), side);
-
-            p.drawTiledPixmap(FrameSvgHelpers::sectionRect(borders, contentRect, frame->frameSize * q->devicePixelRatio()), px);
-        }
-    }
+    if (borders == FrameSvg::TopBorder) {
+        return NinePatch::Top;
+    } else if (borders == FrameSvg::BottomBorder) {
+        return NinePatch::Bottom;
+    } else if (borders == FrameSvg::LeftBorder) {
+        return NinePatch::Left;
+    } else if (borders == FrameSvg::RightBorder) {
+        return NinePatch::Right;
+    } else if (borders == (FrameSvg::TopBorder | FrameSvg::LeftBorder)) {
+        return NinePatch::TopLeft;
+    } else if (borders == (FrameSvg::TopBorder | FrameSvg::RightBorder)) {
+        return NinePatch::TopRight;
+    } else if (borders == (FrameSvg::BottomBorder | FrameSvg::LeftBorder)) {
+        return NinePatch::BottomLeft;
+    } else if (borders == (FrameSvg::BottomBorder | FrameSvg::RightBorder)) {
+        return NinePatch::BottomRight;
+    }
+
+    return NinePatch::Center;
 }
 
-void FrameSvgPrivate::paintCorner(QPainter& p, FrameData* frame, Plasma::FrameSvg::EnabledBorders border, const QRect& contentRect) const
+FrameData *FrameSvgPrivate::sharedFrame(ThemePrivate *theme, const PixmapCacheKey &key)
 {
-    QString corner = prefix % FrameSvgHelpers::borderToElementId(border);
-    if (frame->enabledBorders & border && q->hasElement(corner)) {
-        q->paint(&p, FrameSvgHelpers::sectionRect(border, contentRect, frame->frameSize * q->devicePixelRatio()), corner);
-    }
+    FrameData *frame = s_sharedFrames[theme].value(key);
+    CacheStatistics::self()->count(frame ? CacheStatistics::FrameShared : CacheStatistics::FrameNotShared);
+    return frame;
 }
 
-QString FrameSvgPrivate::cacheId(FrameData *frame, const QString &prefixToSave) const
+PixmapCacheKey FrameSvgPrivate::cacheId(FrameData *frame, const QString &prefixToSave) const
 {
     const QSize size = frameSize(frame).toSize();
-    const QLatin1Char s('_');
-    return QString::number(frame->enabledBorders) % s % QString::number(size.width()) % s % QString::number(size.height()) % s % QString::number(q->scaleFactor()) % s % QString::number(q->devicePixelRatio()) % s % prefixToSave % s % q->imagePath();
+    return PixmapCacheKey::frame(PixmapCacheKey::FrameBackground, q->imagePath(), prefixToSave, size,
+                                 frame->enabledBorders, q->scaleFactor(), q->devicePixelRatio());
 }
 
 void FrameSvgPrivate::cacheFrame(const QString &prefixToSave, const QPixmap &background, const QPixmap &overlay)
 {
-    if (!q->isUsingRenderingCache()) {
+    //intermediate sizes of a resize would only fill the cache
+    if (!q->isUsingRenderingCache() || q->Svg::d->resizing) {
         return;
     }
 
@@ -942,15 +1224,16 @@ void FrameSvgPrivate::cacheFrame(const QString &prefixToSave, const QPixmap &bac
         return;
     }
 
-    const QString id = cacheId(frame, prefixToSave);
+    const PixmapCacheKey id = cacheId(frame, prefixToSave);
 
-    //qCDebug(LOG_PLASMA)<<"Saving to cache frame"<<id;
+    //qCDebug(LOG_PLASMA)<<"Saving to cache frame"<<id.toString();
 
-    q->theme()->insertIntoCache(id, background, QString::number((qint64)q, 16) % prefixToSave);
+    const PixmapStore::ImageFlags flags = q->Svg::d->cacheFlags();
+    q->theme()->d->insertIntoCache(id, background, PixmapCacheOwner(q, id.element, PixmapCacheKey::FrameBackground), flags);
 
     if (!overlay.isNull()) {
         //insert overlay
-        q->theme()->insertIntoCache(QLatin1String("overlay_") % id, overlay, QString::number((qint64)q, 16) % prefixToSave % QLatin1String("overlay"));
+        q->theme()->d->insertIntoCache(id.withType(PixmapCacheKey::FrameOverlay), overlay, PixmapCacheOwner(q, id.element, PixmapCacheKey::FrameOverlay), flags);
     }
 }
 
@@ -960,101 +1243,155 @@ void FrameSvgPrivate::updateSizes() const
     FrameData *frame = frames[prefix];
     Q_ASSERT(frame);
 
-    QSize s = q->size();
-    q->resize();
+    FrameBackgroundCache::self()->remove(frame);
     frame->cachedBackground = QPixmap();
 
-    //This has the same size regardless the border is enabled or not
-    frame->fixedTopHeight = q->elementSize(prefix % QLatin1String("top")).height();
+    const FrameMetrics metrics = frameMetrics();
 
-    if (q->hasElement(prefix % QLatin1String("hint-top-margin"))) {
-        frame->fixedTopMargin = q->elementSize(prefix % QLatin1String("hint-top-margin")).height();
-    } else {
-        frame->fixedTopMargin = frame->fixedTopHeight;
-    }
+    //These have the same size regardless the border is enabled or not
+    frame->fixedTopHeight = metrics.topHeight;
+    frame->fixedTopMargin = metrics.topMargin;
+    frame->fixedLeftWidth = metrics.leftWidth;
+    frame->fixedLeftMargin = metrics.leftMargin;
+    frame->fixedRightWidth = metrics.rightWidth;
+    frame->fixedRightMargin = metrics.rightMargin;
+    frame->fixedBottomHeight = metrics.bottomHeight;
+    frame->fixedBottomMargin = metrics.bottomMargin;
 
-    //The same, but its size depends from the margin being enabled
+    //The same, but their size depends from the margin being enabled
     if (frame->enabledBorders & FrameSvg::TopBorder) {
-        frame->topHeight = q->elementSize(prefix % QLatin1String("top")).height();
-
-        if (q->hasElement(prefix % QLatin1String("hint-top-margin"))) {
-            frame->topMargin = q->elementSize(prefix % QLatin1String("hint-top-margin")).height();
-        } else {
-            frame->topMargin = frame->topHeight;
-        }
+        frame->topHeight = metrics.topHeight;
+        frame->topMargin = metrics.topMargin;
     } else {
         frame->topMargin = frame->topHeight = 0;
     }
 
-    frame->fixedLeftWidth = q->elementSize(prefix % QLatin1String("left")).width();
+    if (frame->enabledBorders & FrameSvg::LeftBorder) {
+        frame->leftWidth = metrics.leftWidth;
+        frame->leftMargin = metrics.leftMargin;
+    } else {
+        frame->leftMargin = frame->leftWidth = 0;
+    }
+
+    if (frame->enabledBorders & FrameSvg::RightBorder) {
+        frame->rightWidth = metrics.rightWidth;
+        frame->rightMargin = metrics.rightMargin;
+    } else {
+        frame->rightMargin = frame->rightWidth = 0;
+    }
 
-    if (q->hasElement(prefix % QLatin1String("hint-left-margin"))) {
-        frame->fixedLeftMargin = q->elementSize(prefix % QLatin1String("hint-left-margin")).width();
+    if (frame->enabledBorders & FrameSvg::BottomBorder) {
+        frame->bottomHeight = metrics.bottomHeight;
+        frame->bottomMargin = metrics.bottomMargin;
     } else {
-        frame->fixedLeftMargin = frame->fixedLeftWidth;
+        frame->bottomMargin = frame->bottomHeight = 0;
     }
 
-    if (frame->enabledBorders & FrameSvg::LeftBorder) {
-        frame->leftWidth = q->elementSize(prefix % QLatin1String("left")).width();
+    frame->composeOverBorder = metrics.hasHint(FrameMetrics::ComposeOverBorder);
+    frame->tileCenter = metrics.hasHint(FrameMetrics::TileCenter);
+    frame->noBorderPadding = metrics.hasHint(FrameMetrics::NoBorderPadding);
+    frame->stretchBorders = metrics.hasHint(FrameMetrics::StretchBorders);
+}
 
-        if (q->hasElement(prefix % QLatin1String("hint-left-margin"))) {
-            frame->leftMargin = q->elementSize(prefix % QLatin1String("hint-left-margin")).width();
-        } else {
-            frame->leftMargin = frame->leftWidth;
+FrameMetrics FrameSvgPrivate::frameMetrics() const
+{
+    ThemePrivate *theme = q->theme()->d;
+    const QString &path = q->Svg::d->path;
+    const qreal scaleFactor = q->scaleFactor();
+    const PixmapCacheKey key = PixmapCacheKey::frame(PixmapCacheKey::FrameBackground, path, prefix, QSize(), 0, scaleFactor, 0);
+
+    QHash<PixmapCacheKey, FrameMetrics> &metricsHash = s_frameMetrics[theme];
+    QHash<PixmapCacheKey, FrameMetrics>::const_iterator it = metricsHash.constFind(key);
+    if (it != metricsHash.constEnd()) {
+        return it.value();
+    }
+
+    FrameMetrics metrics;
+    const bool useIndex = !path.isEmpty() && theme->useCache();
+    if (!useIndex || !metrics.load(*theme->svgElementsCache, path, prefix, scaleFactor)) {
+        metrics = measureFrame();
+        if (useIndex) {
+            metrics.save(*theme->svgElementsCache, path, prefix, scaleFactor);
+            QMetaObject::invokeMethod(theme->rectSaveTimer, "start");
         }
-    } else {
-        frame->leftMargin = frame->leftWidth = 0;
     }
 
-    frame->fixedRightWidth = q->elementSize(prefix % QLatin1String("right")).width();
+    metricsHash.insert(key, metrics);
+    return metrics;
+}
 
-    if (q->hasElement(prefix % QLatin1String("hint-right-margin"))) {
-        frame->fixedRightMargin = q->elementSize(prefix % QLatin1String("hint-right-margin")).width();
+FrameMetrics FrameSvgPrivate::measureFrame() const
+{
+    FrameMetrics metrics;
+
+    QSize s = q->size();
+    q->resize();
+
+    metrics.topHeight = q->elementSize(prefix % QLatin1String("top")).height();
+    if (q->hasElement(prefix % QLatin1String("hint-top-margin"))) {
+        metrics.topMargin = q->elementSize(prefix % QLatin1String("hint-top-margin")).height();
     } else {
-        frame->fixedRightMargin = frame->fixedRightWidth;
+        metrics.topMargin = metrics.topHeight;
     }
 
-    if (frame->enabledBorders & FrameSvg::RightBorder) {
-        frame->rightWidth = q->elementSize(prefix % QLatin1String("right")).width();
-
-        if (q->hasElement(prefix % QLatin1String("hint-right-margin"))) {
-            frame->rightMargin = q->elementSize(prefix % QLatin1String("hint-right-margin")).width();
-        } else {
-            frame->rightMargin = frame->rightWidth;
-        }
+    metrics.leftWidth = q->elementSize(prefix % QLatin1String("left")).width();
+    if (q->hasElement(prefix % QLatin1String("hint-left-margin"))) {
+        metrics.leftMargin = q->elementSize(prefix % QLatin1String("hint-left-margin")).width();
     } else {
-        frame->rightMargin = frame->rightWidth = 0;
+        metrics.leftMargin = metrics.leftWidth;
     }
 
-    frame->fixedBottomHeight = q->elementSize(prefix % QLatin1String("bottom")).height();
+    metrics.rightWidth = q->elementSize(prefix % QLatin1String("right")).width();
+    if (q->hasElement(prefix % QLatin1String("hint-right-margin"))) {
+        metrics.rightMargin = q->elementSize(prefix % QLatin1String("hint-right-margin")).width();
+    } else {
+        metrics.rightMargin = metrics.rightWidth;
+    }
 
+    metrics.bottomHeight = q->elementSize(prefix % QLatin1String("bottom")).height();
     if (q->hasElement(prefix % QLatin1String("hint-bottom-margin"))) {
-        frame->fixedBottomMargin = q->elementSize(prefix % QLatin1String("hint-bottom-margin")).height();
+        metrics.bottomMargin = q->elementSize(prefix % QLatin1String("hint-bottom-margin")).height();
     } else {
-        frame->fixedBottomMargin = frame->fixedBottomHeight;
+        metrics.bottomMargin = metrics.bottomHeight;
     }
 
-    if (frame->enabledBorders & FrameSvg::BottomBorder) {
-        frame->bottomHeight = q->elementSize(prefix % QLatin1String("bottom")).height();
+    if (q->hasElement(prefix % QLatin1String("hint-compose-over-border")) &&
+        q->hasElement(QLatin1String("mask-") % prefix % QLatin1String("center"))) {
+        metrics.hints |= FrameMetrics::ComposeOverBorder;
+    }
 
-        if (q->hasElement(prefix % QLatin1String("hint-bottom-margin"))) {
-            frame->bottomMargin = q->elementSize(prefix % QLatin1String("hint-bottom-margin")).height();
-        } else {
-            frame->bottomMargin = frame->bottomHeight;
-        }
-    } else {
-        frame->bottomMargin = frame->bottomHeight = 0;
+    //the ones that don't have a prefix is for retrocompatibility
+    if (q->hasElement(QStringLiteral("hint-tile-center")) || q->hasElement(prefix % QLatin1String("hint-tile-center"))) {
+        metrics.hints |= FrameMetrics::TileCenter;
+    }
+    if (q->hasElement(QStringLiteral("hint-no-border-padding")) || q->hasElement(prefix % QLatin1String("hint-no-border-padding"))) {
+        metrics.hints |= FrameMetrics::NoBorderPadding;
+    }
+    if (q->hasElement(QStringLiteral("hint-stretch-borders")) || q->hasElement(prefix % QLatin1String("hint-stretch-borders"))) {
+        metrics.hints |= FrameMetrics::StretchBorders;
     }
 
-    frame->composeOverBorder = (q->hasElement(prefix % QLatin1String("hint-compose-over-border")) &&
-                                q->hasElement(QLatin1String("mask-") % prefix % QLatin1String("center")));
+    if (!prefix.startsWith(QLatin1String("mask-")) && q->hasElement(prefix % QLatin1String("overlay"))) {
+        metrics.hints |= FrameMetrics::Overlay;
+        if (q->hasElement(prefix % QLatin1String("hint-overlay-tile-horizontal"))) {
+            metrics.hints |= FrameMetrics::OverlayTileHorizontal;
+        }
+        if (q->hasElement(prefix % QLatin1String("hint-overlay-tile-vertical"))) {
+            metrics.hints |= FrameMetrics::OverlayTileVertical;
+        }
+        if (q->hasElement(prefix % QLatin1String("hint-overlay-stretch"))) {
+            metrics.hints |= FrameMetrics::OverlayStretch;
+        }
+        if (q->hasElement(prefix % QLatin1String("hint-overlay-pos-right"))) {
+            metrics.hints |= FrameMetrics::OverlayPosRight;
+        }
+        if (q->hasElement(prefix % QLatin1String("hint-overlay-pos-bottom"))) {
+            metrics.hints |= FrameMetrics::OverlayPosBottom;
+        }
+    }
 
-    //since it's rectangular, topWidth and bottomWidth must be the same
-    //the ones that don't have a prefix is for retrocompatibility
-    frame->tileCenter = (q->hasElement(QStringLiteral("hint-tile-center")) || q->hasElement(prefix % QLatin1String("hint-tile-center")));
-    frame->noBorderPadding = (q->hasElement(QStringLiteral("hint-no-border-padding")) || q->hasElement(prefix % QLatin1String("hint-no-border-padding")));
-    frame->stretchBorders = (q->hasElement(QStringLiteral("hint-stretch-borders")) || q->hasElement(prefix % QLatin1String("hint-stretch-borders")));
     q->resize(s);
+    return metrics;
 }
 
 void FrameSvgPrivate::updateNeeded()
@@ -295,6 +295,7 @@ public:
 private:
     FrameSvgPrivate *const d;
     friend class FrameData;
+    friend class FrameSvgPrivate;
 
     Q_PRIVATE_SLOT(d, void updateSizes())
     Q_PRIVATE_SLOT(d, void updateNeeded())
@@ -0,0 +1,138 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "alpharegion_p.h"
+
+#include <QVector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PLASMA_ALPHAREGION_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PLASMA_ALPHAREGION_NEON
+#include <arm_neon.h>
+#endif
+
+namespace Plasma
+{
+
+static inline bool isOpaque(quint32 pixel)
+{
+    return pixel & 0xff000000;
+}
+
+int AlphaRegion::findRunEnd(const quint32 *pixels, int from, int count, bool opaque)
+{
+    int i = from;
+
+#ifdef PLASMA_ALPHAREGION_SSE2
+    // skip 4 pixels at a time while all of them are in the run
+    const __m128i alphaMask = _mm_set1_epi32(0xff000000);
+    const __m128i zero = _mm_setzero_si128();
+    const int runMask = opaque ? 0 : 0xffff;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i pixel = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels + i));
+        const __m128i transparent = _mm_cmpeq_epi32(_mm_and_si128(pixel, alphaMask), zero);
+        if (_mm_movemask_epi8(transparent) != runMask) {
+            break;
+        }
+    }
+#endif
+#ifdef PLASMA_ALPHAREGION_NEON
+    const uint32x4_t alphaMask = vdupq_n_u32(0xff000000);
+    for (; i + 4 <= count; i += 4) {
+        const uint32x4_t alpha = vandq_u32(vld1q_u32(pixels + i), alphaMask);
+        // lanes of the run are all ones
+        const uint32x4_t inRun = opaque ? vtstq_u32(alpha, alpha) : vceqq_u32(alpha, vdupq_n_u32(0));
+        const uint32x2_t folded = vand_u32(vget_low_u32(inRun), vget_high_u32(inRun));
+        if ((vget_lane_u32(folded, 0) & vget_lane_u32(folded, 1)) != 0xffffffff) {
+            break;
+        }
+    }
+#endif
+
+    for (; i < count; ++i) {
+        if (isOpaque(pixels[i]) != opaque) {
+            break;
+        }
+    }
+
+    return i;
+}
+
+QRegion AlphaRegion::fromImage(const QImage &image)
+{
+    if (image.isNull()) {
+        return QRegion();
+    }
+
+    QImage argb = image;
+    if (argb.format() != QImage::Format_ARGB32_Premultiplied && argb.format() != QImage::Format_ARGB32) {
+        argb = argb.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    }
+
+    const int width = argb.width();
+    const int height = argb.height();
+
+    // bands of rows with the same runs, sorted and never abutting as QRegion::setRects() wants them
+    QVector<QRect> rects;
+    QVector<QRect> row;
+    int bandStart = 0;
+
+    for (int y = 0; y < height; ++y) {
+        const quint32 *line = reinterpret_cast<const quint32 *>(argb.constScanLine(y));
+
+        row.clear();
+        int x = findRunEnd(line, 0, width, false);
+        while (x < width) {
+            const int end = findRunEnd(line, x, width, true);
+            row.append(QRect(x, y, end - x, 1));
+            x = findRunEnd(line, end, width, false);
+        }
+
+        // the same runs as the band above: make it taller
+        const int bandCount = rects.count() - bandStart;
+        bool sameRuns = bandCount == row.count() && bandCount > 0 &&
+                        rects.at(bandStart).bottom() == y - 1;
+        for (int i = 0; sameRuns && i < bandCount; ++i) {
+            const QRect &above = rects.at(bandStart + i);
+            sameRuns = above.left() == row.at(i).left() && above.right() == row.at(i).right();
+        }
+
+        if (sameRuns) {
+            for (int i = bandStart; i < rects.count(); ++i) {
+                rects[i].setBottom(y);
+            }
+        } else if (!row.isEmpty()) {
+            bandStart = rects.count();
+            rects += row;
+        }
+    }
+
+    QRegion region;
+    if (!rects.isEmpty()) {
+        region.setRects(rects.constData(), rects.count());
+    }
+
+    return region;
+}
+
+}
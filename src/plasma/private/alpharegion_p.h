@@ -0,0 +1,57 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PLASMA_ALPHAREGION_P_H
+#define PLASMA_ALPHAREGION_P_H
+
+#include <QImage>
+#include <QRegion>
+
+namespace Plasma
+{
+
+/**
+ * Builds the region of the pixels of an image that are not fully transparent,
+ * the same QRegion(QBitmap(pixmap.alphaChannel().createMaskFromColor(Qt::black)))
+ * gives, straight from the 32 bit rows.
+ *
+ * Every row is split in runs of transparent and non transparent pixels,
+ * looking at a few pixels at a time with SSE2 or NEON when available, and
+ * consecutive rows with the same runs are merged in a single band, so the
+ * region is built in one go without any union.
+ */
+class AlphaRegion
+{
+public:
+    /**
+     * @returns the region of the pixels of @p image with a non zero alpha,
+     * in pixels of the image, whatever its device pixel ratio
+     */
+    static QRegion fromImage(const QImage &image);
+
+    /**
+     * @returns the index of the first pixel from @p from whose alpha is zero
+     * if @p opaque is true, non zero otherwise, or @p count if there's none
+     */
+    static int findRunEnd(const quint32 *pixels, int from, int count, bool opaque);
+};
+
+}
+
+#endif
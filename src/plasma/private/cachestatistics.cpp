@@ -0,0 +1,102 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "cachestatistics_p.h"
+
+#include <QMutexLocker>
+
+namespace Plasma
+{
+
+Q_GLOBAL_STATIC(CacheStatistics, s_cacheStatistics)
+
+static const char *const s_counterNames[CacheStatistics::CounterCount] = {
+    "pixmapCacheHits",
+    "pixmapCacheMisses",
+    "pendingPixmapHits",
+    "rectsCacheHits",
+    "rectsCacheMisses",
+    "renderersReused",
+    "renderersCreated",
+    "framesShared",
+    "framesNotShared",
+    "framesEvicted"
+};
+
+CacheStatistics::CacheStatistics()
+{
+}
+
+CacheStatistics *CacheStatistics::self()
+{
+    return s_cacheStatistics();
+}
+
+void CacheStatistics::count(Counter counter)
+{
+    m_counters[counter].ref();
+}
+
+int CacheStatistics::value(Counter counter) const
+{
+    return m_counters[counter].load();
+}
+
+void CacheStatistics::addRenderTime(const QString &path, qint64 nsecs)
+{
+    QMutexLocker lock(&m_renderTimesMutex);
+
+    RenderTimes &times = m_renderTimes[path];
+    if (times.isEmpty()) {
+        times.fill(0, RenderTimeBuckets);
+    }
+    ++times[bucket(nsecs)];
+}
+
+QHash<QString, CacheStatistics::RenderTimes> CacheStatistics::renderTimes() const
+{
+    QMutexLocker lock(&m_renderTimesMutex);
+    return m_renderTimes;
+}
+
+void CacheStatistics::reset()
+{
+    for (int i = 0; i < CounterCount; ++i) {
+        m_counters[i].store(0);
+    }
+
+    QMutexLocker lock(&m_renderTimesMutex);
+    m_renderTimes.clear();
+}
+
+QString CacheStatistics::counterName(Counter counter)
+{
+    return QLatin1String(s_counterNames[counter]);
+}
+
+int CacheStatistics::bucket(qint64 nsecs)
+{
+    int bucket = 0;
+    for (qint64 limit = 1000000; nsecs >= limit && bucket < RenderTimeBuckets - 1; limit *= 2) {
+        ++bucket;
+    }
+    return bucket;
+}
+
+}
@@ -0,0 +1,97 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PLASMA_CACHESTATISTICS_P_H
+#define PLASMA_CACHESTATISTICS_P_H
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+namespace Plasma
+{
+
+/**
+ * Process wide counters of how well the caches used to render the theme
+ * work, and of the time spent rendering the images they missed.
+ *
+ * Always compiled in: counting is an atomic increment, and render times
+ * are only taken when an image actually gets rendered. Thread safe.
+ */
+class CacheStatistics
+{
+public:
+    enum Counter {
+        PixmapCacheHit = 0,
+        PixmapCacheMiss,
+        //found among the pixmaps waiting to be written to the cache
+        PendingPixmapHit,
+        RectsCacheHit,
+        RectsCacheMiss,
+        RendererReused,
+        RendererCreated,
+        FrameShared,
+        FrameNotShared,
+        //rendered frames dropped to stay within the budget
+        FrameEvicted,
+        CounterCount
+    };
+
+    /**
+     * Render times are counted in buckets: under 1ms, under 2ms, under 4ms...
+     * up to under 128ms, and the last one for anything longer
+     */
+    enum {
+        RenderTimeBuckets = 9
+    };
+    typedef QVector<int> RenderTimes;
+
+    CacheStatistics();
+
+    static CacheStatistics *self();
+
+    void count(Counter counter);
+    int value(Counter counter) const;
+
+    void addRenderTime(const QString &path, qint64 nsecs);
+    /**
+     * @returns for every image rendered, the number of renders in each bucket
+     */
+    QHash<QString, RenderTimes> renderTimes() const;
+
+    void reset();
+
+    /**
+     * The key of the counter in Theme::cacheStatistics(), e.g. "pixmapCacheHits"
+     */
+    static QString counterName(Counter counter);
+
+    static int bucket(qint64 nsecs);
+
+private:
+    QAtomicInt m_counters[CounterCount];
+    mutable QMutex m_renderTimesMutex;
+    QHash<QString, RenderTimes> m_renderTimes;
+};
+
+}
+
+#endif
@@ -0,0 +1,128 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "framebackgroundcache_p.h"
+
+#include "cachestatistics_p.h"
+#include "framesvg_p.h"
+#include "libplasma-theme-global.h"
+
+namespace Plasma
+{
+
+Q_GLOBAL_STATIC(FrameBackgroundCache, s_frameBackgroundCache)
+
+static qint64 backgroundSize(const FrameData *frame)
+{
+    const QPixmap &background = frame->cachedBackground;
+    return qint64(background.width()) * background.height() * background.depth() / 8;
+}
+
+FrameBackgroundCache::FrameBackgroundCache()
+    : m_size(0)
+{
+    ThemeConfig config;
+    m_budget = qint64(config.frameCacheKb()) * 1024;
+}
+
+FrameBackgroundCache *FrameBackgroundCache::self()
+{
+    return s_frameBackgroundCache();
+}
+
+void FrameBackgroundCache::touch(FrameData *frame)
+{
+    const qint64 bytes = backgroundSize(frame);
+
+    QHash<FrameData *, QLinkedList<Entry>::iterator>::iterator it = m_index.find(frame);
+    if (it != m_index.end()) {
+        m_size -= it.value()->bytes;
+        m_entries.erase(it.value());
+        if (bytes == 0) {
+            m_index.erase(it);
+            return;
+        }
+    } else if (bytes == 0) {
+        return;
+    }
+
+    const Entry entry = {frame, bytes};
+    m_index.insert(frame, m_entries.insert(m_entries.end(), entry));
+    m_size += bytes;
+
+    evict(m_budget, frame);
+}
+
+void FrameBackgroundCache::remove(FrameData *frame)
+{
+    QHash<FrameData *, QLinkedList<Entry>::iterator>::iterator it = m_index.find(frame);
+    if (it == m_index.end()) {
+        return;
+    }
+
+    m_size -= it.value()->bytes;
+    m_entries.erase(it.value());
+    m_index.erase(it);
+}
+
+void FrameBackgroundCache::trim(qint64 bytes)
+{
+    evict(bytes, 0);
+}
+
+void FrameBackgroundCache::evict(qint64 bytes, const FrameData *keep)
+{
+    QLinkedList<Entry>::iterator it = m_entries.begin();
+    while (m_size > bytes && it != m_entries.end()) {
+        FrameData *frame = it->frame;
+        if (frame == keep) {
+            ++it;
+            continue;
+        }
+
+        m_size -= it->bytes;
+        m_index.remove(frame);
+        it = m_entries.erase(it);
+        frame->cachedBackground = QPixmap();
+        CacheStatistics::self()->count(CacheStatistics::FrameEvicted);
+    }
+}
+
+int FrameBackgroundCache::count() const
+{
+    return m_entries.count();
+}
+
+qint64 FrameBackgroundCache::size() const
+{
+    return m_size;
+}
+
+qint64 FrameBackgroundCache::budget() const
+{
+    return m_budget;
+}
+
+void FrameBackgroundCache::setBudget(qint64 bytes)
+{
+    m_budget = bytes;
+    evict(m_budget, 0);
+}
+
+}
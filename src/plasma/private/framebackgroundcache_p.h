@@ -0,0 +1,95 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PLASMA_FRAMEBACKGROUNDCACHE_P_H
+#define PLASMA_FRAMEBACKGROUNDCACHE_P_H
+
+#include <QHash>
+#include <QLinkedList>
+
+namespace Plasma
+{
+
+class FrameData;
+
+/**
+ * The byte budget of the backgrounds rendered by the FrameSvgs of the
+ * process, shared frames and mask frames included.
+ *
+ * When the backgrounds go over the budget, the least recently drawn ones
+ * are dropped: their FrameData, measures and margins are kept, and the
+ * background is generated again, usually from the pixmap cache of the
+ * theme, the next time it's drawn.
+ *
+ * Only to be used from the GUI thread.
+ */
+class FrameBackgroundCache
+{
+public:
+    FrameBackgroundCache();
+
+    static FrameBackgroundCache *self();
+
+    /**
+     * The background of @p frame has been generated or drawn: it becomes the
+     * most recently used one, and the least recently used ones are dropped
+     * if needed. The background of @p frame itself is never dropped here.
+     */
+    void touch(FrameData *frame);
+
+    /**
+     * Forgets @p frame, whose background is about to be deleted or reset
+     */
+    void remove(FrameData *frame);
+
+    /**
+     * Drops the least recently used backgrounds until they take at most
+     * @p bytes, all of them for 0, whether their frames are being drawn
+     * or not. Meant for when memory is short.
+     */
+    void trim(qint64 bytes = 0);
+
+    int count() const;
+
+    /**
+     * Memory used by all the backgrounds, in bytes
+     */
+    qint64 size() const;
+
+    qint64 budget() const;
+    void setBudget(qint64 bytes);
+
+private:
+    void evict(qint64 bytes, const FrameData *keep);
+
+    struct Entry {
+        FrameData *frame;
+        qint64 bytes;
+    };
+
+    //least recently used first, the iterators stay valid when other entries are removed
+    QLinkedList<Entry> m_entries;
+    QHash<FrameData *, QLinkedList<Entry>::iterator> m_index;
+    qint64 m_size;
+    qint64 m_budget;
+};
+
+}
+
+#endif
@@ -0,0 +1,82 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "framemetrics_p.h"
+
+#include <QRectF>
+#include <QStringBuilder>
+
+#include "svgelementsindex_p.h"
+
+namespace Plasma
+{
+
+FrameMetrics::FrameMetrics()
+    : topHeight(0),
+      leftWidth(0),
+      rightWidth(0),
+      bottomHeight(0),
+      topMargin(0),
+      leftMargin(0),
+      rightMargin(0),
+      bottomMargin(0),
+      hints(NoHints)
+{
+}
+
+QString FrameMetrics::key(const QString &prefix, qreal scaleFactor, const char *entry)
+{
+    return QLatin1String("_Frame_") % prefix % QLatin1Char('_') % QString::number(scaleFactor) %
+           QLatin1Char('_') % QLatin1String(entry);
+}
+
+// Stored as rects, one value per coordinate
+bool FrameMetrics::load(const SvgElementsIndex &index, const QString &image, const QString &prefix, qreal scaleFactor)
+{
+    QRectF sizes;
+    QRectF margins;
+    QRectF flags;
+    if (!index.findRect(image, key(prefix, scaleFactor, "sizes"), sizes) ||
+        !index.findRect(image, key(prefix, scaleFactor, "margins"), margins) ||
+        !index.findRect(image, key(prefix, scaleFactor, "hints"), flags)) {
+        return false;
+    }
+
+    topHeight = qRound(sizes.x());
+    leftWidth = qRound(sizes.y());
+    rightWidth = qRound(sizes.width());
+    bottomHeight = qRound(sizes.height());
+
+    topMargin = qRound(margins.x());
+    leftMargin = qRound(margins.y());
+    rightMargin = qRound(margins.width());
+    bottomMargin = qRound(margins.height());
+
+    hints = qRound(flags.x());
+    return true;
+}
+
+void FrameMetrics::save(SvgElementsIndex &index, const QString &image, const QString &prefix, qreal scaleFactor) const
+{
+    index.insertRect(image, key(prefix, scaleFactor, "sizes"), QRectF(topHeight, leftWidth, rightWidth, bottomHeight));
+    index.insertRect(image, key(prefix, scaleFactor, "margins"), QRectF(topMargin, leftMargin, rightMargin, bottomMargin));
+    index.insertRect(image, key(prefix, scaleFactor, "hints"), QRectF(hints, 0, 0, 0));
+}
+
+}
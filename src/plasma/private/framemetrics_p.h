@@ -0,0 +1,89 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PLASMA_FRAMEMETRICS_P_H
+#define PLASMA_FRAMEMETRICS_P_H
+
+#include <QString>
+
+namespace Plasma
+{
+
+class SvgElementsIndex;
+
+/**
+ * What FrameSvg needs to know about a prefix of an image to lay out its
+ * frames: the sizes of the borders, the margins and the hints, whatever
+ * borders are enabled.
+ *
+ * Measured once per theme and kept in the svg elements index, as a few
+ * entries of the image under the keys _Frame_<prefix>_<scale factor>_*.
+ */
+class FrameMetrics
+{
+public:
+    enum Hint {
+        NoHints = 0,
+        TileCenter = 1,
+        StretchBorders = 2,
+        NoBorderPadding = 4,
+        ComposeOverBorder = 8,
+        Overlay = 16,
+        OverlayTileHorizontal = 32,
+        OverlayTileVertical = 64,
+        OverlayStretch = 128,
+        OverlayPosRight = 256,
+        OverlayPosBottom = 512
+    };
+
+    FrameMetrics();
+
+    bool hasHint(Hint hint) const
+    {
+        return hints & hint;
+    }
+
+    /**
+     * Fills the metrics from what @p index knows about @p prefix of @p image
+     * @returns false if they have never been saved
+     */
+    bool load(const SvgElementsIndex &index, const QString &image, const QString &prefix, qreal scaleFactor);
+    void save(SvgElementsIndex &index, const QString &image, const QString &prefix, qreal scaleFactor) const;
+
+    //sizes of the borders
+    int topHeight;
+    int leftWidth;
+    int rightWidth;
+    int bottomHeight;
+
+    //margins, equal to the sizes unless hinted otherwise
+    int topMargin;
+    int leftMargin;
+    int rightMargin;
+    int bottomMargin;
+
+    int hints;
+
+private:
+    static QString key(const QString &prefix, qreal scaleFactor, const char *entry);
+};
+
+}
+
+#endif
@@ -22,13 +22,19 @@
 #define PLASMA_FRAMESVG_P_H
 
 #include <QHash>
-#include <QCache>
+#include <QImage>
+#include <QRect>
 #include <QStringBuilder>
+#include <QVector>
 
 #include <QDebug>
 
 #include <Plasma/Theme>
 
+#include "framemetrics_p.h"
+#include "ninepatch_p.h"
+#include "pixmapcachekey_p.h"
+
 namespace Plasma
 {
 
@@ -59,7 +65,6 @@ public:
     FrameData(const FrameData &other, FrameSvg *svg)
         : prefix(other.prefix),
           enabledBorders(other.enabledBorders),
-          cachedMasks(MAX_CACHED_MASKS),
           frameSize(other.frameSize),
           topHeight(0),
           leftWidth(0),
@@ -90,8 +95,6 @@ public:
     QString prefix;
     FrameSvg::EnabledBorders enabledBorders;
     QPixmap cachedBackground;
-    QCache<QString, QRegion> cachedMasks;
-    static const int MAX_CACHED_MASKS = 10;
 
     QSize frameSize;
 
@@ -132,6 +135,54 @@ public:
     Plasma::ThemePrivate *theme;
 };
 
+/**
+ * What it takes to compose the background of a frame out of its nine patches,
+ * gathered in the GUI thread so the composition itself can run in any thread
+ */
+struct FrameComposition
+{
+    FrameComposition()
+        : tileCenter(false),
+          stretchBorders(false),
+          composeOverBorder(false)
+    {
+    }
+
+    bool isValid() const
+    {
+        return patches;
+    }
+
+    NinePatch::Ptr patches;
+    //in device pixels
+    QSize size;
+    QRect sections[NinePatch::PartCount];
+    //the alpha mask the center is cut with when composed over the borders
+    QImage mask;
+    bool tileCenter : 1;
+    bool stretchBorders : 1;
+    bool composeOverBorder : 1;
+};
+
+/**
+ * A background being generated: what was found in the cache
+ * when it was started
+ */
+struct PendingBackground
+{
+    PendingBackground()
+        : frame(0),
+          frameCached(false),
+          overlayCached(false)
+    {
+    }
+
+    FrameData *frame;
+    bool frameCached;
+    bool overlayCached;
+    QPixmap overlay;
+};
+
 class FrameSvgPrivate
 {
 public:
@@ -147,16 +198,59 @@ public:
     QPixmap alphaMask();
 
     void generateBackground(FrameData *frame);
+    /**
+     * Generates the backgrounds of all the frames of @p svgs at once, the
+     * same as framePixmap() called on each of them in turn would, except
+     * that the frames are composed in parallel in the worker threads.
+     */
+    static void generateBackgrounds(const QList<FrameSvg *> &svgs);
+    /**
+     * Looks @p frame up in the cache.
+     * @returns false if there's nothing to generate
+     */
+    bool beginBackground(FrameData *frame, PendingBackground &pending);
+    /**
+     * Adds the overlay and caches the background of a frame whose background
+     * has been found in the cache or composed
+     */
+    void finishBackground(PendingBackground &pending);
     void generateFrameBackground(FrameData *frame);
-    QString cacheId(FrameData *frame, const QString &prefixToUse) const;
+    /**
+     * @returns false if no background can be composed for @p frame
+     */
+    bool prepareComposition(FrameData *frame, FrameComposition &composition);
+    /**
+     * Gives @p composition its own patches, rendered at the size of their
+     * sections, for the stretched parts the shared ones would be scaled up for
+     */
+    void renderStretchedPatches(FrameData *frame, FrameComposition &composition) const;
+    /**
+     * Thread safe
+     */
+    static QImage composeFrame(const FrameComposition &composition);
+    static QVector<QImage> composeFrames(const QVector<FrameComposition> &compositions);
+    void installBackground(FrameData *frame, const QImage &image) const;
+    PixmapCacheKey cacheId(FrameData *frame, const QString &prefixToUse) const;
     void cacheFrame(const QString &prefixToSave, const QPixmap &background, const QPixmap &overlay);
     void updateSizes() const;
+    /**
+     * @returns the metrics of the current prefix, measured once per theme
+     * and kept in the svg elements index
+     */
+    FrameMetrics frameMetrics() const;
+    FrameMetrics measureFrame() const;
     void updateNeeded();
     void updateAndSignalSizes();
     QSizeF frameSize(FrameData *frame) const;
-    void paintBorder(QPainter& p, FrameData* frame, Plasma::FrameSvg::EnabledBorders border, const QSize& originalSize, const QRect& output) const;
-    void paintCorner(QPainter& p, FrameData* frame, Plasma::FrameSvg::EnabledBorders border, const QRect& output) const;
-    void paintCenter(QPainter& p, FrameData* frame, const QRect& contentRect, const QSize& fullSize);
+    /**
+     * @returns the patches @p frame is composed of, rasterized the first time
+     * a frame of the same prefix, borders, status, color group and device
+     * pixel ratio is generated
+     */
+    NinePatch::Ptr ninePatch(FrameData *frame);
+    QImage renderPatch(FrameData *frame, Plasma::FrameSvg::EnabledBorders borders, const QSize &size) const;
+    QImage renderPatch(const QString &elementId, const QSize &size) const;
+    static NinePatch::Part ninePatchPart(Plasma::FrameSvg::EnabledBorders borders);
     QRect contentGeometry(FrameData* frame, const QSize& size) const;
 
     Types::Location location;
@@ -172,7 +266,15 @@ public:
 
     QHash<QString, FrameData *> frames;
 
-    static QHash<ThemePrivate *, QHash<QString, FrameData *> > s_sharedFrames;
+    /**
+     * @returns the frame of @p theme shared under @p key, or null
+     */
+    static FrameData *sharedFrame(ThemePrivate *theme, const PixmapCacheKey &key);
+
+    static QHash<ThemePrivate *, QHash<PixmapCacheKey, FrameData *> > s_sharedFrames;
+    //dropped by the theme whenever it discards its rendered pixmaps
+    static QHash<ThemePrivate *, QHash<PixmapCacheKey, NinePatch::Ptr> > s_ninePatches;
+    static QHash<ThemePrivate *, QHash<PixmapCacheKey, FrameMetrics> > s_frameMetrics;
 };
 
 }
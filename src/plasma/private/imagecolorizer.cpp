@@ -0,0 +1,207 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "imagecolorizer_p.h"
+
+#include <kiconeffect.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PLASMA_COLORIZE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__) || (defined(PLASMA_COLORIZE_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)))
+#define PLASMA_COLORIZE_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PLASMA_COLORIZE_NEON
+#include <arm_neon.h>
+#endif
+
+namespace Plasma
+{
+
+// qGray() of the pixel
+static inline quint32 grayLevel(quint32 pixel)
+{
+    return (((pixel >> 16) & 0xff) * 11 + ((pixel >> 8) & 0xff) * 16 + (pixel & 0xff) * 5) >> 5;
+}
+
+#ifdef PLASMA_COLORIZE_SSE2
+static int colorizeSse2(quint32 *pixels, int count, const quint32 *table)
+{
+    const __m128i byteMask = _mm_set1_epi32(0x00ff00ff);
+    const __m128i alphaMask = _mm_set1_epi32(0xff000000);
+    // 16 bit lanes: blue and red, green and alpha
+    const __m128i blueRedWeights = _mm_set1_epi32((11 << 16) | 5);
+    const __m128i greenAlphaWeights = _mm_set1_epi32(16);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i pixel = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels + i));
+        const __m128i blueRed = _mm_and_si128(pixel, byteMask);
+        const __m128i greenAlpha = _mm_and_si128(_mm_srli_epi32(pixel, 8), byteMask);
+        const __m128i gray = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(blueRed, blueRedWeights),
+                                                          _mm_madd_epi16(greenAlpha, greenAlphaWeights)), 5);
+
+        const __m128i colors = _mm_set_epi32(table[_mm_cvtsi128_si32(_mm_srli_si128(gray, 12))],
+                                             table[_mm_cvtsi128_si32(_mm_srli_si128(gray, 8))],
+                                             table[_mm_cvtsi128_si32(_mm_srli_si128(gray, 4))],
+                                             table[_mm_cvtsi128_si32(gray)]);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(pixels + i),
+                         _mm_or_si128(_mm_and_si128(pixel, alphaMask), colors));
+    }
+
+    return i;
+}
+#endif
+
+#ifdef PLASMA_COLORIZE_AVX2
+#ifndef __AVX2__
+__attribute__((target("avx2")))
+#endif
+static int colorizeAvx2(quint32 *pixels, int count, const quint32 *table)
+{
+    const __m256i byteMask = _mm256_set1_epi32(0x00ff00ff);
+    const __m256i alphaMask = _mm256_set1_epi32(0xff000000);
+    const __m256i blueRedWeights = _mm256_set1_epi32((11 << 16) | 5);
+    const __m256i greenAlphaWeights = _mm256_set1_epi32(16);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i pixel = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pixels + i));
+        const __m256i blueRed = _mm256_and_si256(pixel, byteMask);
+        const __m256i greenAlpha = _mm256_and_si256(_mm256_srli_epi32(pixel, 8), byteMask);
+        const __m256i gray = _mm256_srli_epi32(_mm256_add_epi32(_mm256_madd_epi16(blueRed, blueRedWeights),
+                                                                _mm256_madd_epi16(greenAlpha, greenAlphaWeights)), 5);
+
+        const __m256i colors = _mm256_i32gather_epi32(reinterpret_cast<const int *>(table), gray, 4);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(pixels + i),
+                            _mm256_or_si256(_mm256_and_si256(pixel, alphaMask), colors));
+    }
+
+    return i;
+}
+
+static bool hasAvx2()
+{
+#ifdef __AVX2__
+    return true;
+#else
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+#endif
+}
+#endif
+
+#ifdef PLASMA_COLORIZE_NEON
+static int colorizeNeon(quint32 *pixels, int count, const quint32 *table)
+{
+    const uint32x4_t byteMask = vdupq_n_u32(0xff);
+    const uint32x4_t alphaMask = vdupq_n_u32(0xff000000);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const uint32x4_t pixel = vld1q_u32(pixels + i);
+        uint32x4_t gray = vmulq_n_u32(vandq_u32(vshrq_n_u32(pixel, 16), byteMask), 11);
+        gray = vmlaq_n_u32(gray, vandq_u32(vshrq_n_u32(pixel, 8), byteMask), 16);
+        gray = vmlaq_n_u32(gray, vandq_u32(pixel, byteMask), 5);
+        gray = vshrq_n_u32(gray, 5);
+
+        const quint32 colors[4] = {
+            table[vgetq_lane_u32(gray, 0)],
+            table[vgetq_lane_u32(gray, 1)],
+            table[vgetq_lane_u32(gray, 2)],
+            table[vgetq_lane_u32(gray, 3)]
+        };
+
+        vst1q_u32(pixels + i, vorrq_u32(vandq_u32(pixel, alphaMask), vld1q_u32(colors)));
+    }
+
+    return i;
+}
+#endif
+
+ImageColorizer::ImageColorizer(const QColor &color)
+    : m_color(color)
+{
+    // Let KIconEffect colorize every gray level once, so the result is
+    // exactly the one it would give
+    QImage grays(256, 1, QImage::Format_ARGB32);
+    QRgb *line = reinterpret_cast<QRgb *>(grays.scanLine(0));
+    for (int gray = 0; gray < 256; ++gray) {
+        line[gray] = qRgba(gray, gray, gray, 255);
+    }
+
+    KIconEffect::colorize(grays, color, 1.0);
+
+    line = reinterpret_cast<QRgb *>(grays.scanLine(0));
+    for (int gray = 0; gray < 256; ++gray) {
+        m_table[gray] = line[gray] & 0x00ffffff;
+    }
+}
+
+void ImageColorizer::apply(quint32 *pixels, int count) const
+{
+    int i = 0;
+
+#ifdef PLASMA_COLORIZE_AVX2
+    if (hasAvx2()) {
+        i = colorizeAvx2(pixels, count, m_table);
+    }
+#endif
+#ifdef PLASMA_COLORIZE_SSE2
+    i += colorizeSse2(pixels + i, count - i, m_table);
+#endif
+#ifdef PLASMA_COLORIZE_NEON
+    i = colorizeNeon(pixels, count, m_table);
+#endif
+
+    for (; i < count; ++i) {
+        pixels[i] = (pixels[i] & 0xff000000) | m_table[grayLevel(pixels[i])];
+    }
+}
+
+void ImageColorizer::apply(QImage &image) const
+{
+    if (image.depth() != 32) {
+        KIconEffect::colorize(image, m_color, 1.0);
+        return;
+    }
+
+    const int width = image.width();
+    if (image.bytesPerLine() == width * 4) {
+        apply(reinterpret_cast<quint32 *>(image.bits()), width * image.height());
+    } else {
+        for (int y = 0; y < image.height(); ++y) {
+            apply(reinterpret_cast<quint32 *>(image.scanLine(y)), width);
+        }
+    }
+}
+
+void ImageColorizer::colorize(QImage &image, const QColor &color)
+{
+    ImageColorizer(color).apply(image);
+}
+
+}
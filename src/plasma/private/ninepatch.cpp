@@ -0,0 +1,69 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "ninepatch_p.h"
+
+#include <QPainter>
+
+namespace Plasma
+{
+
+NinePatch::NinePatch()
+{
+}
+
+QImage NinePatch::patch(Part part) const
+{
+    return m_patches[part];
+}
+
+void NinePatch::setPatch(Part part, const QImage &image)
+{
+    m_patches[part] = image;
+}
+
+void NinePatch::draw(QPainter &painter, Part part, const QRect &target, bool tile) const
+{
+    const QImage &patch = m_patches[part];
+    if (patch.isNull() || target.isEmpty()) {
+        return;
+    }
+
+    if (tile) {
+        //drawTiledPixmap() would need a QPixmap, which only the GUI thread can use
+        painter.setBrushOrigin(target.topLeft());
+        painter.fillRect(target, QBrush(patch));
+    } else if (target.size() == patch.size()) {
+        painter.drawImage(target.topLeft(), patch);
+    } else {
+        painter.drawImage(target, patch);
+    }
+}
+
+qint64 NinePatch::size() const
+{
+    qint64 bytes = 0;
+    for (int i = 0; i < PartCount; ++i) {
+        bytes += m_patches[i].byteCount();
+    }
+
+    return bytes;
+}
+
+}
@@ -0,0 +1,81 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PLASMA_NINEPATCH_P_H
+#define PLASMA_NINEPATCH_P_H
+
+#include <QExplicitlySharedDataPointer>
+#include <QImage>
+#include <QSharedData>
+
+class QPainter;
+
+namespace Plasma
+{
+
+/**
+ * The center, borders and corners of a frame, rasterized once at their size
+ * in device pixels and composed into frames of any size by copying the
+ * corners and tiling or stretching the rest.
+ *
+ * Shared by all the frames of the same prefix, borders and device pixel ratio,
+ * whatever their size. The patches are images, so frames can be composed
+ * from them in worker threads.
+ */
+class NinePatch : public QSharedData
+{
+public:
+    typedef QExplicitlySharedDataPointer<NinePatch> Ptr;
+
+    enum Part {
+        Center = 0,
+        Top,
+        Bottom,
+        Left,
+        Right,
+        TopLeft,
+        TopRight,
+        BottomLeft,
+        BottomRight,
+        PartCount
+    };
+
+    NinePatch();
+
+    QImage patch(Part part) const;
+    void setPatch(Part part, const QImage &image);
+
+    /**
+     * Fills @p target with @p part, repeated at its size if @p tile,
+     * otherwise scaled to it. Nothing is drawn for a missing part.
+     */
+    void draw(QPainter &painter, Part part, const QRect &target, bool tile) const;
+
+    /**
+     * Memory used by the patches, in bytes
+     */
+    qint64 size() const;
+
+private:
+    QImage m_patches[PartCount];
+};
+
+}
+
+#endif
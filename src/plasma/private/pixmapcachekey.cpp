@@ -0,0 +1,160 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "pixmapcachekey_p.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStringBuilder>
+#include <QVector>
+
+namespace Plasma
+{
+
+class StringIds
+{
+public:
+    StringIds()
+    {
+        strings << QString();
+        ids.insert(QString(), 0);
+    }
+
+    QMutex mutex;
+    QHash<QString, quint32> ids;
+    QVector<QString> strings;
+};
+
+Q_GLOBAL_STATIC(StringIds, s_stringIds)
+
+static inline quint16 toHundredths(qreal value)
+{
+    return quint16(qBound(0, qRound(value * 100), 0xffff));
+}
+
+// the same as QString::number() of the original value
+static inline QString hundredthsToString(quint16 value)
+{
+    return QString::number(value / 100.0);
+}
+
+PixmapCacheKey::PixmapCacheKey()
+    : path(0),
+      element(0),
+      width(0),
+      height(0),
+      type(SvgElement),
+      status(0),
+      colorGroup(0),
+      enabledBorders(0),
+      devicePixelRatio(0),
+      scaleFactor(0)
+{
+}
+
+PixmapCacheKey PixmapCacheKey::svgElement(const QString &path, const QString &elementId, const QSize &size,
+                                          int status, int devicePixelRatio, int colorGroup)
+{
+    PixmapCacheKey key;
+    key.path = intern(path);
+    key.element = intern(elementId);
+    key.width = size.width();
+    key.height = size.height();
+    key.status = status;
+    key.devicePixelRatio = toHundredths(devicePixelRatio);
+    key.colorGroup = colorGroup;
+    return key;
+}
+
+PixmapCacheKey PixmapCacheKey::frame(Type type, const QString &path, const QString &prefix, const QSize &size,
+                                     int enabledBorders, qreal scaleFactor, qreal devicePixelRatio)
+{
+    PixmapCacheKey key;
+    key.type = type;
+    key.path = intern(path);
+    key.element = intern(prefix);
+    key.width = size.width();
+    key.height = size.height();
+    key.enabledBorders = enabledBorders;
+    key.scaleFactor = toHundredths(scaleFactor);
+    key.devicePixelRatio = toHundredths(devicePixelRatio);
+    return key;
+}
+
+PixmapCacheKey PixmapCacheKey::custom(const QString &key)
+{
+    PixmapCacheKey customKey;
+    customKey.type = Custom;
+    customKey.custom = key;
+    return customKey;
+}
+
+PixmapCacheKey PixmapCacheKey::withType(Type type) const
+{
+    PixmapCacheKey key(*this);
+    key.type = type;
+    return key;
+}
+
+QString PixmapCacheKey::toString() const
+{
+    const QLatin1Char s('_');
+
+    if (type == Custom) {
+        return custom;
+    }
+
+    if (type == SvgElement) {
+        return QString::number(width) % s % QString::number(height) % s % internedString(path) % s %
+               QString::number(status) % s % hundredthsToString(devicePixelRatio) % s %
+               QString::number(colorGroup) % internedString(element);
+    }
+
+    const QString id = QString::number(enabledBorders) % s % QString::number(width) % s % QString::number(height) % s %
+                       hundredthsToString(scaleFactor) % s % hundredthsToString(devicePixelRatio) % s %
+                       internedString(element) % s % internedString(path);
+
+    return type == FrameOverlay ? QLatin1String("overlay_") % id : id;
+}
+
+quint32 PixmapCacheKey::intern(const QString &string)
+{
+    StringIds *stringIds = s_stringIds();
+    QMutexLocker lock(&stringIds->mutex);
+
+    QHash<QString, quint32>::const_iterator it = stringIds->ids.constFind(string);
+    if (it != stringIds->ids.constEnd()) {
+        return it.value();
+    }
+
+    const quint32 id = stringIds->strings.size();
+    stringIds->strings << string;
+    stringIds->ids.insert(string, id);
+    return id;
+}
+
+QString PixmapCacheKey::internedString(quint32 id)
+{
+    StringIds *stringIds = s_stringIds();
+    QMutexLocker lock(&stringIds->mutex);
+
+    return stringIds->strings.value(id);
+}
+
+}
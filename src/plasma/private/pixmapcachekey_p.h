@@ -0,0 +1,161 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PLASMA_PIXMAPCACHEKEY_P_H
+#define PLASMA_PIXMAPCACHEKEY_P_H
+
+#include <QHash>
+#include <QSize>
+#include <QString>
+
+namespace Plasma
+{
+
+/**
+ * Identifies a rendered pixmap in the theme pixmap cache.
+ *
+ * Paths, element ids and prefixes are interned once per process, so building,
+ * hashing and comparing a key never allocates. The keys given as strings
+ * through the public Theme API are arbitrary and kept as they are instead:
+ * they would make the interned strings grow for the life of the process.
+ * The string form, only needed for the persistent PixmapStore, is the same
+ * the cache always used.
+ */
+class PixmapCacheKey
+{
+public:
+    enum Type {
+        SvgElement = 0,
+        FrameBackground,
+        FrameOverlay,
+        //the nine patches a frame is composed of, only kept in memory
+        FramePatches,
+        //a key given as a string through the public Theme API
+        Custom
+    };
+
+    PixmapCacheKey();
+
+    static PixmapCacheKey svgElement(const QString &path, const QString &elementId, const QSize &size,
+                                     int status, int devicePixelRatio, int colorGroup);
+    static PixmapCacheKey frame(Type type, const QString &path, const QString &prefix, const QSize &size,
+                                int enabledBorders, qreal scaleFactor, qreal devicePixelRatio);
+    static PixmapCacheKey custom(const QString &key);
+
+    /**
+     * @returns a key identical to this one, but of another @p type
+     */
+    PixmapCacheKey withType(Type type) const;
+
+    /**
+     * The key in the form used in the persistent cache
+     */
+    QString toString() const;
+
+    /**
+     * @returns a process wide id for @p string, the same string always gets the same id.
+     * 0 is the id of the empty string.
+     */
+    static quint32 intern(const QString &string);
+    static QString internedString(quint32 id);
+
+    bool operator==(const PixmapCacheKey &other) const
+    {
+        return path == other.path && element == other.element &&
+               width == other.width && height == other.height &&
+               type == other.type && status == other.status &&
+               colorGroup == other.colorGroup && devicePixelRatio == other.devicePixelRatio &&
+               scaleFactor == other.scaleFactor && enabledBorders == other.enabledBorders &&
+               custom == other.custom;
+    }
+
+    quint32 path;
+    //element id for svgs, prefix for frames
+    quint32 element;
+    qint32 width;
+    qint32 height;
+    quint8 type;
+    quint8 status;
+    quint8 colorGroup;
+    quint8 enabledBorders;
+    //in hundredths, so fractional ratios and factors get keys of their own
+    quint16 devicePixelRatio;
+    quint16 scaleFactor;
+    //the whole key of the Custom ones, null for the others
+    QString custom;
+};
+
+inline uint qHash(const PixmapCacheKey &key, uint seed = 0)
+{
+    uint h = seed ^ key.path;
+    h = h * 31 + key.element;
+    h = h * 31 + uint(key.width);
+    h = h * 31 + uint(key.height);
+    h = h * 31 + (uint(key.type) | uint(key.status) << 8 | uint(key.colorGroup) << 16 | uint(key.enabledBorders) << 24);
+    h = h * 31 + (uint(key.devicePixelRatio) | uint(key.scaleFactor) << 16);
+    return key.type == PixmapCacheKey::Custom ? h ^ qHash(key.custom) : h;
+}
+
+/**
+ * Who inserted a pixmap in the cache: only the last pixmap inserted by the same
+ * owner is kept waiting to be written to disk, e.g. only the last size of an element of a Svg
+ */
+struct PixmapCacheOwner
+{
+    PixmapCacheOwner(const void *object = 0, quint32 element = 0, PixmapCacheKey::Type type = PixmapCacheKey::SvgElement)
+        : object(object),
+          element(element),
+          type(type)
+    {
+    }
+
+    /**
+     * An owner identified by the id given to the public Theme API
+     */
+    PixmapCacheOwner(const void *object, const QString &id)
+        : object(object),
+          element(0),
+          type(PixmapCacheKey::Custom),
+          id(id)
+    {
+    }
+
+    bool operator==(const PixmapCacheOwner &other) const
+    {
+        return object == other.object && element == other.element && type == other.type && id == other.id;
+    }
+
+    const void *object;
+    quint32 element;
+    PixmapCacheKey::Type type;
+    QString id;
+};
+
+inline uint qHash(const PixmapCacheOwner &owner, uint seed = 0)
+{
+    const uint h = qHash(quintptr(owner.object), seed) ^ (owner.element * 31 + owner.type);
+    return owner.id.isNull() ? h : h ^ qHash(owner.id);
+}
+
+}
+
+Q_DECLARE_TYPEINFO(Plasma::PixmapCacheKey, Q_MOVABLE_TYPE);
+Q_DECLARE_TYPEINFO(Plasma::PixmapCacheOwner, Q_MOVABLE_TYPE);
+
+#endif
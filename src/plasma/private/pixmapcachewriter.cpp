@@ -0,0 +1,382 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "pixmapcachewriter_p.h"
+
+#include <QRunnable>
+
+#include <algorithm>
+
+namespace Plasma
+{
+
+// Deleted by the pool in the writer thread
+class PixmapCacheWriteJob : public QRunnable
+{
+public:
+    PixmapCacheWriteJob(PixmapCacheWriter *writer, int batchId, const PixmapStore::Batch &batch)
+        : m_writer(writer),
+          m_batchId(batchId),
+          m_batch(batch)
+    {
+    }
+
+    void run() Q_DECL_OVERRIDE
+    {
+        const bool saved = PixmapStore::write(m_batch);
+
+        // read by waitForBatch() if the GUI thread can't wait for the event
+        m_writer->m_batchSaved.store(saved);
+        QMetaObject::invokeMethod(m_writer, "batchWritten", Qt::QueuedConnection,
+                                  Q_ARG(int, m_batchId), Q_ARG(bool, saved));
+    }
+
+private:
+    PixmapCacheWriter *m_writer;
+    int m_batchId;
+    PixmapStore::Batch m_batch;
+};
+
+PixmapCacheWriter::PixmapCacheWriter(QObject *parent)
+    : QObject(parent),
+      m_store(0),
+      m_size(0),
+      m_ceiling(32 * 1024 * 1024),
+      m_batchSize(4 * 1024 * 1024),
+      m_nextSerial(0),
+      m_batch(0),
+      m_batchSaved(0),
+      m_writing(false),
+      m_flushing(false)
+{
+    // batches are appended to the file one after the other
+    m_thread.setMaxThreadCount(1);
+}
+
+PixmapCacheWriter::~PixmapCacheWriter()
+{
+    clear();
+}
+
+PixmapStore *PixmapCacheWriter::store() const
+{
+    return m_store;
+}
+
+void PixmapCacheWriter::setStore(PixmapStore *store)
+{
+    if (m_store == store) {
+        return;
+    }
+
+    const bool flushing = m_flushing;
+    m_flushing = false;
+    waitForBatch();
+
+    m_store = store;
+    if (flushing) {
+        flush();
+    }
+}
+
+bool PixmapCacheWriter::find(const PixmapCacheKey &key, QPixmap *pixmap) const
+{
+    QHash<PixmapCacheKey, Entry>::const_iterator it = m_queue.constFind(key);
+    if (it == m_queue.constEnd()) {
+        return false;
+    }
+
+    *pixmap = it->pixmap;
+    return true;
+}
+
+bool PixmapCacheWriter::find(const PixmapCacheKey &key, QImage *image) const
+{
+    QHash<PixmapCacheKey, Entry>::const_iterator it = m_queue.constFind(key);
+    if (it == m_queue.constEnd()) {
+        return false;
+    }
+
+    *image = it->image;
+    return true;
+}
+
+bool PixmapCacheWriter::find(const QString &key, QPixmap *pixmap) const
+{
+    for (QHash<PixmapCacheKey, Entry>::const_iterator it = m_queue.constBegin(); it != m_queue.constEnd(); ++it) {
+        if (it.key().toString() == key) {
+            *pixmap = it->pixmap;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void PixmapCacheWriter::insert(const PixmapCacheKey &key, const QPixmap &pixmap, const PixmapCacheOwner &owner,
+                               PixmapStore::ImageFlags flags)
+{
+    if (pixmap.isNull()) {
+        return;
+    }
+
+    QHash<PixmapCacheKey, Entry>::iterator it = m_queue.find(key);
+    if (it != m_queue.end()) {
+        m_size -= it->image.byteCount();
+    } else {
+        it = m_queue.insert(key, Entry());
+    }
+
+    // a raster pixmap and its image share the pixels
+    it->pixmap = pixmap;
+    it->image = pixmap.toImage();
+    it->owner = owner;
+    it->flags = flags;
+    it->serial = m_nextSerial++;
+    // if the previous image is being written, this one goes in a later batch
+    it->batch = 0;
+    m_size += it->image.byteCount();
+
+    enforceCeiling();
+}
+
+void PixmapCacheWriter::flush()
+{
+    m_flushing = true;
+    writeNextBatch();
+}
+
+void PixmapCacheWriter::clear()
+{
+    m_flushing = false;
+    waitForBatch();
+
+    m_queue.clear();
+    m_size = 0;
+}
+
+void PixmapCacheWriter::discard(PixmapStore::ImageFlags flags)
+{
+    const bool flushing = m_flushing;
+    m_flushing = false;
+    waitForBatch();
+
+    QHash<PixmapCacheKey, Entry>::iterator it = m_queue.begin();
+    while (it != m_queue.end()) {
+        if (it->flags & flags) {
+            it = remove(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (flushing) {
+        flush();
+    }
+}
+
+void PixmapCacheWriter::waitForDone()
+{
+    flush();
+    while (m_writing) {
+        waitForBatch();
+    }
+}
+
+bool PixmapCacheWriter::isEmpty() const
+{
+    return m_queue.isEmpty();
+}
+
+int PixmapCacheWriter::count() const
+{
+    return m_queue.count();
+}
+
+qint64 PixmapCacheWriter::size() const
+{
+    return m_size;
+}
+
+qint64 PixmapCacheWriter::ceiling() const
+{
+    return m_ceiling;
+}
+
+void PixmapCacheWriter::setCeiling(qint64 bytes)
+{
+    m_ceiling = bytes;
+    enforceCeiling();
+}
+
+qint64 PixmapCacheWriter::batchSize() const
+{
+    return m_batchSize;
+}
+
+void PixmapCacheWriter::setBatchSize(qint64 bytes)
+{
+    m_batchSize = bytes;
+}
+
+QList<QHash<PixmapCacheKey, PixmapCacheWriter::Entry>::iterator> PixmapCacheWriter::waitingEntries()
+{
+    QList<QHash<PixmapCacheKey, Entry>::iterator> waiting;
+    for (QHash<PixmapCacheKey, Entry>::iterator it = m_queue.begin(); it != m_queue.end(); ++it) {
+        if (!it->batch) {
+            waiting << it;
+        }
+    }
+
+    // oldest first
+    std::sort(waiting.begin(), waiting.end(),
+              [](const QHash<PixmapCacheKey, Entry>::iterator &a, const QHash<PixmapCacheKey, Entry>::iterator &b) {
+                  return a->serial < b->serial;
+              });
+    return waiting;
+}
+
+QHash<PixmapCacheKey, PixmapCacheWriter::Entry>::iterator PixmapCacheWriter::remove(QHash<PixmapCacheKey, Entry>::iterator it)
+{
+    m_size -= it->image.byteCount();
+    // unlike remove(), erase() never rehashes: the other iterators stay valid
+    return m_queue.erase(it);
+}
+
+void PixmapCacheWriter::writeNextBatch()
+{
+    if (m_writing || !m_store) {
+        return;
+    }
+
+    const QList<QHash<PixmapCacheKey, Entry>::iterator> waiting = waitingEntries();
+    if (waiting.isEmpty()) {
+        m_flushing = false;
+        if (m_queue.isEmpty()) {
+            emit flushed();
+        }
+        return;
+    }
+
+    // only the newest entry of an owner is worth writing
+    QHash<PixmapCacheOwner, quint64> newest;
+    foreach (const QHash<PixmapCacheKey, Entry>::iterator &it, waiting) {
+        if (it->owner.object) {
+            newest.insert(it->owner, it->serial);
+        }
+    }
+
+    ++m_batch;
+    PixmapStore::ImageList images;
+    qint64 batchSize = 0;
+    foreach (const QHash<PixmapCacheKey, Entry>::iterator &it, waiting) {
+        if (it->owner.object && newest.value(it->owner) != it->serial) {
+            remove(it);
+            continue;
+        }
+
+        const qint64 imageSize = it->image.byteCount();
+        if (!images.isEmpty() && batchSize + imageSize > m_batchSize) {
+            break;
+        }
+
+        it->batch = m_batch;
+        images << PixmapStore::Image(it.key().toString(), it->image, it->flags);
+        batchSize += imageSize;
+    }
+
+    m_writing = true;
+    m_thread.start(new PixmapCacheWriteJob(this, m_batch, m_store->prepareSave(images)));
+}
+
+void PixmapCacheWriter::batchWritten(int batch, bool saved)
+{
+    // already handled by waitForBatch()
+    if (!m_writing || batch != m_batch) {
+        return;
+    }
+
+    finishBatch(saved);
+}
+
+void PixmapCacheWriter::waitForBatch()
+{
+    if (!m_writing) {
+        return;
+    }
+
+    m_thread.waitForDone();
+    finishBatch(m_batchSaved.load());
+}
+
+void PixmapCacheWriter::finishBatch(bool saved)
+{
+    m_writing = false;
+
+    // Make the store see the new images before they leave the queue, so a
+    // lookup finds them in one or the other
+    if (saved) {
+        m_store->reload();
+    }
+
+    QHash<PixmapCacheKey, Entry>::iterator it = m_queue.begin();
+    while (it != m_queue.end()) {
+        if (it->batch != m_batch) {
+            ++it;
+        } else if (saved) {
+            it = remove(it);
+        } else {
+            it->batch = 0;
+            ++it;
+        }
+    }
+
+    if (!saved) {
+        // another process holds the file, try again at the next flush
+        m_flushing = false;
+        return;
+    }
+
+    if (m_flushing) {
+        writeNextBatch();
+    }
+}
+
+void PixmapCacheWriter::enforceCeiling()
+{
+    if (m_size <= m_ceiling) {
+        return;
+    }
+
+    flush();
+
+    // what is being written leaves the queue once done, drop the oldest of
+    // the rest if that's not enough
+    const QList<QHash<PixmapCacheKey, Entry>::iterator> waiting = waitingEntries();
+    foreach (const QHash<PixmapCacheKey, Entry>::iterator &it, waiting) {
+        if (m_size <= m_ceiling) {
+            break;
+        }
+        remove(it);
+    }
+}
+
+}
+
+#include "moc_pixmapcachewriter_p.cpp"
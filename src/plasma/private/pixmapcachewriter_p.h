@@ -0,0 +1,161 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PLASMA_PIXMAPCACHEWRITER_P_H
+#define PLASMA_PIXMAPCACHEWRITER_P_H
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QPixmap>
+#include <QThreadPool>
+
+#include "pixmapcachekey_p.h"
+#include "pixmapstore_p.h"
+
+namespace Plasma
+{
+
+/**
+ * Write-behind queue of the pixmaps waiting to be written to a PixmapStore.
+ *
+ * Every insert is one entry of the queue, which stays visible to find()
+ * until the writer has written it and the store has picked it up, so a
+ * lookup never misses an image that is being written. flush() hands the
+ * oldest entries to a writer thread, at most batchSize() bytes at a time,
+ * and the next batch goes once the previous one is done.
+ *
+ * Of the entries inserted by the same owner, only the newest one gets
+ * written, e.g. only the last size of an element of a Svg being resized.
+ * When the queue grows over its ceiling, a flush starts right away and if
+ * that is not enough the oldest entries not being written are dropped.
+ *
+ * Only to be used from the GUI thread, except for the store file itself.
+ */
+class PixmapCacheWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PixmapCacheWriter(QObject *parent = 0);
+    ~PixmapCacheWriter();
+
+    PixmapStore *store() const;
+
+    /**
+     * Sets where the queue gets written, waiting for the batch being
+     * written to the previous store if any. The store is not owned, set a
+     * null store before deleting it: the queue then waits for the next one.
+     */
+    void setStore(PixmapStore *store);
+
+    bool find(const PixmapCacheKey &key, QPixmap *pixmap) const;
+    bool find(const PixmapCacheKey &key, QImage *image) const;
+
+    /**
+     * Slow lookup by the string form of the key, for the public Theme API
+     */
+    bool find(const QString &key, QPixmap *pixmap) const;
+
+    void insert(const PixmapCacheKey &key, const QPixmap &pixmap, const PixmapCacheOwner &owner,
+                PixmapStore::ImageFlags flags = PixmapStore::NoImageFlags);
+
+    /**
+     * Starts writing the queue, one batch after the other
+     */
+    void flush();
+
+    /**
+     * Drops the queue, waiting for the batch being written if any
+     */
+    void clear();
+
+    /**
+     * Drops the entries inserted with any of @p flags, waiting for the batch
+     * being written if any: the store can then discard them as well
+     */
+    void discard(PixmapStore::ImageFlags flags);
+
+    /**
+     * Blocks until the whole queue has been written
+     */
+    void waitForDone();
+
+    bool isEmpty() const;
+    int count() const;
+
+    /**
+     * Size of the pixels in the queue, in bytes
+     */
+    qint64 size() const;
+
+    qint64 ceiling() const;
+    void setCeiling(qint64 bytes);
+    qint64 batchSize() const;
+    void setBatchSize(qint64 bytes);
+
+Q_SIGNALS:
+    /**
+     * Emitted when the whole queue has been written
+     */
+    void flushed();
+
+private Q_SLOTS:
+    void batchWritten(int batch, bool saved);
+
+private:
+    struct Entry {
+        //handed out by find() as is, only the image goes to the writer thread
+        QPixmap pixmap;
+        QImage image;
+        PixmapCacheOwner owner;
+        PixmapStore::ImageFlags flags;
+        //order of insertion
+        quint64 serial;
+        //id of the batch writing it, 0 if none
+        int batch;
+    };
+
+    void writeNextBatch();
+    void finishBatch(bool saved);
+    void waitForBatch();
+    void enforceCeiling();
+    QList<QHash<PixmapCacheKey, Entry>::iterator> waitingEntries();
+    QHash<PixmapCacheKey, Entry>::iterator remove(QHash<PixmapCacheKey, Entry>::iterator it);
+
+    friend class PixmapCacheWriteJob;
+
+    PixmapStore *m_store;
+    QHash<PixmapCacheKey, Entry> m_queue;
+    QThreadPool m_thread;
+    qint64 m_size;
+    qint64 m_ceiling;
+    qint64 m_batchSize;
+    quint64 m_nextSerial;
+    //id of the last batch handed to the writer thread
+    int m_batch;
+    QAtomicInt m_batchSaved;
+    bool m_writing : 1;
+    bool m_flushing : 1;
+};
+
+}
+
+#endif
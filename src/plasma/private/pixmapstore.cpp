@@ -0,0 +1,667 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "pixmapstore_p.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QSaveFile>
+
+#include <cstddef>
+#include <cstring>
+
+#include "svgelementsindex_p.h"
+
+namespace Plasma
+{
+
+// Bump every time the layout of the records below changes, old files are then replaced
+static const quint32 s_storeVersion = 2;
+static const char s_storeMagic[8] = {'P', 'L', 'P', 'I', 'X', 'M', 'A', 'P'};
+
+// The file is laid out as:
+// Header | Segment | Segment | ...
+// and every save appends a segment:
+// (pixels | key)[count] | IndexHeader | IndexEntry[count]
+// Everything starts at a multiple of 16 bytes in the file, so the rows of
+// the images are aligned once mapped. All the offsets are from the
+// beginning of the file, the keys are in QChars.
+
+struct PixmapStore::Header {
+    char magic[8];
+    quint32 version;
+    //set when the file has been replaced by a new one
+    quint32 stale;
+    //end of the last complete segment
+    quint64 size;
+    //index of the last segment, 0 if there is none
+    quint64 lastIndex;
+    //msecs since epoch
+    qint64 lastModified;
+    quint64 reserved[3];
+};
+
+struct PixmapStore::IndexHeader {
+    //index of the previous segment, 0 for the first one
+    quint64 previous;
+    quint64 segmentStart;
+    quint32 count;
+    quint32 reserved[3];
+};
+
+struct PixmapStore::IndexEntry {
+    quint64 hash;
+    quint64 key;
+    quint64 data;
+    quint32 keyLength;
+    quint32 width;
+    quint32 height;
+    quint32 bytesPerLine;
+    quint32 format;
+    //PixmapStore::ImageFlags
+    quint32 flags;
+};
+
+// All the mappings of one version of the file, alive as long as the store or
+// one of the images handed out uses it
+class PixmapStore::MappedFile : public QSharedData
+{
+public:
+    explicit MappedFile(const QString &fileName)
+        : file(fileName),
+          header(0),
+          mappedSize(sizeof(Header))
+    {
+    }
+
+    ~MappedFile()
+    {
+        foreach (uchar *segment, segments) {
+            file.unmap(segment);
+        }
+        if (header) {
+            file.unmap(reinterpret_cast<uchar *>(const_cast<Header *>(header)));
+        }
+    }
+
+    QFile file;
+    const Header *header;
+    QList<uchar *> segments;
+    quint64 mappedSize;
+};
+
+// The header is written by other processes while we have it mapped
+template<typename T>
+static inline T loadShared(const T &value)
+{
+    return *static_cast<const volatile T *>(&value);
+}
+
+static inline quint64 aligned(quint64 size)
+{
+    return (size + 15) & ~quint64(15);
+}
+
+static bool isStorable(QImage::Format format)
+{
+    return format != QImage::Format_Invalid && format != QImage::Format_Mono &&
+           format != QImage::Format_MonoLSB && format != QImage::Format_Indexed8 &&
+           format < QImage::NImageFormats;
+}
+
+PixmapStore::PixmapStore(const QString &fileName, qint64 budget)
+    : m_file(0),
+      m_fileName(fileName),
+      m_budget(budget)
+{
+    open();
+}
+
+PixmapStore::~PixmapStore()
+{
+    close();
+}
+
+QString PixmapStore::fileName() const
+{
+    return m_fileName;
+}
+
+void PixmapStore::releaseFile(void *file)
+{
+    MappedFile *mappedFile = static_cast<MappedFile *>(file);
+    if (!mappedFile->ref.deref()) {
+        delete mappedFile;
+    }
+}
+
+void PixmapStore::open()
+{
+    close();
+
+    m_file = new MappedFile(m_fileName);
+    m_file->ref.ref();
+
+    if (!m_file->file.open(QIODevice::ReadOnly) || m_file->file.size() < qint64(sizeof(Header))) {
+        return;
+    }
+
+    const Header *header = reinterpret_cast<const Header *>(m_file->file.map(0, sizeof(Header)));
+    if (!header) {
+        return;
+    }
+
+    if (memcmp(header->magic, s_storeMagic, sizeof(s_storeMagic)) != 0 || header->version != s_storeVersion) {
+        m_file->file.unmap(reinterpret_cast<uchar *>(const_cast<Header *>(header)));
+        return;
+    }
+
+    m_file->header = header;
+    mapSegments();
+}
+
+void PixmapStore::close()
+{
+    if (m_file) {
+        releaseFile(m_file);
+        m_file = 0;
+    }
+
+    m_index.clear();
+    m_used.clear();
+}
+
+bool PixmapStore::mapSegments()
+{
+    const Header *header = m_file->header;
+    if (!header) {
+        return false;
+    }
+
+    const quint64 start = m_file->mappedSize;
+    const quint64 size = loadShared(header->size);
+    const quint64 lastIndex = loadShared(header->lastIndex);
+
+    // Nothing new, or being written right now: try again at the next miss
+    if (size <= start || lastIndex < start || lastIndex + sizeof(IndexHeader) > size ||
+        size > quint64(m_file->file.size())) {
+        return false;
+    }
+
+    uchar *segment = m_file->file.map(start, size - start);
+    if (!segment) {
+        return false;
+    }
+
+    m_file->segments << segment;
+    m_file->mappedSize = size;
+
+    // Walk the new segments from the newest one: the first entry found for a
+    // key is the one to keep, but it replaces whatever was mapped before
+    QHash<quint64, Location> added;
+    quint64 indexOffset = lastIndex;
+    while (indexOffset >= start && indexOffset + sizeof(IndexHeader) <= size) {
+        const IndexHeader *index = reinterpret_cast<const IndexHeader *>(segment + (indexOffset - start));
+        if (indexOffset + sizeof(IndexHeader) + quint64(index->count) * sizeof(IndexEntry) > size) {
+            break;
+        }
+
+        const IndexEntry *entries = reinterpret_cast<const IndexEntry *>(index + 1);
+        for (int i = index->count - 1; i >= 0; --i) {
+            const IndexEntry &entry = entries[i];
+            const bool valid = entry.data >= start && entry.key >= start &&
+                               entry.data + quint64(entry.bytesPerLine) * entry.height <= size &&
+                               entry.key + quint64(entry.keyLength) * sizeof(QChar) <= size &&
+                               entry.bytesPerLine > 0 && isStorable(QImage::Format(entry.format));
+            if (valid && !added.contains(entry.hash)) {
+                Location location;
+                location.entry = &entry;
+                location.segment = segment;
+                location.segmentOffset = start;
+                added.insert(entry.hash, location);
+            }
+        }
+
+        if (index->previous >= indexOffset) {
+            break;
+        }
+        indexOffset = index->previous;
+    }
+
+    for (QHash<quint64, Location>::const_iterator it = added.constBegin(); it != added.constEnd(); ++it) {
+        m_index.insert(it.key(), it.value());
+    }
+
+    return true;
+}
+
+bool PixmapStore::findLocation(const QString &key, quint64 hash, Location *location) const
+{
+    QHash<quint64, Location>::const_iterator it = m_index.constFind(hash);
+    if (it == m_index.constEnd()) {
+        return false;
+    }
+
+    const IndexEntry *entry = it->entry;
+    const QChar *mappedKey = reinterpret_cast<const QChar *>(it->segment + (entry->key - it->segmentOffset));
+    if (int(entry->keyLength) != key.size() || memcmp(mappedKey, key.constData(), key.size() * sizeof(QChar)) != 0) {
+        return false;
+    }
+
+    *location = it.value();
+    return true;
+}
+
+QImage PixmapStore::mappedImage(const Location &location) const
+{
+    const IndexEntry *entry = location.entry;
+    const uchar *data = location.segment + (entry->data - location.segmentOffset);
+
+    // the image keeps the mapping alive
+    m_file->ref.ref();
+    return QImage(data, entry->width, entry->height, entry->bytesPerLine,
+                  QImage::Format(entry->format), releaseFile, m_file);
+}
+
+bool PixmapStore::findImage(const QString &key, QImage *image)
+{
+    QHash<QString, Image>::const_iterator it = m_pending.constFind(key);
+    if (it != m_pending.constEnd()) {
+        *image = it->image;
+        return true;
+    }
+
+    // cleared or rewritten by another process
+    if (m_file->header && loadShared(m_file->header->stale)) {
+        open();
+    }
+
+    const quint64 hash = SvgElementsIndex::hash(key.constData(), key.size());
+
+    Location location;
+    if (!findLocation(key, hash, &location)) {
+        // Another process may have created the file or appended to it since
+        if (!m_file->header) {
+            open();
+        } else if (!mapSegments()) {
+            return false;
+        }
+
+        if (!findLocation(key, hash, &location)) {
+            return false;
+        }
+    }
+
+    m_used.insert(hash);
+    *image = mappedImage(location);
+    return true;
+}
+
+bool PixmapStore::findPixmap(const QString &key, QPixmap *pixmap)
+{
+    QImage image;
+    if (!findImage(key, &image)) {
+        return false;
+    }
+
+    *pixmap = QPixmap::fromImage(image);
+    return true;
+}
+
+void PixmapStore::insertImage(const QString &key, const QImage &image, ImageFlags flags)
+{
+    if (image.isNull()) {
+        return;
+    }
+
+    if (isStorable(image.format())) {
+        m_pending.insert(key, Image(key, image, flags));
+    } else {
+        m_pending.insert(key, Image(key, image.convertToFormat(QImage::Format_ARGB32_Premultiplied), flags));
+    }
+}
+
+void PixmapStore::insertPixmap(const QString &key, const QPixmap &pixmap, ImageFlags flags)
+{
+    insertImage(key, pixmap.toImage(), flags);
+}
+
+QDateTime PixmapStore::lastModifiedTime() const
+{
+    if (!m_file->header) {
+        return QDateTime();
+    }
+
+    return QDateTime::fromMSecsSinceEpoch(loadShared(m_file->header->lastModified));
+}
+
+qint64 PixmapStore::size() const
+{
+    if (!m_file->header) {
+        return 0;
+    }
+
+    return loadShared(m_file->header->size);
+}
+
+qint64 PixmapStore::budget() const
+{
+    return m_budget;
+}
+
+void PixmapStore::setBudget(qint64 budget)
+{
+    m_budget = budget;
+}
+
+bool PixmapStore::isDirty() const
+{
+    return !m_pending.isEmpty();
+}
+
+quint64 PixmapStore::segmentSize(const ImageList &images)
+{
+    quint64 size = sizeof(IndexHeader) + images.size() * sizeof(IndexEntry);
+    foreach (const Image &image, images) {
+        size += aligned(image.image.byteCount()) + aligned(image.key.size() * sizeof(QChar));
+    }
+
+    return size;
+}
+
+bool PixmapStore::writeSegment(QIODevice *device, const ImageList &images, quint64 start, quint64 previousIndex)
+{
+    static const char padding[16] = {0};
+
+    QVector<IndexEntry> entries;
+    entries.reserve(images.size());
+
+    quint64 offset = start;
+    foreach (const Image &image, images) {
+        const QString &key = image.key;
+        const QImage &pixels = image.image;
+
+        IndexEntry entry;
+        memset(&entry, 0, sizeof(IndexEntry));
+        entry.hash = SvgElementsIndex::hash(key.constData(), key.size());
+        entry.width = pixels.width();
+        entry.height = pixels.height();
+        entry.bytesPerLine = pixels.bytesPerLine();
+        entry.format = pixels.format();
+        entry.flags = image.flags;
+
+        entry.data = offset;
+        const quint64 dataSize = pixels.byteCount();
+        if (device->write(reinterpret_cast<const char *>(pixels.constBits()), dataSize) != qint64(dataSize) ||
+            device->write(padding, aligned(dataSize) - dataSize) != qint64(aligned(dataSize) - dataSize)) {
+            return false;
+        }
+        offset += aligned(dataSize);
+
+        entry.key = offset;
+        entry.keyLength = key.size();
+        const quint64 keySize = key.size() * sizeof(QChar);
+        if (device->write(reinterpret_cast<const char *>(key.constData()), keySize) != qint64(keySize) ||
+            device->write(padding, aligned(keySize) - keySize) != qint64(aligned(keySize) - keySize)) {
+            return false;
+        }
+        offset += aligned(keySize);
+
+        entries << entry;
+    }
+
+    IndexHeader index;
+    memset(&index, 0, sizeof(IndexHeader));
+    index.previous = previousIndex;
+    index.segmentStart = start;
+    index.count = entries.size();
+
+    const qint64 entriesSize = entries.size() * sizeof(IndexEntry);
+    return device->write(reinterpret_cast<const char *>(&index), sizeof(IndexHeader)) == qint64(sizeof(IndexHeader)) &&
+           device->write(reinterpret_cast<const char *>(entries.constData()), entriesSize) == entriesSize;
+}
+
+bool PixmapStore::rewrite(const QString &fileName, const ImageList &images, QFile *oldFile)
+{
+    Header header;
+    memset(&header, 0, sizeof(Header));
+    memcpy(header.magic, s_storeMagic, sizeof(s_storeMagic));
+    header.version = s_storeVersion;
+    header.size = sizeof(Header);
+    header.lastModified = QDateTime::currentMSecsSinceEpoch();
+    if (!images.isEmpty()) {
+        header.size += segmentSize(images);
+        header.lastIndex = header.size - sizeof(IndexHeader) - images.size() * sizeof(IndexEntry);
+    }
+
+    // QSaveFile writes a temporary file and renames it over the old one:
+    // whoever still has the old file mapped is not affected
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly) ||
+        file.write(reinterpret_cast<const char *>(&header), sizeof(Header)) != qint64(sizeof(Header)) ||
+        (!images.isEmpty() && !writeSegment(&file, images, sizeof(Header), 0)) ||
+        !file.commit()) {
+        return false;
+    }
+
+    // let the other processes know they have to open the new file
+    if (oldFile && oldFile->isOpen() && oldFile->size() >= qint64(sizeof(Header)) &&
+        oldFile->seek(offsetof(Header, stale))) {
+        const quint32 stale = 1;
+        oldFile->write(reinterpret_cast<const char *>(&stale), sizeof(stale));
+        oldFile->flush();
+    }
+
+    return true;
+}
+
+void PixmapStore::clear()
+{
+    m_pending.clear();
+
+    QDir().mkpath(QFileInfo(m_fileName).absolutePath());
+
+    QLockFile lock(m_fileName + QLatin1String(".lock"));
+    if (lock.tryLock(1000)) {
+        QFile oldFile(m_fileName);
+        oldFile.open(QIODevice::ReadWrite);
+        rewrite(m_fileName, ImageList(), &oldFile);
+    }
+
+    open();
+}
+
+bool PixmapStore::discard(ImageFlags flags)
+{
+    QHash<QString, Image>::iterator it = m_pending.begin();
+    while (it != m_pending.end()) {
+        if (it->flags & flags) {
+            it = m_pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    QDir().mkpath(QFileInfo(m_fileName).absolutePath());
+
+    QLockFile lock(m_fileName + QLatin1String(".lock"));
+    if (!lock.tryLock(1000)) {
+        return false;
+    }
+
+    // see what the file has now that nobody else writes it
+    reload();
+
+    ImageList kept;
+    bool found = false;
+    for (QHash<quint64, Location>::const_iterator it = m_index.constBegin(); it != m_index.constEnd(); ++it) {
+        const IndexEntry *entry = it->entry;
+        if (entry->flags & flags) {
+            found = true;
+            continue;
+        }
+
+        const QString key(reinterpret_cast<const QChar *>(it->segment + (entry->key - it->segmentOffset)), entry->keyLength);
+        kept << Image(key, mappedImage(it.value()), ImageFlags(entry->flags));
+    }
+
+    if (!found) {
+        return true;
+    }
+
+    QFile oldFile(m_fileName);
+    oldFile.open(QIODevice::ReadWrite);
+    const bool saved = rewrite(m_fileName, kept, &oldFile);
+    oldFile.close();
+    lock.unlock();
+
+    open();
+    return saved;
+}
+
+bool PixmapStore::save()
+{
+    if (m_pending.isEmpty()) {
+        return true;
+    }
+
+    const ImageList images = m_pending.values();
+
+    const bool saved = write(prepareSave(images));
+    if (saved) {
+        m_pending.clear();
+    }
+
+    reload();
+    return saved;
+}
+
+PixmapStore::ImageList PixmapStore::keptImages(const ImageList &replaced) const
+{
+    QSet<QString> replacedKeys;
+    foreach (const Image &image, replaced) {
+        replacedKeys.insert(image.key);
+    }
+
+    // what this process is using, up to half the budget
+    ImageList kept;
+    quint64 keptSize = 0;
+    foreach (quint64 hash, m_used) {
+        const Location location = m_index.value(hash);
+        const IndexEntry *entry = location.entry;
+        const QString key(reinterpret_cast<const QChar *>(location.segment + (entry->key - location.segmentOffset)),
+                          entry->keyLength);
+        if (replacedKeys.contains(key)) {
+            continue;
+        }
+
+        keptSize += aligned(quint64(entry->bytesPerLine) * entry->height) + sizeof(IndexEntry);
+        if (keptSize > quint64(m_budget / 2)) {
+            break;
+        }
+        kept << Image(key, mappedImage(location), ImageFlags(entry->flags));
+    }
+
+    return kept;
+}
+
+PixmapStore::Batch PixmapStore::prepareSave(const ImageList &images) const
+{
+    Batch batch;
+    batch.fileName = m_fileName;
+    batch.budget = m_budget;
+    batch.images = images;
+
+    // The kept images are only needed if the file has to be rewritten. If
+    // another process fills the file before the batch is written, it is
+    // rewritten with the new images only.
+    const Header *header = m_file->header;
+    if (!header || loadShared(header->stale) || loadShared(header->size) + segmentSize(images) > quint64(m_budget)) {
+        batch.kept = keptImages(images);
+    }
+
+    return batch;
+}
+
+bool PixmapStore::write(const Batch &batch)
+{
+    ImageList images;
+    images.reserve(batch.images.size());
+    foreach (const Image &image, batch.images) {
+        if (image.image.isNull()) {
+            continue;
+        } else if (isStorable(image.image.format())) {
+            images << image;
+        } else {
+            images << Image(image.key, image.image.convertToFormat(QImage::Format_ARGB32_Premultiplied), image.flags);
+        }
+    }
+
+    if (images.isEmpty()) {
+        return true;
+    }
+
+    QDir().mkpath(QFileInfo(batch.fileName).absolutePath());
+
+    // another process may be appending to the file right now
+    QLockFile lock(batch.fileName + QLatin1String(".lock"));
+    if (!lock.tryLock(1000)) {
+        return false;
+    }
+
+    QFile file(batch.fileName);
+    Header header;
+    bool valid = file.open(QIODevice::ReadWrite) &&
+                 file.read(reinterpret_cast<char *>(&header), sizeof(Header)) == qint64(sizeof(Header)) &&
+                 memcmp(header.magic, s_storeMagic, sizeof(s_storeMagic)) == 0 &&
+                 header.version == s_storeVersion && !header.stale &&
+                 header.size >= sizeof(Header) && header.size <= quint64(file.size());
+
+    const quint64 appendedSize = segmentSize(images);
+    bool saved;
+    if (valid && header.size + appendedSize <= quint64(batch.budget)) {
+        // anything after the last complete segment is left over by a writer that didn't finish
+        saved = file.seek(header.size) && writeSegment(&file, images, header.size, header.lastIndex);
+        if (saved) {
+            header.lastIndex = header.size + appendedSize - sizeof(IndexHeader) - images.size() * sizeof(IndexEntry);
+            header.size += appendedSize;
+            header.lastModified = QDateTime::currentMSecsSinceEpoch();
+            saved = file.flush() && file.seek(0) &&
+                    file.write(reinterpret_cast<const char *>(&header), sizeof(Header)) == qint64(sizeof(Header)) &&
+                    file.flush();
+        }
+    } else {
+        // start over with the kept images and the new ones
+        saved = rewrite(batch.fileName, batch.kept + images, valid ? &file : 0);
+    }
+
+    return saved;
+}
+
+void PixmapStore::reload()
+{
+    if (!m_file->header || loadShared(m_file->header->stale)) {
+        open();
+    } else {
+        mapSegments();
+    }
+}
+
+}
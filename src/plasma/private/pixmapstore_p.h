@@ -0,0 +1,193 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PLASMA_PIXMAPSTORE_P_H
+#define PLASMA_PIXMAPSTORE_P_H
+
+#include <QDateTime>
+#include <QFlags>
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QPixmap>
+#include <QSet>
+#include <QString>
+
+namespace Plasma
+{
+
+/**
+ * Persistent cache of the rendered images of a theme, in a memory mapped
+ * file shared by every process using the theme.
+ *
+ * The images are stored as they are, rows included, and findImage() hands
+ * out read only QImages wrapping the mapped pixels: a hit never copies
+ * anything. The mapping stays around as long as one of those images is
+ * alive, even if the file has been replaced in the meantime.
+ *
+ * Bytes already written are never modified: new images are kept in memory
+ * until save() appends them to the file, together with an index of what it
+ * appended. When the file would grow past the budget, save() writes a new
+ * file keeping only the images this process used and atomically replaces
+ * the old one, which gets marked as stale so the other processes open the
+ * new one at their next miss.
+ */
+class PixmapStore
+{
+public:
+    enum ImageFlag {
+        NoImageFlags = 0,
+        //has to be rendered again when the colors change
+        ColorDependent = 1
+    };
+    Q_DECLARE_FLAGS(ImageFlags, ImageFlag)
+
+    struct Image {
+        Image(const QString &key = QString(), const QImage &image = QImage(), ImageFlags flags = NoImageFlags)
+            : key(key),
+              image(image),
+              flags(flags)
+        {
+        }
+
+        QString key;
+        QImage image;
+        ImageFlags flags;
+    };
+    typedef QList<Image> ImageList;
+
+    /**
+     * Everything needed to write images to the file, so it can be done
+     * away from the store, see prepareSave() and write()
+     */
+    struct Batch {
+        QString fileName;
+        qint64 budget;
+        ImageList images;
+        //what to keep if the file has to be rewritten
+        ImageList kept;
+    };
+
+    /**
+     * @param budget the size the file should not exceed, in bytes
+     */
+    PixmapStore(const QString &fileName, qint64 budget);
+    ~PixmapStore();
+
+    QString fileName() const;
+
+    /**
+     * @returns true if @p key has been found, in which case @p image is set
+     * to a read only view of it. Making the view writable makes a copy.
+     */
+    bool findImage(const QString &key, QImage *image);
+    bool findPixmap(const QString &key, QPixmap *pixmap);
+
+    /**
+     * Adds an image, visible to the other processes after the next save()
+     */
+    void insertImage(const QString &key, const QImage &image, ImageFlags flags = NoImageFlags);
+    void insertPixmap(const QString &key, const QPixmap &pixmap, ImageFlags flags = NoImageFlags);
+
+    /**
+     * When images were last saved to the file, by any process
+     */
+    QDateTime lastModifiedTime() const;
+
+    /**
+     * Forgets everything and replaces the file with an empty one
+     */
+    void clear();
+
+    /**
+     * Forgets the images inserted with any of @p flags and, if the file has
+     * some, replaces it with one keeping all the others. Another process
+     * discarding the same images first leaves nothing to do.
+     */
+    bool discard(ImageFlags flags);
+
+    bool isDirty() const;
+
+    /**
+     * Appends the images inserted since the last save to the file
+     */
+    bool save();
+
+    /**
+     * Prepares writing @p images without the store, for a writer thread:
+     * write() doesn't touch the store and can run in any thread, but the
+     * images it writes are only visible to findImage() after reload().
+     * The images inserted with insertImage() are not part of the batch.
+     */
+    Batch prepareSave(const ImageList &images) const;
+    static bool write(const Batch &batch);
+
+    /**
+     * Picks up what has been written to the file since it has been opened
+     */
+    void reload();
+
+    /**
+     * Size of the images in the file, in bytes
+     */
+    qint64 size() const;
+
+    qint64 budget() const;
+    void setBudget(qint64 budget);
+
+private:
+    class MappedFile;
+    struct Header;
+    struct IndexHeader;
+    struct IndexEntry;
+
+    struct Location {
+        const IndexEntry *entry;
+        //where the segment holding the entry is mapped
+        const uchar *segment;
+        quint64 segmentOffset;
+    };
+
+    void open();
+    void close();
+    bool mapSegments();
+    bool findLocation(const QString &key, quint64 hash, Location *location) const;
+    QImage mappedImage(const Location &location) const;
+    ImageList keptImages(const ImageList &replaced) const;
+    static bool rewrite(const QString &fileName, const ImageList &images, QFile *oldFile);
+
+    static quint64 segmentSize(const ImageList &images);
+    static bool writeSegment(QIODevice *device, const ImageList &images, quint64 start, quint64 previousIndex);
+    static void releaseFile(void *file);
+
+    MappedFile *m_file;
+    QHash<quint64, Location> m_index;
+    QHash<QString, Image> m_pending;
+    //entries found in the file since it has been opened, kept when it's rewritten
+    QSet<quint64> m_used;
+    QString m_fileName;
+    qint64 m_budget;
+};
+
+}
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(Plasma::PixmapStore::ImageFlags)
+
+#endif
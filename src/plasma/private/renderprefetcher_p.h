@@ -0,0 +1,67 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PLASMA_RENDERPREFETCHER_P_H
+#define PLASMA_RENDERPREFETCHER_P_H
+
+#include <QList>
+#include <QPointer>
+#include <QSize>
+
+#include "theme.h"
+
+class QImage;
+
+namespace Plasma
+{
+
+class RenderPrefetcher;
+
+class RenderPrefetcherPrivate
+{
+public:
+    RenderPrefetcherPrivate(RenderPrefetcher *prefetcher);
+
+    //Slots
+    void imageReady(int request, const QImage &image);
+    void generateFrames();
+
+    void imageDone();
+
+    struct Request {
+        QString imagePath;
+        QString element;
+        QSize size;
+        qreal devicePixelRatio;
+        Theme::ColorGroup group;
+    };
+
+    RenderPrefetcher *q;
+    QPointer<Theme> theme;
+    QList<Request> images;
+    QList<Request> frames;
+    //frames of the batch being rendered, composed once the images are done
+    QList<Request> runningFrames;
+    int runningImages;
+    bool running;
+};
+
+}
+
+#endif
@@ -0,0 +1,147 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "stylesheettemplate_p.h"
+
+namespace Plasma
+{
+
+// in the order of StyleSheetTemplate::Placeholder
+static const char *const s_placeholderNames[] = {
+    "%textcolor",
+    "%backgroundcolor",
+    "%highlightcolor",
+    "%highlightedtextcolor",
+    "%visitedlink",
+    "%activatedlink",
+    "%hoveredlink",
+    "%link",
+    "%positivetextcolor",
+    "%neutraltextcolor",
+    "%negativetextcolor",
+
+    "%buttontextcolor",
+    "%buttonbackgroundcolor",
+    "%buttonhovercolor",
+    "%buttonfocuscolor",
+    "%buttonhighlightedtextcolor",
+    "%buttonpositivetextcolor",
+    "%buttonneutraltextcolor",
+    "%buttonnegativetextcolor",
+
+    "%viewtextcolor",
+    "%viewbackgroundcolor",
+    "%viewhovercolor",
+    "%viewfocuscolor",
+    "%viewhighlightedtextcolor",
+    "%viewpositivetextcolor",
+    "%viewneutraltextcolor",
+    "%viewnegativetextcolor",
+
+    "%complementarytextcolor",
+    "%complementarybackgroundcolor",
+    "%complementaryhovercolor",
+    "%complementaryfocuscolor",
+    "%complementaryhighlightedtextcolor",
+    "%complementarypositivetextcolor",
+    "%complementaryneutraltextcolor",
+    "%complementarynegativetextcolor",
+
+    "%fontsize",
+    "%fontfamily",
+    "%smallfontsize"
+};
+
+Q_STATIC_ASSERT(sizeof(s_placeholderNames) / sizeof(s_placeholderNames[0]) == StyleSheetTemplate::PlaceholderCount);
+
+StyleSheetTemplate::StyleSheetTemplate()
+    : m_literalLength(0)
+{
+}
+
+StyleSheetTemplate::StyleSheetTemplate(const QString &css)
+    : m_literalLength(0)
+{
+    int literalStart = 0;
+    int i = css.indexOf(QLatin1Char('%'));
+    while (i >= 0) {
+        // the longest name wins, no name is a prefix of another one today
+        int placeholder = PlaceholderCount;
+        int nameLength = 0;
+        for (int p = 0; p < PlaceholderCount; ++p) {
+            const QLatin1String name(s_placeholderNames[p]);
+            if (name.size() > nameLength && css.midRef(i).startsWith(name)) {
+                placeholder = p;
+                nameLength = name.size();
+            }
+        }
+
+        if (placeholder == PlaceholderCount) {
+            i = css.indexOf(QLatin1Char('%'), i + 1);
+            continue;
+        }
+
+        Segment segment;
+        segment.literal = css.mid(literalStart, i - literalStart);
+        segment.placeholder = placeholder;
+        m_segments << segment;
+        m_literalLength += segment.literal.length();
+
+        literalStart = i + nameLength;
+        i = css.indexOf(QLatin1Char('%'), literalStart);
+    }
+
+    if (literalStart < css.length()) {
+        Segment segment;
+        segment.literal = css.mid(literalStart);
+        segment.placeholder = PlaceholderCount;
+        m_segments << segment;
+        m_literalLength += segment.literal.length();
+    }
+}
+
+bool StyleSheetTemplate::isEmpty() const
+{
+    return m_segments.isEmpty();
+}
+
+QString StyleSheetTemplate::fill(const Values &values) const
+{
+    Q_ASSERT(values.size() == PlaceholderCount);
+
+    // colors are #rrggbb
+    QString styleSheet;
+    styleSheet.reserve(m_literalLength + m_segments.size() * 7);
+
+    foreach (const Segment &segment, m_segments) {
+        styleSheet += segment.literal;
+        if (segment.placeholder != PlaceholderCount) {
+            styleSheet += values.at(segment.placeholder);
+        }
+    }
+
+    return styleSheet;
+}
+
+QString StyleSheetTemplate::name(Placeholder placeholder)
+{
+    return QLatin1String(s_placeholderNames[placeholder]);
+}
+
+}
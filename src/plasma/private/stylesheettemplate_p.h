@@ -0,0 +1,121 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PLASMA_STYLESHEETTEMPLATE_P_H
+#define PLASMA_STYLESHEETTEMPLATE_P_H
+
+#include <QString>
+#include <QVector>
+
+namespace Plasma
+{
+
+/**
+ * A style sheet with %placeholders for the theme colors and fonts, like
+ * %textcolor or %buttonbackgroundcolor, compiled once into literal
+ * segments and placeholder slots.
+ *
+ * fill() then just appends the segments and the values of the slots, so
+ * generating the style sheets of every color group and status after a
+ * palette change doesn't search or replace anything.
+ */
+class StyleSheetTemplate
+{
+public:
+    enum Placeholder {
+        TextColor = 0,
+        BackgroundColor,
+        HighlightColor,
+        HighlightedTextColor,
+        VisitedLink,
+        ActivatedLink,
+        HoveredLink,
+        Link,
+        PositiveTextColor,
+        NeutralTextColor,
+        NegativeTextColor,
+
+        ButtonTextColor,
+        ButtonBackgroundColor,
+        ButtonHoverColor,
+        ButtonFocusColor,
+        ButtonHighlightedTextColor,
+        ButtonPositiveTextColor,
+        ButtonNeutralTextColor,
+        ButtonNegativeTextColor,
+
+        ViewTextColor,
+        ViewBackgroundColor,
+        ViewHoverColor,
+        ViewFocusColor,
+        ViewHighlightedTextColor,
+        ViewPositiveTextColor,
+        ViewNeutralTextColor,
+        ViewNegativeTextColor,
+
+        ComplementaryTextColor,
+        ComplementaryBackgroundColor,
+        ComplementaryHoverColor,
+        ComplementaryFocusColor,
+        ComplementaryHighlightedTextColor,
+        ComplementaryPositiveTextColor,
+        ComplementaryNeutralTextColor,
+        ComplementaryNegativeTextColor,
+
+        FontSize,
+        FontFamily,
+        SmallFontSize,
+
+        PlaceholderCount
+    };
+
+    //the value of every placeholder, indexed by Placeholder
+    typedef QVector<QString> Values;
+
+    StyleSheetTemplate();
+    explicit StyleSheetTemplate(const QString &css);
+
+    bool isEmpty() const;
+
+    /**
+     * @returns the style sheet with the placeholders replaced by @p values
+     */
+    QString fill(const Values &values) const;
+
+    /**
+     * The placeholder as written in a style sheet, e.g. %textcolor
+     */
+    static QString name(Placeholder placeholder);
+
+private:
+    struct Segment {
+        QString literal;
+        //placeholder following the literal, PlaceholderCount if none
+        int placeholder;
+    };
+
+    QVector<Segment> m_segments;
+    int m_literalLength;
+};
+
+}
+
+Q_DECLARE_TYPEINFO(Plasma::StyleSheetTemplate, Q_MOVABLE_TYPE);
+
+#endif
@@ -20,16 +20,25 @@
 #ifndef PLASMA_SVG_P_H
 #define PLASMA_SVG_P_H
 
+#include <QCache>
 #include <QHash>
 #include <QSharedData>
 #include <QSvgRenderer>
 #include <QExplicitlySharedDataPointer>
+#include <QMutex>
 #include <QObject>
+#include <QTimer>
+
+#include "pixmapcachekey_p.h"
+#include "pixmapstore_p.h"
+#include "svgdocument_p.h"
+#include "svgsizehints_p.h"
 
 namespace Plasma
 {
 
 class Svg;
+class SvgRasterJob;
 
 class SharedSvgRenderer : public QSvgRenderer, public QSharedData
 {
@@ -38,23 +47,46 @@ public:
     typedef QExplicitlySharedDataPointer<SharedSvgRenderer> Ptr;
 
     SharedSvgRenderer(QObject *parent = 0);
+    /**
+     * @param styleSheet the effective style sheet for @p document
+     * @param interestingElements if not null, filled with the rects of the size hinted elements
+     */
     SharedSvgRenderer(
-        const QString &filename,
+        const SvgDocument::Ptr &document,
         const QString &styleSheet,
-        QHash<QString, QRectF> &interestingElements,
+        QHash<QString, QRectF> *interestingElements,
         QObject *parent = 0);
 
     SharedSvgRenderer(
         const QByteArray &contents,
         const QString &styleSheet,
-        QHash<QString, QRectF> &interestingElements,
+        QHash<QString, QRectF> *interestingElements,
         QObject *parent = 0);
 
+    /**
+     * Rough estimate of the memory used by the parsed document, in bytes:
+     * the size of the document the tree was built from
+     */
+    qint64 estimatedSize() const;
+
+    /**
+     * The file the renderer has been loaded from, empty if none
+     */
+    QString path() const;
+
+    /**
+     * QSvgRenderer is not reentrant: held while rendering or querying
+     * elements, since renderers are shared with the worker threads
+     */
+    QMutex renderMutex;
+
 private:
     bool load(
-        const QByteArray &contents,
         const QString &styleSheet,
-        QHash<QString, QRectF> &interestingElements);
+        QHash<QString, QRectF> *interestingElements);
+
+    SvgDocument::Ptr m_document;
+    qint64 m_estimatedSize;
 };
 
 class SvgPrivate
@@ -67,7 +99,7 @@ public:
     QString cacheId(const QString &elementId) const;
 
     //This function is meant for the pixmap cache
-    QString cachePath(const QString &path, const QSize &size) const;
+    PixmapCacheKey pixmapCacheKey(const QString &actualElementId, const QSize &size) const;
 
     bool setImagePath(const QString &imagePath);
 
@@ -75,6 +107,27 @@ public:
     Theme *cacheAndColorsTheme();
 
     QPixmap findInCache(const QString &elementId, qreal ratio, const QSizeF &s = QSizeF());
+    //interactive: the caller scales the result, so it can be rendered to a size bucket
+    QImage findImageInCache(const QString &elementId, qreal ratio, const QSizeF &s, bool interactive);
+    bool findCachedImage(const PixmapCacheKey &id, qreal ratio, bool interactive, QImage &image);
+    void cacheImage(const PixmapCacheKey &id, const QPixmap &p, bool interactive);
+    //ColorDependent if the rendered pixmaps change with the colors of the theme
+    PixmapStore::ImageFlags cacheFlags() const;
+
+    //Finds the element actually rendered for the requested size, taking the size hints
+    //into account, and the size in device pixels of the resulting image
+    QString resolveElementId(const QString &elementId, qreal ratio, const QSizeF &s, QSize &size);
+    void loadSizeHints();
+
+    //While interactively resized, the size bucket to render instead of size
+    QSize interactiveSize(const QString &elementId, const QSize &size);
+    void startResizing();
+    static int sizeBucket(int length);
+    QRectF renderTarget(const QString &actualElementId, const QSize &size);
+
+    int requestImage(const QSize &size, const QString &elementId);
+    void cancelImageRequest(int request);
+    void cancelImageRequests();
 
     void createRenderer();
     void eraseRenderer();
@@ -94,20 +147,36 @@ public:
     //Slots
     void themeChanged();
     void colorsChanged();
+    void imageRendered(int request, const QImage &image);
+    void resizingSettled();
+
+    struct ImageRequest {
+        SvgRasterJob *job;
+        PixmapCacheKey cacheKey;
+        qreal ratio;
+        bool interactive;
+    };
 
-    static QHash<QString, SharedSvgRenderer::Ptr> s_renderers;
+    static QHash<QString, SvgSizeHints::Ptr> s_sizeHints;
     static QWeakPointer<Theme> s_systemColorsCache;
+    static int s_lastImageRequest;
 
     Svg *q;
     QWeakPointer<Theme> theme;
     QHash<QString, QRectF> localRectCache;
-    QHash<QString, QSize> elementsWithSizeHints;
+    SvgSizeHints::Ptr sizeHints;
+    QHash<int, ImageRequest> imageRequests;
+    //renders done while resizing, kept out of the theme cache; cost in KB
+    QCache<PixmapCacheKey, QPixmap> interactivePixmaps;
+    QHash<QString, QSize> requestedSizes;
+    QTimer *settleTimer;
     SharedSvgRenderer::Ptr renderer;
     QString themePath;
     QString path;
     QSizeF size;
     QSizeF naturalSize;
-    QChar styleCrc;
+    //of the effective style sheet of the renderer
+    quint64 styleHash;
     Theme::ColorGroup colorGroup;
     unsigned int lastModified;
     qreal devicePixelRatio;
@@ -119,8 +188,12 @@ public:
     bool fromCurrentTheme : 1;
     bool applyColors : 1;
     bool usesColors : 1;
+    //the renderer got a style sheet with the colors of the theme
+    bool styledByColors : 1;
     bool cacheRendering : 1;
     bool themeFailed : 1;
+    bool interactiveResizing : 1;
+    bool resizing : 1;
 };
 
 }
@@ -0,0 +1,158 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "svgdocument_p.h"
+
+#include <QHash>
+
+#include <kcompressiondevice.h>
+
+#include "svgloader_p.h"
+
+namespace Plasma
+{
+
+// Not allowed in XML documents, so it can't be in the file
+static const char s_styleSheetMarker = '\x01';
+
+typedef QHash<QString, SvgDocument *> DocumentHash;
+Q_GLOBAL_STATIC(DocumentHash, s_documents)
+
+SvgDocument::SvgDocument()
+    : m_size(0)
+{
+}
+
+SvgDocument::~SvgDocument()
+{
+    if (!m_path.isEmpty() && !s_documents.isDestroyed() && s_documents->value(m_path) == this) {
+        s_documents->remove(m_path);
+    }
+}
+
+SvgDocument::Ptr SvgDocument::load(const QString &path)
+{
+    SvgDocument *document = s_documents->value(path);
+    if (document) {
+        return Ptr(document);
+    }
+
+    document = new SvgDocument;
+    document->m_path = path;
+
+    KCompressionDevice file(path, KCompressionDevice::GZip);
+    if (file.open(QIODevice::ReadOnly)) {
+        document->split(file.readAll());
+    }
+
+    s_documents->insert(path, document);
+    return Ptr(document);
+}
+
+SvgDocument::Ptr SvgDocument::fromContents(const QByteArray &contents)
+{
+    Ptr document(new SvgDocument);
+    document->split(contents);
+    return document;
+}
+
+void SvgDocument::split(const QByteArray &contents)
+{
+    m_size = contents.size();
+
+    const QByteArray marked = SvgLoader::process(contents, QString(QLatin1Char(s_styleSheetMarker)),
+                                                 &m_sizeHintedIds, &m_colorSchemeClasses);
+    m_segments = marked.split(s_styleSheetMarker);
+}
+
+QString SvgDocument::path() const
+{
+    return m_path;
+}
+
+qint64 SvgDocument::size() const
+{
+    return m_size;
+}
+
+bool SvgDocument::usesColorScheme() const
+{
+    return m_segments.count() > 1;
+}
+
+QStringList SvgDocument::sizeHintedIds() const
+{
+    return m_sizeHintedIds;
+}
+
+QStringList SvgDocument::colorSchemeClasses() const
+{
+    return m_colorSchemeClasses;
+}
+
+QString SvgDocument::effectiveStyleSheet(const QString &styleSheet) const
+{
+    if (!usesColorScheme()) {
+        return QString();
+    }
+
+    // The style sheet is a list of .ColorScheme-Role{color:#rrggbb;} rules,
+    // keep anything that is not a rule for an unused class
+    QString effective;
+    int start = 0;
+    while (start < styleSheet.length()) {
+        int end = styleSheet.indexOf(QLatin1Char('}'), start);
+        if (end < 0) {
+            end = styleSheet.length() - 1;
+        }
+
+        const QStringRef rule = styleSheet.midRef(start, end - start + 1);
+        const QStringRef selector = rule.left(rule.indexOf(QLatin1Char('{'))).trimmed();
+        if (!selector.startsWith(QLatin1String(".ColorScheme-")) ||
+            m_colorSchemeClasses.contains(selector.mid(1).toString())) {
+            effective += rule;
+        }
+
+        start = end + 1;
+    }
+
+    return effective;
+}
+
+QByteArray SvgDocument::contents(const QString &effectiveStyleSheet) const
+{
+    if (m_segments.count() == 1) {
+        return m_segments.first();
+    }
+
+    const QByteArray escapedStyleSheet = effectiveStyleSheet.toHtmlEscaped().toUtf8();
+
+    QByteArray contents;
+    contents.reserve(m_size + escapedStyleSheet.size() * (m_segments.count() - 1));
+    for (int i = 0; i < m_segments.count(); ++i) {
+        if (i > 0) {
+            contents += escapedStyleSheet;
+        }
+        contents += m_segments.at(i);
+    }
+
+    return contents;
+}
+
+}
@@ -0,0 +1,104 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PLASMA_SVGDOCUMENT_P_H
+#define PLASMA_SVGDOCUMENT_P_H
+
+#include <QByteArray>
+#include <QExplicitlySharedDataPointer>
+#include <QList>
+#include <QSharedData>
+#include <QStringList>
+
+namespace Plasma
+{
+
+/**
+ * The contents of an svg file, read and tokenized once and shared by all the
+ * renderers of the file, whatever the style sheet they apply.
+ *
+ * The document is split around the text of its <style id="current-color-scheme">
+ * elements, so the contents for a style sheet are built without reading or
+ * scanning the file again. The style sheet is reduced to the ColorScheme-*
+ * classes the document actually uses: color groups and statuses giving the
+ * same colors to those classes get the same contents, and a document not
+ * using the color scheme at all always gets the same contents.
+ *
+ * Only to be used from the GUI thread.
+ */
+class SvgDocument : public QSharedData
+{
+public:
+    typedef QExplicitlySharedDataPointer<SvgDocument> Ptr;
+
+    ~SvgDocument();
+
+    /**
+     * @returns the document of the svg file at @p path, only read if no
+     * other renderer of the same file is alive
+     */
+    static Ptr load(const QString &path);
+
+    /**
+     * Builds a document from already loaded contents, not shared
+     */
+    static Ptr fromContents(const QByteArray &contents);
+
+    QString path() const;
+
+    /**
+     * Size in bytes of the uncompressed document
+     */
+    qint64 size() const;
+
+    /**
+     * @returns true if the document has a current-color-scheme style element
+     */
+    bool usesColorScheme() const;
+
+    QStringList sizeHintedIds() const;
+    QStringList colorSchemeClasses() const;
+
+    /**
+     * @returns the rules of @p styleSheet for the classes used by the document,
+     * an empty string if the document doesn't use the color scheme
+     */
+    QString effectiveStyleSheet(const QString &styleSheet) const;
+
+    /**
+     * @returns the contents to feed to the renderer, with @p effectiveStyleSheet
+     * as the text of the current-color-scheme style elements
+     */
+    QByteArray contents(const QString &effectiveStyleSheet) const;
+
+private:
+    SvgDocument();
+    void split(const QByteArray &contents);
+
+    QString m_path;
+    //the document, cut where the style sheet goes
+    QList<QByteArray> m_segments;
+    QStringList m_sizeHintedIds;
+    QStringList m_colorSchemeClasses;
+    qint64 m_size;
+};
+
+}
+
+#endif
@@ -0,0 +1,659 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "svgelementsindex_p.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Plasma
+{
+
+// Bump every time the layout of the records below changes, old files are then ignored
+static const quint32 s_indexVersion = 1;
+static const char s_indexMagic[8] = {'P', 'L', 'S', 'V', 'G', 'I', 'D', 'X'};
+
+// The file is laid out as:
+// Header | ImageRecord[imageCount] | RectRecord[rectCount] | NameRecord[invalidCount]
+//        | HintRecord[hintCount] | QChar[stringsSize]
+// Every record has a size multiple of 8, so everything stays aligned once mapped.
+// All the string offsets and lengths are in QChars from the beginning of the strings pool.
+
+struct SvgElementsIndex::Header {
+    char magic[8];
+    quint32 version;
+    quint32 imageCount;
+    quint32 rectCount;
+    quint32 invalidCount;
+    quint32 hintCount;
+    quint32 stringsSize;
+    quint32 tag;
+    quint32 tagLength;
+};
+
+// sorted by hash, then path
+struct SvgElementsIndex::ImageRecord {
+    quint64 hash;
+    quint32 path;
+    quint32 pathLength;
+    quint32 firstRect;
+    quint32 rectCount;
+    quint32 firstInvalid;
+    quint32 invalidCount;
+    quint32 firstHint;
+    quint32 hintCount;
+};
+
+// sorted by hash inside the range of their image
+struct SvgElementsIndex::RectRecord {
+    quint64 hash;
+    quint32 key;
+    quint32 keyLength;
+    double x;
+    double y;
+    double width;
+    double height;
+};
+
+// sorted by hash inside the range of their image
+struct SvgElementsIndex::NameRecord {
+    quint64 hash;
+    quint32 key;
+    quint32 keyLength;
+};
+
+// sorted by element, then width inside the range of their image
+struct SvgElementsIndex::HintRecord {
+    quint32 element;
+    quint32 elementLength;
+    qint32 width;
+    qint32 height;
+};
+
+// whether [first, first + count) fits in [0, total)
+static inline bool inRange(quint32 first, quint32 count, quint32 total)
+{
+    return quint64(first) + count <= total;
+}
+
+template<typename Record>
+static const Record *lowerBoundByHash(const Record *begin, const Record *end, quint64 hash)
+{
+    return std::lower_bound(begin, end, hash, [](const Record &record, quint64 value) {
+        return record.hash < value;
+    });
+}
+
+SvgElementsIndex::SvgElementsIndex(const QString &fileName)
+    : m_file(fileName),
+      m_data(0),
+      m_size(0),
+      m_header(0),
+      m_images(0),
+      m_rects(0),
+      m_invalid(0),
+      m_hints(0),
+      m_strings(0),
+      m_tagChanged(false),
+      m_cleared(false)
+{
+    map();
+}
+
+SvgElementsIndex::~SvgElementsIndex()
+{
+    unmap();
+}
+
+QString SvgElementsIndex::fileName() const
+{
+    return m_file.fileName();
+}
+
+quint64 SvgElementsIndex::hash(const QChar *data, int length)
+{
+    // 64 bit FNV-1a
+    quint64 h = Q_UINT64_C(14695981039346656037);
+    for (int i = 0; i < length; ++i) {
+        h ^= data[i].unicode();
+        h *= Q_UINT64_C(1099511628211);
+    }
+    return h;
+}
+
+void SvgElementsIndex::map()
+{
+    unmap();
+
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    const qint64 size = m_file.size();
+    if (size < qint64(sizeof(Header))) {
+        m_file.close();
+        return;
+    }
+
+    const uchar *data = m_file.map(0, size);
+    if (!data) {
+        m_file.close();
+        return;
+    }
+
+    const Header *header = reinterpret_cast<const Header *>(data);
+    const qint64 expectedSize = qint64(sizeof(Header))
+                                + qint64(header->imageCount) * sizeof(ImageRecord)
+                                + qint64(header->rectCount) * sizeof(RectRecord)
+                                + qint64(header->invalidCount) * sizeof(NameRecord)
+                                + qint64(header->hintCount) * sizeof(HintRecord)
+                                + qint64(header->stringsSize) * sizeof(QChar);
+
+    //not an index, an index from an older version or a truncated file: ignore it, it will be rewritten
+    if (memcmp(header->magic, s_indexMagic, sizeof(s_indexMagic)) != 0 ||
+        header->version != s_indexVersion ||
+        expectedSize > size) {
+        m_file.unmap(const_cast<uchar *>(data));
+        m_file.close();
+        return;
+    }
+
+    m_data = data;
+    m_size = size;
+    m_header = header;
+    m_images = reinterpret_cast<const ImageRecord *>(m_data + sizeof(Header));
+    m_rects = reinterpret_cast<const RectRecord *>(m_images + m_header->imageCount);
+    m_invalid = reinterpret_cast<const NameRecord *>(m_rects + m_header->rectCount);
+    m_hints = reinterpret_cast<const HintRecord *>(m_invalid + m_header->invalidCount);
+    m_strings = reinterpret_cast<const QChar *>(m_hints + m_header->hintCount);
+
+    //a corrupt file: ignore it as well rather than reading out of the mapping
+    if (!isConsistent()) {
+        unmap();
+        return;
+    }
+
+    if (!m_tagChanged) {
+        m_tag = mappedString(m_header->tag, m_header->tagLength);
+    }
+}
+
+bool SvgElementsIndex::isConsistent() const
+{
+    const quint32 stringsSize = m_header->stringsSize;
+    if (!inRange(m_header->tag, m_header->tagLength, stringsSize)) {
+        return false;
+    }
+
+    for (const ImageRecord *it = m_images; it != m_images + m_header->imageCount; ++it) {
+        if (!inRange(it->path, it->pathLength, stringsSize) ||
+            !inRange(it->firstRect, it->rectCount, m_header->rectCount) ||
+            !inRange(it->firstInvalid, it->invalidCount, m_header->invalidCount) ||
+            !inRange(it->firstHint, it->hintCount, m_header->hintCount)) {
+            return false;
+        }
+    }
+
+    for (const RectRecord *it = m_rects; it != m_rects + m_header->rectCount; ++it) {
+        if (!inRange(it->key, it->keyLength, stringsSize)) {
+            return false;
+        }
+    }
+
+    for (const NameRecord *it = m_invalid; it != m_invalid + m_header->invalidCount; ++it) {
+        if (!inRange(it->key, it->keyLength, stringsSize)) {
+            return false;
+        }
+    }
+
+    for (const HintRecord *it = m_hints; it != m_hints + m_header->hintCount; ++it) {
+        if (!inRange(it->element, it->elementLength, stringsSize)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void SvgElementsIndex::unmap()
+{
+    if (m_data) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+    }
+    m_file.close();
+
+    m_data = 0;
+    m_size = 0;
+    m_header = 0;
+    m_images = 0;
+    m_rects = 0;
+    m_invalid = 0;
+    m_hints = 0;
+    m_strings = 0;
+}
+
+QString SvgElementsIndex::mappedString(quint32 offset, quint32 length) const
+{
+    if (!m_header || !inRange(offset, length, m_header->stringsSize)) {
+        return QString();
+    }
+
+    return QString(m_strings + offset, length);
+}
+
+bool SvgElementsIndex::mappedStringEquals(quint32 offset, quint32 length, const QString &string) const
+{
+    if (uint(string.size()) != length || !inRange(offset, length, m_header->stringsSize)) {
+        return false;
+    }
+
+    return memcmp(m_strings + offset, string.constData(), length * sizeof(QChar)) == 0;
+}
+
+const SvgElementsIndex::ImageRecord *SvgElementsIndex::findImage(const QString &image) const
+{
+    if (!m_header || m_cleared) {
+        return 0;
+    }
+
+    QHash<QString, PendingImage>::const_iterator pending = m_pending.constFind(image);
+    if (pending != m_pending.constEnd() && pending.value().replaced) {
+        return 0;
+    }
+
+    const quint64 h = hash(image.constData(), image.size());
+    const ImageRecord *end = m_images + m_header->imageCount;
+    for (const ImageRecord *it = lowerBoundByHash(m_images, end, h); it != end && it->hash == h; ++it) {
+        if (mappedStringEquals(it->path, it->pathLength, image)) {
+            return it;
+        }
+    }
+
+    return 0;
+}
+
+QString SvgElementsIndex::tag() const
+{
+    return m_tag;
+}
+
+void SvgElementsIndex::setTag(const QString &tag)
+{
+    if (m_tag == tag) {
+        return;
+    }
+
+    m_tag = tag;
+    m_tagChanged = true;
+}
+
+qint64 SvgElementsIndex::size() const
+{
+    return m_size;
+}
+
+bool SvgElementsIndex::findRect(const QString &image, const QString &element, QRectF &rect) const
+{
+    QHash<QString, PendingImage>::const_iterator pending = m_pending.constFind(image);
+    if (pending != m_pending.constEnd()) {
+        QHash<QString, QRectF>::const_iterator it = pending.value().rects.constFind(element);
+        if (it != pending.value().rects.constEnd()) {
+            rect = it.value();
+            return true;
+        }
+    }
+
+    const ImageRecord *imageRecord = findImage(image);
+    if (!imageRecord) {
+        return false;
+    }
+
+    const quint64 h = hash(element.constData(), element.size());
+    const RectRecord *begin = m_rects + imageRecord->firstRect;
+    const RectRecord *end = begin + imageRecord->rectCount;
+    for (const RectRecord *it = lowerBoundByHash(begin, end, h); it != end && it->hash == h; ++it) {
+        if (mappedStringEquals(it->key, it->keyLength, element)) {
+            rect = QRectF(it->x, it->y, it->width, it->height);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool SvgElementsIndex::isInvalid(const QString &image, const QString &element) const
+{
+    QHash<QString, PendingImage>::const_iterator pending = m_pending.constFind(image);
+    if (pending != m_pending.constEnd() && pending.value().invalid.contains(element)) {
+        return true;
+    }
+
+    const ImageRecord *imageRecord = findImage(image);
+    if (!imageRecord) {
+        return false;
+    }
+
+    const quint64 h = hash(element.constData(), element.size());
+    const NameRecord *begin = m_invalid + imageRecord->firstInvalid;
+    const NameRecord *end = begin + imageRecord->invalidCount;
+    for (const NameRecord *it = lowerBoundByHash(begin, end, h); it != end && it->hash == h; ++it) {
+        if (mappedStringEquals(it->key, it->keyLength, element)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+QStringList SvgElementsIndex::keys(const QString &image) const
+{
+    QStringList keys;
+
+    QHash<QString, PendingImage>::const_iterator pending = m_pending.constFind(image);
+    if (pending != m_pending.constEnd()) {
+        keys = pending.value().rects.keys();
+    }
+
+    const ImageRecord *imageRecord = findImage(image);
+    if (imageRecord) {
+        const RectRecord *end = m_rects + imageRecord->firstRect + imageRecord->rectCount;
+        for (const RectRecord *it = m_rects + imageRecord->firstRect; it != end; ++it) {
+            const QString key = mappedString(it->key, it->keyLength);
+            if (pending == m_pending.constEnd() || !pending.value().rects.contains(key)) {
+                keys << key;
+            }
+        }
+    }
+
+    return keys;
+}
+
+QHash<QString, QVector<QSize> > SvgElementsIndex::sizeHints(const QString &image) const
+{
+    QHash<QString, QVector<QSize> > hints;
+
+    const ImageRecord *imageRecord = findImage(image);
+    if (imageRecord) {
+        const HintRecord *end = m_hints + imageRecord->firstHint + imageRecord->hintCount;
+        for (const HintRecord *it = m_hints + imageRecord->firstHint; it != end; ++it) {
+            hints[mappedString(it->element, it->elementLength)] << QSize(it->width, it->height);
+        }
+    }
+
+    QHash<QString, PendingImage>::const_iterator pending = m_pending.constFind(image);
+    if (pending != m_pending.constEnd()) {
+        QHashIterator<QString, QVector<QSize> > it(pending.value().hints);
+        while (it.hasNext()) {
+            it.next();
+            QVector<QSize> &elementHints = hints[it.key()];
+            foreach (const QSize &hint, it.value()) {
+                if (!elementHints.contains(hint)) {
+                    elementHints << hint;
+                }
+            }
+        }
+    }
+
+    return hints;
+}
+
+void SvgElementsIndex::insertRect(const QString &image, const QString &element, const QRectF &rect)
+{
+    PendingImage &pending = m_pending[image];
+    pending.rects.insert(element, rect);
+    pending.invalid.remove(element);
+}
+
+void SvgElementsIndex::insertInvalid(const QString &image, const QString &element)
+{
+    QSet<QString> &invalid = m_pending[image].invalid;
+    if (invalid.contains(element)) {
+        return;
+    }
+
+    if (invalid.count() > 1000) {
+        invalid.erase(invalid.begin());
+    }
+
+    invalid.insert(element);
+}
+
+void SvgElementsIndex::insertSizeHint(const QString &image, const QString &element, const QSize &hint)
+{
+    QVector<QSize> &hints = m_pending[image].hints[element];
+    if (!hints.contains(hint)) {
+        hints << hint;
+    }
+}
+
+void SvgElementsIndex::remove(const QString &image)
+{
+    PendingImage &pending = m_pending[image];
+    pending = PendingImage();
+    pending.replaced = true;
+}
+
+void SvgElementsIndex::clear()
+{
+    m_pending.clear();
+    m_cleared = true;
+}
+
+bool SvgElementsIndex::isDirty() const
+{
+    return !m_pending.isEmpty() || m_tagChanged || m_cleared;
+}
+
+bool SvgElementsIndex::save()
+{
+    if (!isDirty()) {
+        return true;
+    }
+
+    // Another process may have saved in the meantime: merge with what is on disk now,
+    // not with what we mapped when we started
+    if (!m_cleared) {
+        map();
+    }
+
+    QHash<QString, PendingImage> images;
+
+    if (m_header && !m_cleared) {
+        for (quint32 i = 0; i < m_header->imageCount; ++i) {
+            const ImageRecord &imageRecord = m_images[i];
+            const QString path = mappedString(imageRecord.path, imageRecord.pathLength);
+
+            QHash<QString, PendingImage>::const_iterator pending = m_pending.constFind(path);
+            if (pending != m_pending.constEnd() && pending.value().replaced) {
+                continue;
+            }
+
+            PendingImage &image = images[path];
+            for (quint32 j = imageRecord.firstRect; j < imageRecord.firstRect + imageRecord.rectCount; ++j) {
+                const RectRecord &r = m_rects[j];
+                image.rects.insert(mappedString(r.key, r.keyLength), QRectF(r.x, r.y, r.width, r.height));
+            }
+            for (quint32 j = imageRecord.firstInvalid; j < imageRecord.firstInvalid + imageRecord.invalidCount; ++j) {
+                image.invalid.insert(mappedString(m_invalid[j].key, m_invalid[j].keyLength));
+            }
+            for (quint32 j = imageRecord.firstHint; j < imageRecord.firstHint + imageRecord.hintCount; ++j) {
+                const HintRecord &h = m_hints[j];
+                image.hints[mappedString(h.element, h.elementLength)] << QSize(h.width, h.height);
+            }
+        }
+    }
+
+    QHashIterator<QString, PendingImage> pendingIt(m_pending);
+    while (pendingIt.hasNext()) {
+        pendingIt.next();
+        PendingImage &image = images[pendingIt.key()];
+        const PendingImage &pending = pendingIt.value();
+
+        for (QHash<QString, QRectF>::const_iterator it = pending.rects.constBegin(); it != pending.rects.constEnd(); ++it) {
+            image.rects.insert(it.key(), it.value());
+            image.invalid.remove(it.key());
+        }
+        image.invalid.unite(pending.invalid);
+        for (QHash<QString, QVector<QSize> >::const_iterator it = pending.hints.constBegin(); it != pending.hints.constEnd(); ++it) {
+            QVector<QSize> &hints = image.hints[it.key()];
+            foreach (const QSize &hint, it.value()) {
+                if (!hints.contains(hint)) {
+                    hints << hint;
+                }
+            }
+        }
+    }
+
+    // The mapping is not needed anymore, everything has been copied
+    unmap();
+
+    QString strings;
+    auto addString = [&strings](const QString &string) {
+        const quint32 offset = strings.size();
+        strings.append(string);
+        return offset;
+    };
+
+    QVector<ImageRecord> imageRecords;
+    QVector<RectRecord> rectRecords;
+    QVector<NameRecord> invalidRecords;
+    QVector<HintRecord> hintRecords;
+
+    QHashIterator<QString, PendingImage> imagesIt(images);
+    while (imagesIt.hasNext()) {
+        imagesIt.next();
+        const PendingImage &image = imagesIt.value();
+        if (image.rects.isEmpty() && image.invalid.isEmpty() && image.hints.isEmpty()) {
+            continue;
+        }
+
+        ImageRecord imageRecord;
+        imageRecord.hash = hash(imagesIt.key().constData(), imagesIt.key().size());
+        imageRecord.pathLength = imagesIt.key().size();
+        imageRecord.path = addString(imagesIt.key());
+
+        imageRecord.firstRect = rectRecords.size();
+        imageRecord.rectCount = image.rects.size();
+        for (QHash<QString, QRectF>::const_iterator it = image.rects.constBegin(); it != image.rects.constEnd(); ++it) {
+            RectRecord r;
+            r.hash = hash(it.key().constData(), it.key().size());
+            r.keyLength = it.key().size();
+            r.key = addString(it.key());
+            r.x = it.value().x();
+            r.y = it.value().y();
+            r.width = it.value().width();
+            r.height = it.value().height();
+            rectRecords << r;
+        }
+        std::sort(rectRecords.begin() + imageRecord.firstRect, rectRecords.end(), [](const RectRecord &a, const RectRecord &b) {
+            return a.hash < b.hash;
+        });
+
+        imageRecord.firstInvalid = invalidRecords.size();
+        imageRecord.invalidCount = image.invalid.size();
+        foreach (const QString &element, image.invalid) {
+            NameRecord n;
+            n.hash = hash(element.constData(), element.size());
+            n.keyLength = element.size();
+            n.key = addString(element);
+            invalidRecords << n;
+        }
+        std::sort(invalidRecords.begin() + imageRecord.firstInvalid, invalidRecords.end(), [](const NameRecord &a, const NameRecord &b) {
+            return a.hash < b.hash;
+        });
+
+        imageRecord.firstHint = hintRecords.size();
+        QStringList hintedElements = image.hints.keys();
+        std::sort(hintedElements.begin(), hintedElements.end());
+        foreach (const QString &element, hintedElements) {
+            QVector<QSize> hints = image.hints.value(element);
+            std::sort(hints.begin(), hints.end(), [](const QSize &a, const QSize &b) {
+                return a.width() < b.width() || (a.width() == b.width() && a.height() < b.height());
+            });
+            const quint32 offset = addString(element);
+            foreach (const QSize &hint, hints) {
+                HintRecord h;
+                h.element = offset;
+                h.elementLength = element.size();
+                h.width = hint.width();
+                h.height = hint.height();
+                hintRecords << h;
+            }
+        }
+        imageRecord.hintCount = hintRecords.size() - imageRecord.firstHint;
+
+        imageRecords << imageRecord;
+    }
+
+    std::sort(imageRecords.begin(), imageRecords.end(), [&strings](const ImageRecord &a, const ImageRecord &b) {
+        if (a.hash != b.hash) {
+            return a.hash < b.hash;
+        }
+        return QStringRef(&strings, a.path, a.pathLength) < QStringRef(&strings, b.path, b.pathLength);
+    });
+
+    Header header;
+    memcpy(header.magic, s_indexMagic, sizeof(s_indexMagic));
+    header.version = s_indexVersion;
+    header.imageCount = imageRecords.size();
+    header.rectCount = rectRecords.size();
+    header.invalidCount = invalidRecords.size();
+    header.hintCount = hintRecords.size();
+    header.tagLength = m_tag.size();
+    header.tag = addString(m_tag);
+    header.stringsSize = strings.size();
+
+    QByteArray data;
+    data.reserve(sizeof(Header) + imageRecords.size() * sizeof(ImageRecord) + rectRecords.size() * sizeof(RectRecord)
+                 + invalidRecords.size() * sizeof(NameRecord) + hintRecords.size() * sizeof(HintRecord)
+                 + strings.size() * sizeof(QChar));
+    data.append(reinterpret_cast<const char *>(&header), sizeof(Header));
+    data.append(reinterpret_cast<const char *>(imageRecords.constData()), imageRecords.size() * sizeof(ImageRecord));
+    data.append(reinterpret_cast<const char *>(rectRecords.constData()), rectRecords.size() * sizeof(RectRecord));
+    data.append(reinterpret_cast<const char *>(invalidRecords.constData()), invalidRecords.size() * sizeof(NameRecord));
+    data.append(reinterpret_cast<const char *>(hintRecords.constData()), hintRecords.size() * sizeof(HintRecord));
+    data.append(reinterpret_cast<const char *>(strings.constData()), strings.size() * sizeof(QChar));
+
+    QDir().mkpath(QFileInfo(m_file.fileName()).absolutePath());
+
+    // QSaveFile writes a temporary file and renames it over the old one:
+    // whoever still has the old file mapped is not affected
+    QSaveFile file(m_file.fileName());
+    bool saved = file.open(QIODevice::WriteOnly);
+    if (saved) {
+        file.write(data);
+        saved = file.commit();
+    }
+
+    if (saved) {
+        m_pending.clear();
+        m_tagChanged = false;
+        m_cleared = false;
+    }
+
+    map();
+
+    return saved;
+}
+
+}
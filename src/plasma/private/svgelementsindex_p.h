@@ -0,0 +1,147 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PLASMA_SVGELEMENTSINDEX_P_H
+#define PLASMA_SVGELEMENTSINDEX_P_H
+
+#include <QFile>
+#include <QHash>
+#include <QRectF>
+#include <QSet>
+#include <QSize>
+#include <QStringList>
+#include <QVector>
+
+namespace Plasma
+{
+
+/**
+ * Binary, memory mapped index of the element rects of the svgs of a theme.
+ *
+ * The file on disk is never modified in place: all the lookups go to the
+ * read only mapping (shared by every process using the same theme), new
+ * entries are kept in memory and save() merges them with the current
+ * contents of the file, writing a new version that atomically replaces
+ * the old one. Processes still holding the old mapping keep working on it.
+ *
+ * For every image path the index holds the element rects, the set of
+ * elements known to be invalid and the size hints of the elements
+ * (the ones with an id in the form width-height-elementid).
+ */
+class SvgElementsIndex
+{
+public:
+    explicit SvgElementsIndex(const QString &fileName);
+    ~SvgElementsIndex();
+
+    QString fileName() const;
+
+    /**
+     * A free form string saved in the index, used to detect when something
+     * cached along with it is outdated (e.g. the colors changed)
+     */
+    QString tag() const;
+    void setTag(const QString &tag);
+
+    /**
+     * Size of the mapped index, in bytes. Entries not saved yet aren't counted.
+     */
+    qint64 size() const;
+
+    bool findRect(const QString &image, const QString &element, QRectF &rect) const;
+    bool isInvalid(const QString &image, const QString &element) const;
+    QStringList keys(const QString &image) const;
+    QHash<QString, QVector<QSize> > sizeHints(const QString &image) const;
+
+    void insertRect(const QString &image, const QString &element, const QRectF &rect);
+    void insertInvalid(const QString &image, const QString &element);
+    void insertSizeHint(const QString &image, const QString &element, const QSize &hint);
+
+    /**
+     * Forgets everything about @p image, both in memory and, at the next save(), on disk
+     */
+    void remove(const QString &image);
+
+    /**
+     * Forgets everything, the file will be rewritten from scratch at the next save()
+     */
+    void clear();
+
+    bool isDirty() const;
+
+    /**
+     * Merges the entries added since the last save with the current contents
+     * of the file and writes the result in a new file replacing the old one.
+     */
+    bool save();
+
+    /**
+     * Stable across processes, unlike qHash()
+     */
+    static quint64 hash(const QChar *data, int length);
+
+private:
+    struct ImageRecord;
+    struct RectRecord;
+    struct NameRecord;
+    struct HintRecord;
+    struct Header;
+
+    struct PendingImage {
+        PendingImage()
+            : replaced(false)
+        {
+        }
+
+        QHash<QString, QRectF> rects;
+        QSet<QString> invalid;
+        QHash<QString, QVector<QSize> > hints;
+        //entries on disk for this image are obsolete
+        bool replaced;
+    };
+
+    void map();
+    void unmap();
+    /**
+     * Whether all the ranges of the mapped records fit in the mapping
+     */
+    bool isConsistent() const;
+    const ImageRecord *findImage(const QString &image) const;
+    QString mappedString(quint32 offset, quint32 length) const;
+    bool mappedStringEquals(quint32 offset, quint32 length, const QString &string) const;
+
+    QFile m_file;
+    const uchar *m_data;
+    qint64 m_size;
+    const Header *m_header;
+    const ImageRecord *m_images;
+    const RectRecord *m_rects;
+    const NameRecord *m_invalid;
+    const HintRecord *m_hints;
+    const QChar *m_strings;
+
+    QHash<QString, PendingImage> m_pending;
+    QString m_tag;
+    bool m_tagChanged : 1;
+    bool m_cleared : 1;
+};
+
+}
+
+#endif
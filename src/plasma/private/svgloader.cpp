@@ -0,0 +1,256 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "svgloader_p.h"
+
+#include <cstring>
+
+namespace Plasma
+{
+
+static inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+static inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static inline bool startsWith(const char *p, const char *end, const char *literal, int length)
+{
+    return end - p >= length && memcmp(p, literal, length) == 0;
+}
+
+// @returns the position of the first occurrence of @p literal in [p, end), or 0
+static const char *find(const char *p, const char *end, const char *literal, int length)
+{
+    while (end - p >= length) {
+        p = static_cast<const char *>(memchr(p, literal[0], end - p - length + 1));
+        if (!p) {
+            return 0;
+        }
+        if (memcmp(p, literal, length) == 0) {
+            return p;
+        }
+        ++p;
+    }
+
+    return 0;
+}
+
+bool SvgLoader::isSizeHinted(const char *id, int length)
+{
+    const char *p = id;
+    const char *end = id + length;
+
+    // width-height-, both at least one digit
+    for (int i = 0; i < 2; ++i) {
+        const char *number = p;
+        while (p < end && isDigit(*p)) {
+            ++p;
+        }
+        if (p == number || p == end || *p != '-') {
+            return false;
+        }
+        ++p;
+    }
+
+    return true;
+}
+
+static void collectColorSchemeClasses(const char *value, int length, QStringList *classes)
+{
+    const char *p = value;
+    const char *end = value + length;
+
+    while (p < end) {
+        while (p < end && isSpace(*p)) {
+            ++p;
+        }
+        const char *name = p;
+        while (p < end && !isSpace(*p)) {
+            ++p;
+        }
+
+        if (startsWith(name, p, "ColorScheme-", 12)) {
+            const QString colorSchemeClass = QString::fromUtf8(name, p - name);
+            if (!classes->contains(colorSchemeClass)) {
+                classes->append(colorSchemeClass);
+            }
+        }
+    }
+}
+
+QByteArray SvgLoader::process(const QByteArray &contents, const QString &styleSheet,
+                              QStringList *sizeHintedIds, QStringList *colorSchemeClasses)
+{
+    const char *const data = contents.constData();
+    const char *const end = data + contents.size();
+    const char *p = data;
+
+    // Only allocated once something has to be replaced,
+    // everything before copied is still to be appended to it
+    QByteArray result;
+    const char *copied = data;
+    QByteArray escapedStyleSheet;
+
+    while (p < end) {
+        p = static_cast<const char *>(memchr(p, '<', end - p));
+        if (!p || ++p == end) {
+            break;
+        }
+
+        if (*p == '!') {
+            if (startsWith(p, end, "!--", 3)) {
+                p = find(p + 3, end, "-->", 3);
+                p = p ? p + 3 : end;
+            } else if (startsWith(p, end, "![CDATA[", 8)) {
+                p = find(p + 8, end, "]]>", 3);
+                p = p ? p + 3 : end;
+            } else {
+                // doctype, possibly with an internal subset between brackets
+                int depth = 0;
+                while (p < end && (*p != '>' || depth > 0)) {
+                    if (*p == '[') {
+                        ++depth;
+                    } else if (*p == ']') {
+                        --depth;
+                    }
+                    ++p;
+                }
+            }
+            continue;
+        } else if (*p == '?') {
+            p = find(p + 1, end, "?>", 2);
+            p = p ? p + 2 : end;
+            continue;
+        } else if (*p == '/') {
+            // end tag, nothing interesting up to the next '<'
+            continue;
+        }
+
+        // start tag
+        const char *name = p;
+        while (p < end && !isSpace(*p) && *p != '>' && *p != '/') {
+            ++p;
+        }
+        const bool isStyle = (p - name == 5 && memcmp(name, "style", 5) == 0);
+        bool isColorSchemeStyle = false;
+
+        // attributes
+        while (p < end) {
+            while (p < end && isSpace(*p)) {
+                ++p;
+            }
+            if (p == end || *p == '>' || *p == '/') {
+                break;
+            }
+
+            const char *attributeName = p;
+            while (p < end && !isSpace(*p) && *p != '=' && *p != '>' && *p != '/') {
+                ++p;
+            }
+            const int attributeNameLength = p - attributeName;
+
+            while (p < end && isSpace(*p)) {
+                ++p;
+            }
+            if (p == end || *p != '=') {
+                continue;
+            }
+            ++p;
+            while (p < end && isSpace(*p)) {
+                ++p;
+            }
+            if (p == end || (*p != '"' && *p != '\'')) {
+                continue;
+            }
+
+            const char quote = *p++;
+            const char *value = p;
+            p = static_cast<const char *>(memchr(p, quote, end - p));
+            if (!p) {
+                p = end;
+                break;
+            }
+            const int valueLength = p - value;
+            ++p;
+
+            if (attributeNameLength == 2 && attributeName[0] == 'i' && attributeName[1] == 'd') {
+                if (isStyle && valueLength == 20 && memcmp(value, "current-color-scheme", 20) == 0) {
+                    isColorSchemeStyle = true;
+                } else if (sizeHintedIds && isSizeHinted(value, valueLength)) {
+                    sizeHintedIds->append(QString::fromUtf8(value, valueLength));
+                }
+            } else if (colorSchemeClasses && attributeNameLength == 5 && memcmp(attributeName, "class", 5) == 0) {
+                collectColorSchemeClasses(value, valueLength, colorSchemeClasses);
+            }
+        }
+
+        if (p == end) {
+            break;
+        }
+
+        const char *slash = (*p == '/') ? p : 0;
+        const char *tagEnd = static_cast<const char *>(memchr(p, '>', end - p));
+        if (!tagEnd) {
+            break;
+        }
+        p = tagEnd + 1;
+
+        if (!isColorSchemeStyle || styleSheet.isEmpty()) {
+            continue;
+        }
+
+        if (escapedStyleSheet.isNull()) {
+            escapedStyleSheet = styleSheet.toHtmlEscaped().toUtf8();
+            result.reserve(contents.size() + escapedStyleSheet.size());
+        }
+
+        if (slash) {
+            // <style id="current-color-scheme"/>: open it to put the style sheet in
+            result.append(copied, slash - copied);
+            result.append('>');
+            result.append(escapedStyleSheet);
+            result.append("</style>");
+            copied = p;
+        } else {
+            result.append(copied, p - copied);
+            result.append(escapedStyleSheet);
+            // drop the old text, keep the end tag
+            const char *endTag = find(p, end, "</style", 7);
+            if (!endTag) {
+                copied = end;
+                break;
+            }
+            copied = p = endTag;
+        }
+    }
+
+    if (result.isNull()) {
+        return contents;
+    }
+
+    result.append(copied, end - copied);
+    return result;
+}
+
+}
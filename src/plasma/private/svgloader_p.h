@@ -0,0 +1,59 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PLASMA_SVGLOADER_P_H
+#define PLASMA_SVGLOADER_P_H
+
+#include <QByteArray>
+#include <QStringList>
+
+namespace Plasma
+{
+
+/**
+ * Prepares the contents of an svg file for QSvgRenderer in a single pass over the bytes.
+ *
+ * The text of the <style id="current-color-scheme"> element is replaced with the
+ * given style sheet, the ids in the form width-height-elementid and the
+ * ColorScheme-* classes used by the elements are collected.
+ * Comments, CDATA sections, processing instructions and the doctype are skipped.
+ */
+class SvgLoader
+{
+public:
+    /**
+     * @param contents the uncompressed svg document
+     * @param styleSheet the style sheet to apply, nothing is replaced if empty
+     * @param sizeHintedIds if not null, filled with the size hinted element ids, in document order
+     * @param colorSchemeClasses if not null, filled with the ColorScheme-* classes used, each one once
+     * @returns the contents to feed to the renderer, @p contents itself
+     *          (no copy) if there was nothing to replace
+     */
+    static QByteArray process(const QByteArray &contents, const QString &styleSheet,
+                              QStringList *sizeHintedIds = 0, QStringList *colorSchemeClasses = 0);
+
+    /**
+     * @returns true if @p id is in the form width-height-elementid
+     */
+    static bool isSizeHinted(const char *id, int length);
+};
+
+}
+
+#endif
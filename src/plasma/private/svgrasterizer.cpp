@@ -0,0 +1,166 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "svgrasterizer_p.h"
+
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QPainter>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+#include "cachestatistics_p.h"
+#include "imagecolorizer_p.h"
+#include "svgrendererpool_p.h"
+
+namespace Plasma
+{
+
+class SvgRasterPool : public QThreadPool
+{
+public:
+    SvgRasterPool()
+    {
+        // renderers are shared and serialized anyway, more threads than that would just wait
+        setMaxThreadCount(qBound(1, QThread::idealThreadCount() - 1, 4));
+    }
+};
+
+Q_GLOBAL_STATIC(SvgRasterPool, s_rasterPool)
+
+// Deleted by the pool in the worker thread, unlike the job
+class SvgRasterRunnable : public QRunnable
+{
+public:
+    SvgRasterRunnable(SvgRasterJob *job)
+        : m_job(job)
+    {
+    }
+
+    void run() Q_DECL_OVERRIDE
+    {
+        m_job->run();
+    }
+
+private:
+    SvgRasterJob *m_job;
+};
+
+SvgRasterJob::SvgRasterJob(int request, const SharedSvgRenderer::Ptr &renderer, const QString &elementId,
+                           const QSize &size, const QRectF &target, qreal devicePixelRatio,
+                           const QColor &colorizeColor)
+    : QObject(),
+      m_renderer(renderer),
+      m_elementId(elementId),
+      m_size(size),
+      m_target(target),
+      m_devicePixelRatio(devicePixelRatio),
+      m_colorizeColor(colorizeColor),
+      m_request(request),
+      m_cancelled(0)
+{
+}
+
+SvgRasterJob::~SvgRasterJob()
+{
+    // the job may be the last one using the renderer
+    if (SvgRendererPool *pool = SvgRendererPool::self()) {
+        pool->release(m_renderer);
+    }
+}
+
+int SvgRasterJob::request() const
+{
+    return m_request;
+}
+
+void SvgRasterJob::cancel()
+{
+    m_cancelled.store(1);
+}
+
+bool SvgRasterJob::isCancelled() const
+{
+    return m_cancelled.load();
+}
+
+void SvgRasterJob::start()
+{
+    pool()->start(new SvgRasterRunnable(this));
+}
+
+void SvgRasterJob::run()
+{
+    if (!isCancelled()) {
+        const QImage image = render(m_renderer.data(), m_elementId, m_size, m_target, m_devicePixelRatio, m_colorizeColor);
+
+        if (!isCancelled()) {
+            emit finished(m_request, image);
+        }
+    }
+
+    // posted after finished(), so the GUI thread gets the image before the job goes away
+    deleteLater();
+}
+
+QImage SvgRasterJob::render(SharedSvgRenderer *renderer, const QString &elementId,
+                            const QSize &size, const QRectF &target, qreal devicePixelRatio,
+                            const QColor &colorizeColor)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    {
+        QPainter renderPainter(&image);
+        QMutexLocker lock(&renderer->renderMutex);
+
+        if (elementId.isEmpty()) {
+            renderer->render(&renderPainter, target);
+        } else {
+            renderer->render(&renderPainter, elementId, target);
+        }
+    }
+
+    // Apply current color scheme if the svg asks for it
+    if (colorizeColor.isValid()) {
+        ImageColorizer::colorize(image, colorizeColor);
+    }
+
+    image.setDevicePixelRatio(devicePixelRatio);
+
+    const QString path = renderer->path();
+    if (!path.isEmpty()) {
+        CacheStatistics::self()->addRenderTime(path, timer.nsecsElapsed());
+    }
+
+    return image;
+}
+
+QThreadPool *SvgRasterJob::pool()
+{
+    return s_rasterPool();
+}
+
+}
+
+#include "moc_svgrasterizer_p.cpp"
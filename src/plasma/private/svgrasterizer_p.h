@@ -0,0 +1,103 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PLASMA_SVGRASTERIZER_P_H
+#define PLASMA_SVGRASTERIZER_P_H
+
+#include <QAtomicInt>
+#include <QColor>
+#include <QImage>
+#include <QObject>
+
+#include "svg_p.h"
+
+class QThreadPool;
+
+namespace Plasma
+{
+
+/**
+ * Renders an element of a SharedSvgRenderer into a QImage in a worker thread.
+ *
+ * The job is created in the GUI thread and deletes itself there once run,
+ * so the reference to the renderer is only released in the GUI thread.
+ * finished() is emitted from the worker thread, connect to it with a
+ * queued connection.
+ */
+class SvgRasterJob : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param target where to render the element in the image, in device pixels
+     * @param colorizeColor if valid, the image is colorized with it after rendering
+     */
+    SvgRasterJob(int request, const SharedSvgRenderer::Ptr &renderer, const QString &elementId,
+                 const QSize &size, const QRectF &target, qreal devicePixelRatio,
+                 const QColor &colorizeColor);
+    ~SvgRasterJob();
+
+    int request() const;
+
+    /**
+     * Thread safe. The job won't render if it didn't start yet and
+     * finished() won't be emitted anymore.
+     */
+    void cancel();
+    bool isCancelled() const;
+
+    /**
+     * Queues the job in pool()
+     */
+    void start();
+
+    /**
+     * Renders synchronously in the calling thread
+     */
+    static QImage render(SharedSvgRenderer *renderer, const QString &elementId,
+                         const QSize &size, const QRectF &target, qreal devicePixelRatio,
+                         const QColor &colorizeColor);
+
+    /**
+     * The pool running all the jobs, its size is bounded to leave cores for the GUI thread
+     */
+    static QThreadPool *pool();
+
+Q_SIGNALS:
+    void finished(int request, const QImage &image);
+
+private:
+    void run();
+
+    friend class SvgRasterRunnable;
+
+    SharedSvgRenderer::Ptr m_renderer;
+    QString m_elementId;
+    QSize m_size;
+    QRectF m_target;
+    qreal m_devicePixelRatio;
+    QColor m_colorizeColor;
+    int m_request;
+    QAtomicInt m_cancelled;
+};
+
+}
+
+#endif
@@ -0,0 +1,196 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "svgrendererpool_p.h"
+
+#include "libplasma-theme-global.h"
+
+namespace Plasma
+{
+
+Q_GLOBAL_STATIC(SvgRendererPool, s_rendererPool)
+
+SvgRendererPool::SvgRendererPool(QObject *parent)
+    : QObject(parent),
+      m_size(0),
+      m_unusedSize(0),
+      m_gracePeriod(0)
+{
+    ThemeConfig config;
+    m_budget = qint64(config.svgRendererCacheKb()) * 1024;
+
+    m_clock.start();
+    m_gracePeriod = config.svgRendererGracePeriod() * 1000;
+    m_expireTimer.setSingleShot(true);
+    connect(&m_expireTimer, SIGNAL(timeout()), this, SLOT(evictExpired()));
+}
+
+SvgRendererPool::~SvgRendererPool()
+{
+}
+
+SvgRendererPool *SvgRendererPool::self()
+{
+    return s_rendererPool();
+}
+
+SharedSvgRenderer::Ptr SvgRendererPool::renderer(const QString &key)
+{
+    QHash<QString, Entry>::iterator it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return SharedSvgRenderer::Ptr();
+    }
+
+    it->lastUsed = m_clock.elapsed();
+    if (m_released.removeOne(key)) {
+        m_unusedSize -= it->renderer->estimatedSize();
+    }
+    return it->renderer;
+}
+
+void SvgRendererPool::insert(const QString &key, const SharedSvgRenderer::Ptr &renderer)
+{
+    QHash<QString, Entry>::iterator it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        m_size -= it->renderer->estimatedSize();
+        m_keys.remove(it->renderer.data());
+        if (m_released.removeOne(key)) {
+            m_unusedSize -= it->renderer->estimatedSize();
+        }
+    } else {
+        it = m_entries.insert(key, Entry());
+    }
+
+    it->renderer = renderer;
+    it->lastUsed = m_clock.elapsed();
+    m_keys.insert(renderer.data(), key);
+    m_size += renderer->estimatedSize();
+
+    evict();
+}
+
+void SvgRendererPool::release(SharedSvgRenderer::Ptr &renderer)
+{
+    if (!renderer) {
+        return;
+    }
+
+    const QString key = m_keys.value(renderer.data());
+    renderer = 0;
+
+    QHash<QString, Entry>::iterator it = m_entries.find(key);
+    if (it == m_entries.end() || it->renderer->ref.load() > 1) {
+        return;
+    }
+
+    it->lastUsed = m_clock.elapsed();
+    m_released.append(key);
+    m_unusedSize += it->renderer->estimatedSize();
+
+    evict();
+}
+
+void SvgRendererPool::clearUnused()
+{
+    foreach (const QString &key, m_released) {
+        remove(key);
+    }
+
+    m_released.clear();
+    m_expireTimer.stop();
+}
+
+void SvgRendererPool::evictExpired()
+{
+    evict();
+}
+
+void SvgRendererPool::remove(const QString &key)
+{
+    QHash<QString, Entry>::iterator it = m_entries.find(key);
+    m_size -= it->renderer->estimatedSize();
+    //only unused renderers get removed
+    m_unusedSize -= it->renderer->estimatedSize();
+    m_keys.remove(it->renderer.data());
+    m_entries.erase(it);
+}
+
+void SvgRendererPool::evict()
+{
+    const qint64 now = m_clock.elapsed();
+
+    while (!m_released.isEmpty()) {
+        const qint64 unusedFor = now - m_entries.constFind(m_released.first())->lastUsed;
+        if (unusedFor < m_gracePeriod && m_unusedSize <= m_budget) {
+            // wake up when the least recently used one expires
+            m_expireTimer.start(m_gracePeriod - unusedFor);
+            return;
+        }
+
+        remove(m_released.takeFirst());
+    }
+
+    m_expireTimer.stop();
+}
+
+int SvgRendererPool::count() const
+{
+    return m_entries.count();
+}
+
+int SvgRendererPool::unusedCount() const
+{
+    return m_released.count();
+}
+
+qint64 SvgRendererPool::estimatedSize() const
+{
+    return m_size;
+}
+
+qint64 SvgRendererPool::unusedSize() const
+{
+    return m_unusedSize;
+}
+
+qint64 SvgRendererPool::budget() const
+{
+    return m_budget;
+}
+
+void SvgRendererPool::setBudget(qint64 bytes)
+{
+    m_budget = bytes;
+    evict();
+}
+
+int SvgRendererPool::gracePeriod() const
+{
+    return m_gracePeriod;
+}
+
+void SvgRendererPool::setGracePeriod(int msecs)
+{
+    m_gracePeriod = msecs;
+    evict();
+}
+
+}
+
+#include "moc_svgrendererpool_p.cpp"
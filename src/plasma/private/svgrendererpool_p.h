@@ -0,0 +1,118 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PLASMA_SVGRENDERERPOOL_P_H
+#define PLASMA_SVGRENDERERPOOL_P_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+
+#include "svg_p.h"
+
+namespace Plasma
+{
+
+/**
+ * The parsed svgs shared by all the Svg instances of the process.
+ *
+ * Renderers nobody uses anymore are kept for a grace period, so an Svg
+ * quickly recreated (e.g. by a delegate) doesn't parse its file again, and
+ * are then dropped, least recently used first. When the estimated size of
+ * the unused renderers goes over the budget, the least recently used ones
+ * are dropped right away. Renderers in use are never dropped and don't
+ * count against the budget.
+ *
+ * Only to be used from the GUI thread.
+ */
+class SvgRendererPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SvgRendererPool(QObject *parent = 0);
+    ~SvgRendererPool();
+
+    static SvgRendererPool *self();
+
+    /**
+     * @returns the renderer for @p key, or a null pointer
+     */
+    SharedSvgRenderer::Ptr renderer(const QString &key);
+
+    void insert(const QString &key, const SharedSvgRenderer::Ptr &renderer);
+
+    /**
+     * Drops the reference held by @p renderer: if nobody else uses the
+     * renderer, it becomes a candidate for eviction.
+     */
+    void release(SharedSvgRenderer::Ptr &renderer);
+
+    /**
+     * Drops all the renderers not in use, regardless of the grace period
+     */
+    void clearUnused();
+
+    int count() const;
+    int unusedCount() const;
+
+    /**
+     * Estimated memory used by all the renderers, in bytes
+     */
+    qint64 estimatedSize() const;
+
+    /**
+     * Estimated memory used by the renderers nobody uses, in bytes
+     */
+    qint64 unusedSize() const;
+
+    qint64 budget() const;
+    void setBudget(qint64 bytes);
+    int gracePeriod() const;
+    void setGracePeriod(int msecs);
+
+private Q_SLOTS:
+    void evictExpired();
+
+private:
+    struct Entry {
+        SharedSvgRenderer::Ptr renderer;
+        qint64 lastUsed;
+    };
+
+    void evict();
+    void remove(const QString &key);
+
+    QHash<QString, Entry> m_entries;
+    QHash<const SharedSvgRenderer *, QString> m_keys;
+    //keys of the renderers nobody uses, least recently used first
+    QStringList m_released;
+    QElapsedTimer m_clock;
+    QTimer m_expireTimer;
+    qint64 m_size;
+    qint64 m_unusedSize;
+    qint64 m_budget;
+    int m_gracePeriod;
+};
+
+}
+
+#endif
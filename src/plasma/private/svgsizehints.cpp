@@ -0,0 +1,168 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "svgsizehints_p.h"
+
+#include <algorithm>
+
+#include <QStringBuilder>
+
+namespace Plasma
+{
+
+struct SvgSizeHints::Entry {
+    QString elementId;
+    QSize hint;
+    QString id;
+};
+
+static inline qint64 area(const QSize &size)
+{
+    return qint64(size.width()) * size.height();
+}
+
+SvgSizeHints::SvgSizeHints(const QStringList &sizeHintedIds)
+{
+    QVector<Entry> entries;
+    entries.reserve(sizeHintedIds.count());
+
+    foreach (const QString &id, sizeHintedIds) {
+        Entry entry;
+        if (parse(id, entry.hint, entry.elementId)) {
+            entry.id = id;
+            entries << entry;
+        }
+    }
+
+    build(entries);
+}
+
+SvgSizeHints::SvgSizeHints(const QHash<QString, QVector<QSize> > &hints)
+{
+    QVector<Entry> entries;
+
+    QHashIterator<QString, QVector<QSize> > it(hints);
+    while (it.hasNext()) {
+        it.next();
+        foreach (const QSize &hint, it.value()) {
+            if (hint.isValid()) {
+                Entry entry;
+                entry.elementId = it.key();
+                entry.hint = hint;
+                entry.id = QString::number(hint.width()) % QLatin1Char('-') %
+                           QString::number(hint.height()) % QLatin1Char('-') % it.key();
+                entries << entry;
+            }
+        }
+    }
+
+    build(entries);
+}
+
+void SvgSizeHints::build(QVector<Entry> &entries)
+{
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        if (a.elementId != b.elementId) {
+            return a.elementId < b.elementId;
+        }
+        if (area(a.hint) != area(b.hint)) {
+            return area(a.hint) < area(b.hint);
+        }
+        return a.hint.width() < b.hint.width();
+    });
+
+    m_hints.reserve(entries.count());
+    foreach (const Entry &entry, entries) {
+        if (m_elements.isEmpty() || m_elements.last().id != entry.elementId) {
+            Element element;
+            element.id = entry.elementId;
+            element.first = m_hints.count();
+            element.count = 0;
+            m_elements << element;
+        } else if (m_hints.last().size == entry.hint) {
+            //the same hint twice
+            continue;
+        }
+
+        Hint hint;
+        hint.size = entry.hint;
+        hint.id = entry.id;
+        m_hints << hint;
+        ++m_elements.last().count;
+    }
+}
+
+bool SvgSizeHints::isEmpty() const
+{
+    return m_elements.isEmpty();
+}
+
+QString SvgSizeHints::bestFit(const QString &elementId, const QSize &size) const
+{
+    auto element = std::lower_bound(m_elements.constBegin(), m_elements.constEnd(), elementId,
+                                    [](const Element &e, const QString &id) {
+                                        return e.id < id;
+                                    });
+
+    if (element == m_elements.constEnd() || element->id != elementId) {
+        return QString();
+    }
+
+    // Nothing smaller than the requested area can fit: skip it and take the first
+    // one big enough in both directions, the hints being sorted by area.
+    const Hint *end = m_hints.constData() + element->first + element->count;
+    const Hint *hint = std::lower_bound(m_hints.constData() + element->first, end, area(size),
+                                        [](const Hint &h, qint64 a) {
+                                            return area(h.size) < a;
+                                        });
+
+    for (; hint != end; ++hint) {
+        if (hint->size.width() >= size.width() && hint->size.height() >= size.height()) {
+            return hint->id;
+        }
+    }
+
+    return QString();
+}
+
+bool SvgSizeHints::parse(const QString &id, QSize &hint, QString &elementId)
+{
+    const int first = id.indexOf(QLatin1Char('-'));
+    if (first < 1) {
+        return false;
+    }
+
+    const int second = id.indexOf(QLatin1Char('-'), first + 1);
+    if (second < first + 2 || second == id.length() - 1) {
+        return false;
+    }
+
+    bool widthOk = false;
+    bool heightOk = false;
+    hint = QSize(id.leftRef(first).toInt(&widthOk),
+                 id.midRef(first + 1, second - first - 1).toInt(&heightOk));
+    if (!widthOk || !heightOk || !hint.isValid()) {
+        return false;
+    }
+
+    elementId = id.mid(second + 1);
+    return true;
+}
+
+}
@@ -0,0 +1,91 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PLASMA_SVGSIZEHINTS_P_H
+#define PLASMA_SVGSIZEHINTS_P_H
+
+#include <QExplicitlySharedDataPointer>
+#include <QHash>
+#include <QSharedData>
+#include <QSize>
+#include <QStringList>
+#include <QVector>
+
+namespace Plasma
+{
+
+/**
+ * The size hinted elements of an svg file (the ones with an id in the form
+ * width-height-elementid), built once per file and shared by all the Svg
+ * instances using it.
+ *
+ * Elements are sorted by id and the hints of each element by area, so
+ * finding the best hint for a size is a couple of binary searches.
+ */
+class SvgSizeHints : public QSharedData
+{
+public:
+    typedef QExplicitlySharedDataPointer<SvgSizeHints> Ptr;
+
+    /**
+     * Builds the table from the full ids of the size hinted elements
+     */
+    explicit SvgSizeHints(const QStringList &sizeHintedIds);
+
+    /**
+     * Builds the table from the hints in the form saved in the elements index
+     */
+    explicit SvgSizeHints(const QHash<QString, QVector<QSize> > &hints);
+
+    bool isEmpty() const;
+
+    /**
+     * @returns the full id of the smallest hinted version of @p elementId
+     * at least as big as @p size, or an empty string if there is none
+     */
+    QString bestFit(const QString &elementId, const QSize &size) const;
+
+    /**
+     * Splits a width-height-elementid id.
+     * @returns false if @p id has no valid size hint
+     */
+    static bool parse(const QString &id, QSize &hint, QString &elementId);
+
+private:
+    struct Element {
+        QString id;
+        int first;
+        int count;
+    };
+
+    struct Hint {
+        QSize size;
+        QString id;
+    };
+
+    struct Entry;
+    void build(QVector<Entry> &entries);
+
+    QVector<Element> m_elements;
+    QVector<Hint> m_hints;
+};
+
+}
+
+#endif
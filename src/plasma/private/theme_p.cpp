@@ -22,11 +22,22 @@
 #include "framesvg.h"
 #include "framesvg_p.h"
 #include "debug_p.h"
+#include "cachestatistics_p.h"
+#include "framebackgroundcache_p.h"
+#include "stylesheettemplate_p.h"
+#include "svgrendererpool_p.h"
+#include "themefileindex_p.h"
 
 #include <QGuiApplication>
+#include <QDir>
 #include <QFile>
 #include <QFileInfo>
 #include <QFontDatabase>
+#include <QCryptographicHash>
+#include <QMap>
+#include <QRegularExpression>
+#include <QRunnable>
+#include <QThreadPool>
 
 #include <kdirwatch.h>
 #include <kwindoweffects.h>
@@ -52,16 +63,18 @@ QHash<QString, QAtomicInt> ThemePrivate::themesRefCount = QHash<QString, QAtomic
 
 ThemePrivate::ThemePrivate(QObject *parent)
     : QObject(parent),
-      colorScheme(QPalette::Active, KColorScheme::Window, KSharedConfigPtr(0)),
-      selectionColorScheme(QPalette::Active, KColorScheme::Selection, KSharedConfigPtr(0)),
-      buttonColorScheme(QPalette::Active, KColorScheme::Button, KSharedConfigPtr(0)),
-      viewColorScheme(QPalette::Active, KColorScheme::View, KSharedConfigPtr(0)),
-      complementaryColorScheme(QPalette::Active, KColorScheme::Complementary, KSharedConfigPtr(0)),
+      filledColorGroups(0),
       defaultWallpaperTheme(DEFAULT_WALLPAPER_THEME),
       defaultWallpaperSuffix(DEFAULT_WALLPAPER_SUFFIX),
       defaultWallpaperWidth(DEFAULT_WALLPAPER_WIDTH),
       defaultWallpaperHeight(DEFAULT_WALLPAPER_HEIGHT),
+      wallpaperCatalogue(0),
       pixmapCache(0),
+      pixmapWriter(new PixmapCacheWriter(this)),
+      svgElementsCache(0),
+      frameMasks(MAX_FRAME_MASKS),
+      compiledElementsIndex(0),
+      styleSheetTemplates(MAX_STYLE_SHEET_TEMPLATES),
       cacheSize(0),
       cachesToDiscard(NoCache),
       locolor(false),
@@ -71,6 +84,7 @@ ThemePrivate::ThemePrivate(QObject *parent)
       useGlobal(true),
       hasWallpapers(false),
       fixedName(false),
+      compiledElementsLoaded(false),
       backgroundContrast(0),
       backgroundIntensity(0),
       backgroundSaturation(0),
@@ -123,6 +137,14 @@ ThemePrivate::ThemePrivate(QObject *parent)
     // ... but also remove/recreate cycles, like KConfig does it
     connect(KDirWatch::self(), &KDirWatch::created, this, &ThemePrivate::settingsFileChanged);
 
+    // files added to or removed from a theme
+    connect(ThemeFileIndex::self(), &ThemeFileIndex::themeChanged, this, [this]() {
+        discoveries.clear();
+        delete wallpaperCatalogue;
+        wallpaperCatalogue = 0;
+        closeCompiledElements();
+    });
+
     QObject::connect(KIconLoader::global(), &KIconLoader::iconChanged,
         this, [this]() {
             scheduleThemeChangeNotification(PixmapCache|SvgElementsCache);
@@ -134,9 +156,14 @@ ThemePrivate::ThemePrivate(QObject *parent)
 ThemePrivate::~ThemePrivate()
 {
     saveSvgElementsCache();
-    QHash<QString, FrameData*> data = FrameSvgPrivate::s_sharedFrames.take(this);
+    QHash<PixmapCacheKey, FrameData*> data = FrameSvgPrivate::s_sharedFrames.take(this);
     qDeleteAll(data);
-    delete pixmapCache;
+    FrameSvgPrivate::s_ninePatches.remove(this);
+    FrameSvgPrivate::s_frameMetrics.remove(this);
+    closePixmapCache();
+    delete svgElementsCache;
+    delete compiledElementsIndex;
+    delete wallpaperCatalogue;
 }
 
 KConfigGroup &ThemePrivate::config()
@@ -162,15 +189,12 @@ KConfigGroup &ThemePrivate::config()
 
 bool ThemePrivate::useCache()
 {
-    bool cachesTooOld = false;
-
     if (cacheTheme && !pixmapCache) {
         if (cacheSize == 0) {
             ThemeConfig config;
             cacheSize = config.themeCacheKb();
         }
         const bool isRegularTheme = themeName != QLatin1String(systemColorsTheme);
-        QString cacheFile = QLatin1String("plasma_theme_") + themeName;
 
         // clear any cached values from the previous theme cache
         themeVersion.clear();
@@ -178,25 +202,20 @@ bool ThemePrivate::useCache()
         if (!themeMetadataPath.isEmpty()) {
             KDirWatch::self()->removeFile(themeMetadataPath);
         }
-        if (isRegularTheme) {
-            themeMetadataPath = QStandardPaths::locate(QStandardPaths::GenericDataLocation, QLatin1Literal(PLASMA_RELATIVE_DATA_INSTALL_DIR "/desktoptheme/") % themeName % QLatin1Literal("/metadata.desktop"));
-            const auto *iconTheme = KIconLoader::global()->theme();
-            if (iconTheme) {
-                iconThemeMetadataPath = iconTheme->dir() + "index.theme";
-            }
+        iconThemeMetadataPath.clear();
+        const auto *iconTheme = KIconLoader::global()->theme();
+        if (iconTheme) {
+            iconThemeMetadataPath = iconTheme->dir() + "index.theme";
+        }
 
+        if (isRegularTheme) {
+            themeMetadataPath = imagePath(themeName, QStringLiteral("/"), QStringLiteral("metadata.desktop"));
             Q_ASSERT(!themeMetadataPath.isEmpty() || themeName.isEmpty());
-            const QString cacheFileBase = cacheFile + QLatin1String("*.kcache");
 
-            QString currentCacheFileName;
             if (!themeMetadataPath.isEmpty()) {
                 // now we record the theme version, if we can
                 const KPluginInfo pluginInfo(themeMetadataPath);
                 themeVersion = pluginInfo.version();
-                if (!themeVersion.isEmpty()) {
-                    cacheFile += QLatin1String("_v") + themeVersion;
-                    currentCacheFileName = cacheFile + QLatin1String(".kcache");
-                }
 
                 // watch the metadata file for changes at runtime
                 KDirWatch::self()->addFile(themeMetadataPath);
@@ -211,91 +230,351 @@ bool ThemePrivate::useCache()
                     KDirWatch::self()->addFile(iconThemeMetadataPath);
                 }
             }
+        }
 
-            // now we check for, and remove if necessary, old caches
-            foreach (const QString &file, QStandardPaths::locateAll(QStandardPaths::GenericCacheLocation, cacheFileBase)) {
-                if (currentCacheFileName.isEmpty() ||
-                        !file.endsWith(currentCacheFileName)) {
-                    QFile::remove(file);
-                }
-            }
+        // The caches of another version of the theme or of the icon theme have
+        // another name: no need to compare any time stamp, and whatever doesn't
+        // match is stale
+        cacheFingerprint = computeCacheFingerprint();
+        removeStaleCaches();
+
+        pixmapCache = new PixmapStore(cacheFilePath(QLatin1String("plasma_theme_"), QLatin1String(".pixmaps")),
+                                      qint64(cacheSize) * 1024);
+        pixmapWriter->setStore(pixmapCache);
+    }
 
+    if (cacheTheme && !svgElementsCache) {
+        svgElementsCache = new SvgElementsIndex(cacheFilePath(QLatin1String("plasma-svgelements-"), QString()));
+
+        // The pixmaps using the colors are only good for the colors they have
+        // been rendered with, which may have changed while no application was running
+        const QString colors = colorsFingerprint();
+        if (svgElementsCache->tag() != colors) {
+            pixmapWriter->discard(PixmapStore::ColorDependent);
+            pixmapCache->discard(PixmapStore::ColorDependent);
+            svgElementsCache->setTag(colors);
+            QMetaObject::invokeMethod(rectSaveTimer, "start");
         }
+    }
 
-        // now we do a sanity check: if the metadata.desktop file is newer than the cache, drop the cache
-        if (isRegularTheme && !themeMetadataPath.isEmpty()) {
-            // now we check to see if the theme metadata file itself is newer than the pixmap cache
-            // this is done before creating the pixmapCache object since that can change the mtime
-            // on the cache file
+    return cacheTheme;
+}
 
-            // FIXME: when using the system colors, if they change while the application is not running
-            // the cache should be dropped; we need a way to detect system color change when the
-            // application is not running.
-            // check for expired cache
-            const QString cacheFilePath = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + '/' + cacheFile + QLatin1String(".kcache");
-            if (!cacheFilePath.isEmpty()) {
-                const QFileInfo cacheFileInfo(cacheFilePath);
-                const QFileInfo metadataFileInfo(themeMetadataPath);
-                const QFileInfo iconThemeMetadataFileInfo(iconThemeMetadataPath);
+QString ThemePrivate::cacheFilePath(const QString &prefix, const QString &suffix) const
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) % QLatin1Char('/') %
+           prefix % themeName % QLatin1Char('_') % cacheFingerprint % suffix;
+}
 
-                cachesTooOld = (cacheFileInfo.lastModified().toTime_t() < metadataFileInfo.lastModified().toTime_t()) ||
-                        (cacheFileInfo.lastModified().toTime_t() < iconThemeMetadataFileInfo.lastModified().toTime_t());
-            }
-        }
+QString ThemePrivate::computeCacheFingerprint() const
+{
+    // Everything the pixmaps and the rects of the elements depend on, but the colors
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(themeName.toUtf8());
+    hash.addData(themeVersion.toUtf8());
+
+    QFile metadata(themeMetadataPath);
+    if (!themeMetadataPath.isEmpty() && metadata.open(QIODevice::ReadOnly)) {
+        hash.addData(&metadata);
+    }
 
-        ThemeConfig config;
-        pixmapCache = new KImageCache(cacheFile, config.themeCacheKb() * 1024);
+    // files added to or removed from the theme, the index already has them
+    if (themeName != QLatin1String(systemColorsTheme)) {
+        QStringList files = ThemeFileIndex::self()->files(themeName);
+        files.sort();
+        hash.addData(files.join(QLatin1Char('\n')).toUtf8());
+    }
 
-        if (cachesTooOld) {
-            discardCache(PixmapCache | SvgElementsCache);
-        }
+    hash.addData(iconThemeMetadataPath.toUtf8());
+    QFile iconThemeMetadata(iconThemeMetadataPath);
+    if (!iconThemeMetadataPath.isEmpty() && iconThemeMetadata.open(QIODevice::ReadOnly)) {
+        hash.addData(&iconThemeMetadata);
     }
 
-    if (cacheTheme && !svgElementsCache) {
-        const QString svgElementsFileNameBase = QLatin1String("plasma-svgelements-") + themeName;
-        QString svgElementsFileName = svgElementsFileNameBase;
-        if (!themeVersion.isEmpty()) {
-            svgElementsFileName += QLatin1String("_v") + themeVersion;
+    return QString::fromLatin1(hash.result().toHex().left(16));
+}
+
+QString ThemePrivate::colorsFingerprint() const
+{
+    // The entries the color schemes are read from rather than the colors themselves,
+    // so that the color tables are still only filled for the groups actually used
+    static const char *const colorGroups[] = {
+        "Colors:Window",
+        "Colors:Button",
+        "Colors:View",
+        "Colors:Selection",
+        "Colors:Complementary"
+    };
+
+    const KSharedConfigPtr colorsConfig = colors ? colors : KSharedConfig::openConfig();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    for (uint i = 0; i < sizeof(colorGroups) / sizeof(colorGroups[0]); ++i) {
+        hash.addData(QByteArray(colorGroups[i]));
+        const QMap<QString, QString> entries = colorsConfig->group(colorGroups[i]).entryMap();
+        for (QMap<QString, QString>::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it) {
+            hash.addData(QString(it.key() % QLatin1Char('=') % it.value() % QLatin1Char('\n')).toUtf8());
         }
+    }
 
-        // now we check for (and remove) old caches
-        foreach (const QString &file, QStandardPaths::locateAll(QStandardPaths::GenericCacheLocation, svgElementsFileNameBase + QLatin1Char('*'))) {
-            if (cachesTooOld || !file.endsWith(svgElementsFileName)) {
-                QFile::remove(file);
+    return QString::fromLatin1(hash.result().toHex().left(16));
+}
+
+// Removes the cache files of a theme but the current ones, off the GUI thread
+class StaleCacheCleaner : public QRunnable
+{
+public:
+    StaleCacheCleaner(const QString &themeName, const QStringList &currentFiles)
+        : m_cacheDir(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)),
+          m_currentFiles(currentFiles)
+    {
+        // the complete names only, the temporary files QSaveFile is writing
+        // (<name>.XXXXXX) and the files of the other themes are left alone:
+        // <prefix><theme>_<fingerprint><suffix>, including the <prefix><theme><suffix>
+        // and <prefix><theme>_v<version><suffix> names of the KImageCache files
+        // and svg elements caches used before the caches had a fingerprint
+        const QString theme = QRegularExpression::escape(themeName);
+        const QString name = QStringLiteral("(_[0-9a-f]{16}|_v[^_]*)?");
+        m_pattern.setPattern(QLatin1String("^(plasma_theme_") % theme % name % QLatin1String("\\.(kcache|pixmaps)|plasma-svgelements-") %
+                             theme % name % QLatin1String(")$"));
+    }
+
+    void run() Q_DECL_OVERRIDE
+    {
+        foreach (const QString &file, m_cacheDir.entryList(QDir::Files)) {
+            if (m_pattern.match(file).hasMatch() && !m_currentFiles.contains(file)) {
+                QFile::remove(m_cacheDir.absoluteFilePath(file));
             }
         }
+    }
 
-        const QString svgElementsFile = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + '/' + svgElementsFileName;
-        svgElementsCache = KSharedConfig::openConfig(svgElementsFile);
-        QString currentIconThemePath;
-        const auto *iconTheme = KIconLoader::global()->theme();
-        if (iconTheme) {
-            currentIconThemePath = iconTheme->dir();
-        }
-        KConfigGroup globalGroup(svgElementsCache, QLatin1String("Global"));
-        const QString oldIconThemePath = globalGroup.readEntry("currentIconThemePath", QString());
-        if (oldIconThemePath != currentIconThemePath) {
-            discardCache(PixmapCache | SvgElementsCache);
-            globalGroup.writeEntry("currentIconThemePath", currentIconThemePath);
-            svgElementsCache = KSharedConfig::openConfig(svgElementsFile);
-        }
+private:
+    const QDir m_cacheDir;
+    const QStringList m_currentFiles;
+    QRegularExpression m_pattern;
+};
+
+void ThemePrivate::removeStaleCaches()
+{
+    const QStringList currentFiles = QStringList()
+            << QFileInfo(cacheFilePath(QLatin1String("plasma_theme_"), QLatin1String(".pixmaps"))).fileName()
+            << QFileInfo(cacheFilePath(QLatin1String("plasma-svgelements-"), QString())).fileName();
+
+    QThreadPool::globalInstance()->start(new StaleCacheCleaner(themeName, currentFiles));
+}
+
+const SvgElementsIndex *ThemePrivate::compiledElements()
+{
+    if (compiledElementsLoaded) {
+        return compiledElementsIndex;
     }
 
-    return cacheTheme;
+    compiledElementsLoaded = true;
+    const QString path = imagePath(themeName, QStringLiteral("/"), QStringLiteral("elements.index"));
+    if (path.isEmpty()) {
+        return 0;
+    }
+
+    // an index compiled from another version of the theme would give wrong rects
+    compiledElementsIndex = new SvgElementsIndex(path);
+    if (compiledElementsIndex->tag().isEmpty() || compiledElementsIndex->tag() != pluginInfo.version()) {
+        delete compiledElementsIndex;
+        compiledElementsIndex = 0;
+        return 0;
+    }
+
+    compiledElementsDir = QFileInfo(path).path() + QLatin1Char('/');
+    return compiledElementsIndex;
 }
 
-void ThemePrivate::onAppExitCleanup()
+bool ThemePrivate::findInCompiledElements(const QString &image, const QString &elementId, qreal scaleFactor, QRectF &rect)
+{
+    const SvgElementsIndex *index = compiledElements();
+    if (!index || !image.startsWith(compiledElementsDir)) {
+        return false;
+    }
+
+    // the rects have been measured at the natural size of the svgs, with a scale factor of 1
+    const QString relativeImage = image.mid(compiledElementsDir.length());
+    const QString element = elementId.isEmpty() ? QStringLiteral("_Natural_1")
+                                                : QLatin1String("Natural_") % elementId % QLatin1String("_0_1");
+    if (index->findRect(relativeImage, element, rect)) {
+        rect = QRectF(rect.topLeft() * scaleFactor, rect.size() * scaleFactor);
+        return true;
+    }
+
+    rect = QRectF();
+    return !elementId.isEmpty() && index->isInvalid(relativeImage, element);
+}
+
+QHash<QString, QVector<QSize> > ThemePrivate::compiledSizeHints(const QString &image)
+{
+    const SvgElementsIndex *index = compiledElements();
+    if (!index || !image.startsWith(compiledElementsDir)) {
+        return QHash<QString, QVector<QSize> >();
+    }
+
+    return index->sizeHints(image.mid(compiledElementsDir.length()));
+}
+
+void ThemePrivate::closeCompiledElements()
+{
+    delete compiledElementsIndex;
+    compiledElementsIndex = 0;
+    compiledElementsDir.clear();
+    compiledElementsLoaded = false;
+}
+
+bool ThemePrivate::findInCache(const PixmapCacheKey &key, QPixmap &pix, unsigned int lastModified)
 {
-    pixmapsToCache.clear();
+    if (!useCache() || (lastModified != 0 && lastModified > uint(pixmapCache->lastModifiedTime().toTime_t()))) {
+        return false;
+    }
+
+    if (pixmapWriter->find(key, &pix)) {
+        CacheStatistics::self()->count(CacheStatistics::PendingPixmapHit);
+        return true;
+    }
+
+    const bool found = pixmapCache->findPixmap(key.toString(), &pix) && !pix.isNull();
+    CacheStatistics::self()->count(found ? CacheStatistics::PixmapCacheHit : CacheStatistics::PixmapCacheMiss);
+    return found;
+}
+
+bool ThemePrivate::findInCache(const PixmapCacheKey &key, QImage &image, unsigned int lastModified)
+{
+    if (!useCache() || (lastModified != 0 && lastModified > uint(pixmapCache->lastModifiedTime().toTime_t()))) {
+        return false;
+    }
+
+    if (pixmapWriter->find(key, &image)) {
+        CacheStatistics::self()->count(CacheStatistics::PendingPixmapHit);
+        return true;
+    }
+
+    const bool found = pixmapCache->findImage(key.toString(), &image) && !image.isNull();
+    CacheStatistics::self()->count(found ? CacheStatistics::PixmapCacheHit : CacheStatistics::PixmapCacheMiss);
+    return found;
+}
+
+void ThemePrivate::insertIntoCache(const PixmapCacheKey &key, const QPixmap &pix, const PixmapCacheOwner &owner,
+                                   PixmapStore::ImageFlags flags)
+{
+    if (!useCache()) {
+        return;
+    }
+
+    pixmapWriter->insert(key, pix, owner, flags);
+
+    //always start timer in pixmapSaveTimer's thread
+    QMetaObject::invokeMethod(pixmapSaveTimer, "start", Qt::QueuedConnection);
+}
+
+void ThemePrivate::closePixmapCache()
+{
+    // what is waiting stays in the queue for the next store
+    pixmapWriter->setStore(0);
     delete pixmapCache;
     pixmapCache = 0;
+}
+
+void ThemePrivate::onAppExitCleanup()
+{
+    if (qEnvironmentVariableIsSet("PLASMA_CACHE_STATISTICS")) {
+        dumpCacheStatistics();
+    }
+
+    pixmapWriter->clear();
+    closePixmapCache();
     cacheTheme = false;
 }
 
+QVariantMap ThemePrivate::cacheStatistics() const
+{
+    CacheStatistics *statistics = CacheStatistics::self();
+
+    QVariantMap map;
+    for (int i = 0; i < CacheStatistics::CounterCount; ++i) {
+        const CacheStatistics::Counter counter = CacheStatistics::Counter(i);
+        map.insert(CacheStatistics::counterName(counter), statistics->value(counter));
+    }
+
+    map.insert(QStringLiteral("pixmapCacheBytes"), pixmapCache ? pixmapCache->size() : 0);
+    map.insert(QStringLiteral("pixmapCacheBudget"), pixmapCache ? pixmapCache->budget() : 0);
+    map.insert(QStringLiteral("pendingPixmapBytes"), pixmapWriter->size());
+    map.insert(QStringLiteral("rectsCacheBytes"), svgElementsCache ? svgElementsCache->size() : 0);
+
+    SvgRendererPool *rendererPool = SvgRendererPool::self();
+    map.insert(QStringLiteral("renderers"), rendererPool->count());
+    map.insert(QStringLiteral("rendererBytes"), rendererPool->estimatedSize());
+    map.insert(QStringLiteral("unusedRenderers"), rendererPool->unusedCount());
+    map.insert(QStringLiteral("unusedRendererBytes"), rendererPool->unusedSize());
+
+    const QHash<PixmapCacheKey, FrameData *> frames = FrameSvgPrivate::s_sharedFrames.value(const_cast<ThemePrivate *>(this));
+    qint64 frameBytes = 0;
+    foreach (const FrameData *frame, frames) {
+        const QPixmap &background = frame->cachedBackground;
+        frameBytes += qint64(background.width()) * background.height() * background.depth() / 8;
+    }
+    map.insert(QStringLiteral("frames"), frames.count());
+    map.insert(QStringLiteral("frameBytes"), frameBytes);
+
+    const QHash<PixmapCacheKey, NinePatch::Ptr> ninePatches = FrameSvgPrivate::s_ninePatches.value(const_cast<ThemePrivate *>(this));
+    qint64 ninePatchBytes = 0;
+    foreach (const NinePatch::Ptr &ninePatch, ninePatches) {
+        ninePatchBytes += ninePatch->size();
+    }
+    map.insert(QStringLiteral("ninePatches"), ninePatches.count());
+    map.insert(QStringLiteral("ninePatchBytes"), ninePatchBytes);
+    map.insert(QStringLiteral("renderedFrameBytes"), FrameBackgroundCache::self()->size());
+    map.insert(QStringLiteral("frameBudget"), FrameBackgroundCache::self()->budget());
+
+    QVariantMap renderTimes;
+    const QHash<QString, CacheStatistics::RenderTimes> times = statistics->renderTimes();
+    for (QHash<QString, CacheStatistics::RenderTimes>::const_iterator it = times.constBegin(); it != times.constEnd(); ++it) {
+        QVariantList buckets;
+        foreach (int count, it.value()) {
+            buckets << count;
+        }
+        renderTimes.insert(it.key(), buckets);
+    }
+    map.insert(QStringLiteral("renderTimes"), renderTimes);
+
+    return map;
+}
+
+void ThemePrivate::dumpCacheStatistics() const
+{
+    const QVariantMap statistics = cacheStatistics();
+
+    qCDebug(LOG_PLASMA) << "Cache statistics of the theme" << themeName;
+    for (QVariantMap::const_iterator it = statistics.constBegin(); it != statistics.constEnd(); ++it) {
+        if (it.key() != QLatin1String("renderTimes")) {
+            qCDebug(LOG_PLASMA) << "   " << it.key() << it.value().toLongLong();
+        }
+    }
+
+    // slowest images first
+    QMultiMap<qint64, QString> byTotal;
+    const QHash<QString, CacheStatistics::RenderTimes> times = CacheStatistics::self()->renderTimes();
+    for (QHash<QString, CacheStatistics::RenderTimes>::const_iterator it = times.constBegin(); it != times.constEnd(); ++it) {
+        // rough, every render counted at the upper bound of its bucket
+        qint64 total = 0;
+        for (int bucket = 0; bucket < it.value().count(); ++bucket) {
+            total += qint64(it.value().at(bucket)) << bucket;
+        }
+        byTotal.insert(-total, it.key());
+    }
+
+    qCDebug(LOG_PLASMA) << "    render times, renders under 1, 2, 4 ... 128ms and longer:";
+    for (QMultiMap<qint64, QString>::const_iterator it = byTotal.constBegin(); it != byTotal.constEnd(); ++it) {
+        qCDebug(LOG_PLASMA) << "   " << it.value() << times.value(it.value());
+    }
+}
+
 QString ThemePrivate::imagePath(const QString& theme, const QString& type, const QString& image)
 {
-    QString subdir = QLatin1Literal(PLASMA_RELATIVE_DATA_INSTALL_DIR "/desktoptheme/") % theme % type % image;
-    return QStandardPaths::locate(QStandardPaths::GenericDataLocation, subdir);
+    // a hash lookup, whether the file exists or not
+    return ThemeFileIndex::self()->locate(theme, type % image);
 }
 
 QString ThemePrivate::findInTheme(const QString &image, const QString &theme, bool cache)
@@ -343,43 +622,69 @@ void ThemePrivate::compositingChanged(bool active)
 
 void ThemePrivate::discardCache(CacheTypes caches)
 {
+    // the patches of the frames are rendered pixmaps too
+    FrameSvgPrivate::s_ninePatches.remove(this);
+    if (caches & SvgElementsCache) {
+        // measured from the elements, which may be others now
+        FrameSvgPrivate::s_frameMetrics.remove(this);
+    }
+    if (caches & (PixmapCache | SvgElementsCache)) {
+        // the colors don't change the shape of the frames
+        frameMasks.clear();
+    }
+
     if (caches & PixmapCache) {
-        pixmapsToCache.clear();
+        pixmapWriter->clear();
         pixmapSaveTimer->stop();
         if (pixmapCache) {
             pixmapCache->clear();
         }
+    } else if (caches & ColorDependentPixmapCache) {
+        // the pixmaps of the svgs not using the colors are still good
+        pixmapWriter->discard(PixmapStore::ColorDependent);
+        if (pixmapCache) {
+            pixmapCache->discard(PixmapStore::ColorDependent);
+        }
+        if (svgElementsCache) {
+            svgElementsCache->setTag(colorsFingerprint());
+            QMetaObject::invokeMethod(rectSaveTimer, "start");
+        }
     } else {
         // This deletes the object but keeps the on-disk cache for later use
-        delete pixmapCache;
-        pixmapCache = 0;
+        closePixmapCache();
     }
 
     cachedDefaultStyleSheet = QString();
+    cachedStyleSheetValues.clear();
     cachedSvgStyleSheets.clear();
     cachedSelectedSvgStyleSheets.clear();
 
     if (caches & SvgElementsCache) {
         discoveries.clear();
-        invalidElements.clear();
 
+        // This deletes the index but keeps the entries on disk for later use
+        saveSvgElementsCache();
+        delete svgElementsCache;
         svgElementsCache = 0;
+        closeCompiledElements();
+
+        // both are reopened together, under the fingerprint of the theme as it is now
+        closePixmapCache();
     }
 }
 
 void ThemePrivate::scheduledCacheUpdate()
 {
     if (useCache()) {
-        QHashIterator<QString, QPixmap> it(pixmapsToCache);
-        while (it.hasNext()) {
-            it.next();
-            pixmapCache->insertPixmap(idsToCache[it.key()], it.value());
+        // Only what the public Theme API inserted is written right away,
+        // the pixmaps of the Svgs are written in the background
+        if (pixmapCache->isDirty()) {
+            pixmapCache->save();
         }
+        pixmapWriter->flush();
+    } else {
+        pixmapWriter->clear();
     }
-
-    pixmapsToCache.clear();
-    keysToCache.clear();
-    idsToCache.clear();
 }
 
 void ThemePrivate::colorsChanged()
@@ -389,11 +694,9 @@ void ThemePrivate::colorsChanged()
     if (!colors) {
         KSharedConfig::openConfig()->reparseConfiguration();
     }
-    colorScheme = KColorScheme(QPalette::Active, KColorScheme::Window, colors);
-    buttonColorScheme = KColorScheme(QPalette::Active, KColorScheme::Button, colors);
-    viewColorScheme = KColorScheme(QPalette::Active, KColorScheme::View, colors);
-    selectionColorScheme = KColorScheme(QPalette::Active, KColorScheme::Selection, colors);
-    scheduleThemeChangeNotification(PixmapCache | SvgElementsCache);
+    filledColorGroups = 0;
+    // the rects of the elements and the pixmaps not using the colors don't change
+    scheduleThemeChangeNotification(ColorDependentPixmapCache);
     emit applicationPaletteChange();
 }
 
@@ -411,13 +714,83 @@ void ThemePrivate::notifyOfChanged()
     emit themeChanged();
 }
 
+// The colors of the style sheet placeholders
+struct PlaceholderColor {
+    StyleSheetTemplate::Placeholder placeholder;
+    Theme::ColorRole role;
+    //when rendering a selected Svg
+    Theme::ColorRole selectedRole;
+    Theme::ColorGroup group;
+};
+
+static const PlaceholderColor s_placeholderColors[] = {
+    {StyleSheetTemplate::TextColor, Theme::TextColor, Theme::HighlightedTextColor, Theme::NormalColorGroup},
+    {StyleSheetTemplate::BackgroundColor, Theme::BackgroundColor, Theme::HighlightColor, Theme::NormalColorGroup},
+    {StyleSheetTemplate::HighlightColor, Theme::HighlightColor, Theme::HighlightColor, Theme::NormalColorGroup},
+    {StyleSheetTemplate::HighlightedTextColor, Theme::HighlightedTextColor, Theme::HighlightedTextColor, Theme::NormalColorGroup},
+    {StyleSheetTemplate::VisitedLink, Theme::VisitedLinkColor, Theme::VisitedLinkColor, Theme::NormalColorGroup},
+    {StyleSheetTemplate::ActivatedLink, Theme::HighlightColor, Theme::HighlightColor, Theme::NormalColorGroup},
+    {StyleSheetTemplate::HoveredLink, Theme::HighlightColor, Theme::HighlightColor, Theme::NormalColorGroup},
+    {StyleSheetTemplate::Link, Theme::LinkColor, Theme::LinkColor, Theme::NormalColorGroup},
+    {StyleSheetTemplate::PositiveTextColor, Theme::PositiveTextColor, Theme::PositiveTextColor, Theme::NormalColorGroup},
+    {StyleSheetTemplate::NeutralTextColor, Theme::NeutralTextColor, Theme::NeutralTextColor, Theme::NormalColorGroup},
+    {StyleSheetTemplate::NegativeTextColor, Theme::NegativeTextColor, Theme::NegativeTextColor, Theme::NormalColorGroup},
+
+    {StyleSheetTemplate::ButtonTextColor, Theme::TextColor, Theme::HighlightedTextColor, Theme::ButtonColorGroup},
+    {StyleSheetTemplate::ButtonBackgroundColor, Theme::BackgroundColor, Theme::HighlightColor, Theme::ButtonColorGroup},
+    {StyleSheetTemplate::ButtonHoverColor, Theme::HoverColor, Theme::HoverColor, Theme::ButtonColorGroup},
+    {StyleSheetTemplate::ButtonFocusColor, Theme::FocusColor, Theme::FocusColor, Theme::ButtonColorGroup},
+    {StyleSheetTemplate::ButtonHighlightedTextColor, Theme::HighlightedTextColor, Theme::HighlightedTextColor, Theme::ButtonColorGroup},
+    {StyleSheetTemplate::ButtonPositiveTextColor, Theme::PositiveTextColor, Theme::PositiveTextColor, Theme::ButtonColorGroup},
+    {StyleSheetTemplate::ButtonNeutralTextColor, Theme::NeutralTextColor, Theme::NeutralTextColor, Theme::ButtonColorGroup},
+    {StyleSheetTemplate::ButtonNegativeTextColor, Theme::NegativeTextColor, Theme::NegativeTextColor, Theme::ButtonColorGroup},
+
+    {StyleSheetTemplate::ViewTextColor, Theme::TextColor, Theme::HighlightedTextColor, Theme::ViewColorGroup},
+    {StyleSheetTemplate::ViewBackgroundColor, Theme::BackgroundColor, Theme::HighlightColor, Theme::ViewColorGroup},
+    {StyleSheetTemplate::ViewHoverColor, Theme::HoverColor, Theme::HoverColor, Theme::ViewColorGroup},
+    {StyleSheetTemplate::ViewFocusColor, Theme::FocusColor, Theme::FocusColor, Theme::ViewColorGroup},
+    {StyleSheetTemplate::ViewHighlightedTextColor, Theme::HighlightedTextColor, Theme::HighlightedTextColor, Theme::ViewColorGroup},
+    {StyleSheetTemplate::ViewPositiveTextColor, Theme::PositiveTextColor, Theme::PositiveTextColor, Theme::ViewColorGroup},
+    {StyleSheetTemplate::ViewNeutralTextColor, Theme::NeutralTextColor, Theme::NeutralTextColor, Theme::ViewColorGroup},
+    {StyleSheetTemplate::ViewNegativeTextColor, Theme::NegativeTextColor, Theme::NegativeTextColor, Theme::ViewColorGroup},
+
+    {StyleSheetTemplate::ComplementaryTextColor, Theme::TextColor, Theme::HighlightedTextColor, Theme::ComplementaryColorGroup},
+    {StyleSheetTemplate::ComplementaryBackgroundColor, Theme::BackgroundColor, Theme::HighlightColor, Theme::ComplementaryColorGroup},
+    {StyleSheetTemplate::ComplementaryHoverColor, Theme::HoverColor, Theme::HoverColor, Theme::ComplementaryColorGroup},
+    {StyleSheetTemplate::ComplementaryFocusColor, Theme::FocusColor, Theme::FocusColor, Theme::ComplementaryColorGroup},
+    {StyleSheetTemplate::ComplementaryHighlightedTextColor, Theme::HighlightedTextColor, Theme::HighlightedTextColor, Theme::ComplementaryColorGroup},
+    {StyleSheetTemplate::ComplementaryPositiveTextColor, Theme::PositiveTextColor, Theme::PositiveTextColor, Theme::ComplementaryColorGroup},
+    {StyleSheetTemplate::ComplementaryNeutralTextColor, Theme::NeutralTextColor, Theme::NeutralTextColor, Theme::ComplementaryColorGroup},
+    {StyleSheetTemplate::ComplementaryNegativeTextColor, Theme::NegativeTextColor, Theme::NegativeTextColor, Theme::ComplementaryColorGroup}
+};
+
+const StyleSheetTemplate::Values &ThemePrivate::styleSheetValues(Plasma::Svg::Status status)
+{
+    QHash<int, StyleSheetTemplate::Values>::iterator it = cachedStyleSheetValues.find(int(status));
+    if (it != cachedStyleSheetValues.end()) {
+        return it.value();
+    }
+
+    StyleSheetTemplate::Values values(StyleSheetTemplate::PlaceholderCount);
+    const bool selected = status == Svg::Status::Selected;
+    for (uint i = 0; i < sizeof(s_placeholderColors) / sizeof(s_placeholderColors[0]); ++i) {
+        const PlaceholderColor &placeholder = s_placeholderColors[i];
+        values[placeholder.placeholder] = color(selected ? placeholder.selectedRole : placeholder.role, placeholder.group).name();
+    }
+
+    QFont font = QGuiApplication::font();
+    values[StyleSheetTemplate::FontSize] = QStringLiteral("%1pt").arg(font.pointSize());
+    values[StyleSheetTemplate::FontFamily] = font.family().split('[').first();
+    values[StyleSheetTemplate::SmallFontSize] = QStringLiteral("%1pt").arg(QFontDatabase::systemFont(QFontDatabase::SmallestReadableFont).pointSize());
+
+    return cachedStyleSheetValues.insert(int(status), values).value();
+}
+
 const QString ThemePrivate::processStyleSheet(const QString &css, Plasma::Svg::Status status)
 {
-    QString stylesheet;
     if (css.isEmpty()) {
-        stylesheet = cachedDefaultStyleSheet;
-        if (stylesheet.isEmpty()) {
-            stylesheet = QStringLiteral("\n\
+        if (cachedDefaultStyleSheet.isEmpty()) {
+            static const StyleSheetTemplate defaultStyleSheet(QStringLiteral("\n\
                         body {\n\
                             color: %textcolor;\n\
                             generalfont-size: %fontsize;\n\
@@ -427,74 +800,32 @@ const QString ThemePrivate::processStyleSheet(const QString &css, Plasma::Svg::S
                         a:link    { color: %link; }\n\
                         a:visited { color: %visitedlink; }\n\
                         a:hover   { color: %hoveredlink; text-decoration: none; }\n\
-                        ");
-            stylesheet = cachedDefaultStyleSheet = processStyleSheet(stylesheet, status);
+                        "));
+            cachedDefaultStyleSheet = defaultStyleSheet.fill(styleSheetValues(status));
         }
 
-        return stylesheet;
-    } else {
-        stylesheet = css;
-    }
-
-    QHash<QString, QString> elements;
-    // If you add elements here, make sure their names are sufficiently unique to not cause
-    // clashes between element keys
-    elements[QStringLiteral("%textcolor")] = color(status == Svg::Status::Selected ? Theme::HighlightedTextColor : Theme::TextColor, Theme::NormalColorGroup).name();
-    elements[QStringLiteral("%backgroundcolor")] = color(status == Svg::Status::Selected ? Theme::HighlightColor : Theme::BackgroundColor, Theme::NormalColorGroup).name();
-    elements[QStringLiteral("%highlightcolor")] = color(Theme::HighlightColor, Theme::NormalColorGroup).name();
-    elements[QStringLiteral("%highlightedtextcolor")] = color(Theme::HighlightedTextColor, Theme::NormalColorGroup).name();
-    elements[QStringLiteral("%visitedlink")] = color(Theme::VisitedLinkColor, Theme::NormalColorGroup).name();
-    elements[QStringLiteral("%activatedlink")] = color(Theme::HighlightColor, Theme::NormalColorGroup).name();
-    elements[QStringLiteral("%hoveredlink")] = color(Theme::HighlightColor, Theme::NormalColorGroup).name();
-    elements[QStringLiteral("%link")] = color(Theme::LinkColor, Theme::NormalColorGroup).name();
-    elements[QStringLiteral("%positivetextcolor")] = color(Theme::PositiveTextColor, Theme::NormalColorGroup).name();
-    elements[QStringLiteral("%neutraltextcolor")] = color(Theme::NeutralTextColor, Theme::NormalColorGroup).name();
-    elements[QStringLiteral("%negativetextcolor")] = color(Theme::NegativeTextColor, Theme::NormalColorGroup).name();
-
-    elements[QStringLiteral("%buttontextcolor")] = color(status == Svg::Status::Selected ? Theme::HighlightedTextColor : Theme::TextColor, Theme::ButtonColorGroup).name();
-    elements[QStringLiteral("%buttonbackgroundcolor")] = color(status == Svg::Status::Selected ? Theme::HighlightColor : Theme::BackgroundColor, Theme::ButtonColorGroup).name();
-    elements[QStringLiteral("%buttonhovercolor")] = color(Theme::HoverColor, Theme::ButtonColorGroup).name();
-    elements[QStringLiteral("%buttonfocuscolor")] = color(Theme::FocusColor, Theme::ButtonColorGroup).name();
-    elements[QStringLiteral("%buttonhighlightedtextcolor")] = color(Theme::HighlightedTextColor, Theme::ButtonColorGroup).name();
-    elements[QStringLiteral("%buttonpositivetextcolor")] = color(Theme::PositiveTextColor, Theme::ButtonColorGroup).name();
-    elements[QStringLiteral("%buttonneutraltextcolor")] = color(Theme::NeutralTextColor, Theme::ButtonColorGroup).name();
-    elements[QStringLiteral("%buttonnegativetextcolor")] = color(Theme::NegativeTextColor, Theme::ButtonColorGroup).name();
-
-    elements[QStringLiteral("%viewtextcolor")] = color(status == Svg::Status::Selected ? Theme::HighlightedTextColor : Theme::TextColor, Theme::ViewColorGroup).name();
-    elements[QStringLiteral("%viewbackgroundcolor")] = color(status == Svg::Status::Selected ? Theme::HighlightColor : Theme::BackgroundColor, Theme::ViewColorGroup).name();
-    elements[QStringLiteral("%viewhovercolor")] = color(Theme::HoverColor, Theme::ViewColorGroup).name();
-    elements[QStringLiteral("%viewfocuscolor")] = color(Theme::FocusColor, Theme::ViewColorGroup).name();
-    elements[QStringLiteral("%viewhighlightedtextcolor")] = color(Theme::HighlightedTextColor, Theme::ViewColorGroup).name();
-    elements[QStringLiteral("%viewpositivetextcolor")] = color(Theme::PositiveTextColor, Theme::ViewColorGroup).name();
-    elements[QStringLiteral("%viewneutraltextcolor")] = color(Theme::NeutralTextColor, Theme::ViewColorGroup).name();
-    elements[QStringLiteral("%viewnegativetextcolor")] = color(Theme::NegativeTextColor, Theme::ViewColorGroup).name();
-
-    elements[QStringLiteral("%complementarytextcolor")] = color(status == Svg::Status::Selected ? Theme::HighlightedTextColor : Theme::TextColor, Theme::ComplementaryColorGroup).name();
-    elements[QStringLiteral("%complementarybackgroundcolor")] = color(status == Svg::Status::Selected ? Theme::HighlightColor : Theme::BackgroundColor, Theme::ComplementaryColorGroup).name();
-    elements[QStringLiteral("%complementaryhovercolor")] = color(Theme::HoverColor, Theme::ComplementaryColorGroup).name();
-    elements[QStringLiteral("%complementaryfocuscolor")] = color(Theme::FocusColor, Theme::ComplementaryColorGroup).name();
-    elements[QStringLiteral("%complementaryhighlightedtextcolor")] = color(Theme::HighlightedTextColor, Theme::ComplementaryColorGroup).name();
-    elements[QStringLiteral("%complementarypositivetextcolor")] = color(Theme::PositiveTextColor, Theme::ComplementaryColorGroup).name();
-    elements[QStringLiteral("%complementaryneutraltextcolor")] = color(Theme::NeutralTextColor, Theme::ComplementaryColorGroup).name();
-    elements[QStringLiteral("%complementarynegativetextcolor")] = color(Theme::NegativeTextColor, Theme::ComplementaryColorGroup).name();
-
-    QFont font = QGuiApplication::font();
-    elements[QStringLiteral("%fontsize")] = QStringLiteral("%1pt").arg(font.pointSize());
-    elements[QStringLiteral("%fontfamily")] = font.family().split('[').first();
-    elements[QStringLiteral("%smallfontsize")] = QStringLiteral("%1pt").arg(QFontDatabase::systemFont(QFontDatabase::SmallestReadableFont).pointSize());
+        return cachedDefaultStyleSheet;
+    }
 
-    QHash<QString, QString>::const_iterator it = elements.constBegin();
-    QHash<QString, QString>::const_iterator itEnd = elements.constEnd();
-    for (; it != itEnd; ++it) {
-        stylesheet.replace(it.key(), it.value());
+    StyleSheetTemplate *styleSheet = styleSheetTemplates.object(css);
+    if (!styleSheet) {
+        styleSheet = new StyleSheetTemplate(css);
+        styleSheetTemplates.insert(css, styleSheet);
     }
-    return stylesheet;
+
+    return styleSheet->fill(styleSheetValues(status));
 }
 
 const QString ThemePrivate::svgStyleSheet(Plasma::Theme::ColorGroup group, Plasma::Svg::Status status)
 {
     QString stylesheet = (status == Svg::Status::Selected) ? cachedSelectedSvgStyleSheets.value(group) : cachedSvgStyleSheets.value(group);
-    if (stylesheet.isEmpty()) {
+    if (!stylesheet.isEmpty()) {
+        return stylesheet;
+    }
+
+    // the rules don't change, only the colors: compiled once per group
+    QHash<Theme::ColorGroup, StyleSheetTemplate>::iterator it = svgStyleSheetTemplates.find(group);
+    if (it == svgStyleSheetTemplates.end()) {
         QString skel = QStringLiteral(".ColorScheme-%1{color:%2;}");
 
         switch (group) {
@@ -566,12 +897,14 @@ const QString ThemePrivate::svgStyleSheet(Plasma::Theme::ColorGroup group, Plasm
         stylesheet += skel.arg(QStringLiteral("ComplementaryNeutralText"), QStringLiteral("%complementaryneutraltextcolor"));
         stylesheet += skel.arg(QStringLiteral("ComplementaryNegativeText"), QStringLiteral("%complementarynegativetextcolor"));
 
-        stylesheet = processStyleSheet(stylesheet, status);
-        if (status == Svg::Status::Selected) {
-            cachedSelectedSvgStyleSheets.insert(group, stylesheet);
-        } else {
-            cachedSvgStyleSheets.insert(group, stylesheet);
-        }
+        it = svgStyleSheetTemplates.insert(group, StyleSheetTemplate(stylesheet));
+    }
+
+    stylesheet = it->fill(styleSheetValues(status));
+    if (status == Svg::Status::Selected) {
+        cachedSelectedSvgStyleSheets.insert(group, stylesheet);
+    } else {
+        cachedSvgStyleSheets.insert(group, stylesheet);
     }
 
     return stylesheet;
@@ -603,23 +936,15 @@ void ThemePrivate::settingsChanged(bool emitChanges)
 
 void ThemePrivate::saveSvgElementsCache()
 {
-    if (svgElementsCache) {
-        QHashIterator<QString, QSet<QString> > it(invalidElements);
-        while (it.hasNext()) {
-            it.next();
-            KConfigGroup imageGroup(svgElementsCache, it.key());
-            imageGroup.writeEntry("invalidElements", it.value().toList()); //FIXME: add QSet support to KConfig
+    if (svgElementsCache && svgElementsCache->isDirty()) {
+        if (!svgElementsCache->save()) {
+            qCWarning(LOG_PLASMA) << "Could not save the svg elements cache" << svgElementsCache->fileName();
         }
-
-        //Pretty drastic, but this is executed only very rarely
-        svgElementsCache->sync();
     }
 }
 
 QColor ThemePrivate::color(Theme::ColorRole role, Theme::ColorGroup group) const
 {
-    const KColorScheme *scheme = 0;
-
     //Before 5.0 Plasma theme really only used Normal and Button
     //many old themes are built on this assumption and will break
     //otherwise
@@ -627,67 +952,49 @@ QColor ThemePrivate::color(Theme::ColorRole role, Theme::ColorGroup group) const
         group = Theme::ButtonColorGroup;
     }
 
-    switch (group) {
-    case Theme::ButtonColorGroup: {
-        scheme = &buttonColorScheme;
-        break;
+    if (group < Theme::NormalColorGroup || group > Theme::ComplementaryColorGroup) {
+        group = Theme::NormalColorGroup;
     }
 
-    case Theme::ViewColorGroup: {
-        scheme = &viewColorScheme;
-        break;
+    if (role < Theme::TextColor || role > Theme::NegativeTextColor) {
+        return QColor();
     }
 
-    //this doesn't have a real kcolorscheme
-    case Theme::ComplementaryColorGroup: {
-        scheme = &complementaryColorScheme;
-        break;
+    if (!(filledColorGroups & (1 << group))) {
+        fillColorTable(group);
     }
 
-    case Theme::NormalColorGroup:
-    default: {
-        scheme = &colorScheme;
-        break;
-    }
-    }
-
-
-
-    switch (role) {
-
-    case Theme::TextColor:
-        return scheme->foreground(KColorScheme::NormalText).color();
-
-    case Theme::BackgroundColor:
-        return scheme->background(KColorScheme::NormalBackground).color();
-
-    case Theme::HoverColor:
-        return scheme->decoration(KColorScheme::HoverColor).color();
-
-    case Theme::HighlightColor:
-        return selectionColorScheme.background(KColorScheme::NormalBackground).color();
-
-    case Theme::FocusColor:
-        return scheme->decoration(KColorScheme::FocusColor).color();
-
-    case Theme::LinkColor:
-        return scheme->foreground(KColorScheme::LinkText).color();
-
-    case Theme::VisitedLinkColor:
-        return scheme->foreground(KColorScheme::VisitedText).color();
-
-    case Theme::HighlightedTextColor:
-        return selectionColorScheme.foreground(KColorScheme::NormalText).color();
-
-    case Theme::PositiveTextColor:
-        return scheme->foreground(KColorScheme::PositiveText).color();
-    case Theme::NeutralTextColor:
-        return scheme->foreground(KColorScheme::NeutralText).color();
-    case Theme::NegativeTextColor:
-        return scheme->foreground(KColorScheme::NegativeText).color();
-    }
+    return QColor::fromRgba(colorTable[group][role]);
+}
 
-    return QColor();
+void ThemePrivate::fillColorTable(Theme::ColorGroup group) const
+{
+    // indexed by Theme::ColorGroup, the complementary one doesn't have a real kcolorscheme
+    static const KColorScheme::ColorSet colorSets[] = {
+        KColorScheme::Window,
+        KColorScheme::Button,
+        KColorScheme::View,
+        KColorScheme::Complementary
+    };
+
+    // only built for the groups actually used, most processes use one or two
+    const KColorScheme scheme(QPalette::Active, colorSets[group], colors);
+    const KColorScheme selectionScheme(QPalette::Active, KColorScheme::Selection, colors);
+
+    QRgb *table = colorTable[group];
+    table[Theme::TextColor] = scheme.foreground(KColorScheme::NormalText).color().rgba();
+    table[Theme::BackgroundColor] = scheme.background(KColorScheme::NormalBackground).color().rgba();
+    table[Theme::HoverColor] = scheme.decoration(KColorScheme::HoverColor).color().rgba();
+    table[Theme::HighlightColor] = selectionScheme.background(KColorScheme::NormalBackground).color().rgba();
+    table[Theme::FocusColor] = scheme.decoration(KColorScheme::FocusColor).color().rgba();
+    table[Theme::LinkColor] = scheme.foreground(KColorScheme::LinkText).color().rgba();
+    table[Theme::VisitedLinkColor] = scheme.foreground(KColorScheme::VisitedText).color().rgba();
+    table[Theme::HighlightedTextColor] = selectionScheme.foreground(KColorScheme::NormalText).color().rgba();
+    table[Theme::PositiveTextColor] = scheme.foreground(KColorScheme::PositiveText).color().rgba();
+    table[Theme::NeutralTextColor] = scheme.foreground(KColorScheme::NeutralText).color().rgba();
+    table[Theme::NegativeTextColor] = scheme.foreground(KColorScheme::NegativeText).color().rgba();
+
+    filledColorGroups |= 1 << group;
 }
 
 void ThemePrivate::processWallpaperSettings(KConfigBase *metadata)
@@ -713,6 +1020,42 @@ void ThemePrivate::processWallpaperSettings(KConfigBase *metadata)
     defaultWallpaperHeight = cg.readEntry("defaultHeight", DEFAULT_WALLPAPER_HEIGHT);
 }
 
+const WallpaperCatalogue &ThemePrivate::wallpapers()
+{
+    if (wallpaperCatalogue) {
+        return *wallpaperCatalogue;
+    }
+
+    wallpaperCatalogue = new WallpaperCatalogue;
+    const QString images = QLatin1String("wallpapers/") % defaultWallpaperTheme % QLatin1String("/contents/images/");
+
+    //TODO: the theme's wallpaper overrides regularly installed wallpapers.
+    //      should it be possible for user installed (e.g. locateLocal) wallpapers
+    //      to override the theme?
+    if (hasWallpapers) {
+        // the files of the theme are already indexed
+        const QString themeImages = QLatin1Char('/') + images;
+        QSize size;
+        foreach (const QString &file, ThemeFileIndex::self()->files(themeName)) {
+            if (file.startsWith(themeImages) &&
+                WallpaperCatalogue::parseSize(file.mid(themeImages.length()), defaultWallpaperSuffix, &size)) {
+                wallpaperCatalogue->addImage(size, findInTheme(file.mid(1), themeName));
+            }
+        }
+    }
+
+    if (wallpaperCatalogue->isEmpty()) {
+        // one directory listing per data directory, highest priority first
+        const QStringList nameFilters(QLatin1String("*x*") + defaultWallpaperSuffix);
+        foreach (const QString &dataDir, QStandardPaths::standardLocations(QStandardPaths::GenericDataLocation)) {
+            const QDir dir(dataDir % QLatin1Char('/') % images);
+            wallpaperCatalogue->addImages(dir.path(), dir.entryList(nameFilters, QDir::Files), defaultWallpaperSuffix);
+        }
+    }
+
+    return *wallpaperCatalogue;
+}
+
 void ThemePrivate::processContrastSettings(KConfigBase *metadata)
 {
     KConfigGroup cg;
@@ -758,7 +1101,7 @@ void ThemePrivate::setThemeName(const QString &tempThemeName, bool writeSettings
     // the system colors.
     bool realTheme = theme != QLatin1String(systemColorsTheme);
     if (realTheme) {
-        QString themePath = QStandardPaths::locate(QStandardPaths::GenericDataLocation, QLatin1String(PLASMA_RELATIVE_DATA_INSTALL_DIR "/desktoptheme/") % theme % QLatin1String("/metadata.desktop"));
+        QString themePath = imagePath(theme, QStringLiteral("/"), QStringLiteral("metadata.desktop"));
 
         if (themePath.isEmpty() && themeName.isEmpty()) {
             // note: can't use QStringLiteral("foo" "bar") on Windows
@@ -780,7 +1123,7 @@ void ThemePrivate::setThemeName(const QString &tempThemeName, bool writeSettings
     themeName = theme;
 
     // load the color scheme config
-    const QString colorsFile = realTheme ? QStandardPaths::locate(QStandardPaths::GenericDataLocation, QLatin1Literal(PLASMA_RELATIVE_DATA_INSTALL_DIR "/desktoptheme/") % theme % QLatin1Literal("/colors"))
+    const QString colorsFile = realTheme ? imagePath(theme, QStringLiteral("/"), QStringLiteral("colors"))
                                : QString();
 
     //qCDebug(LOG_PLASMA) << "we're going for..." << colorsFile << "*******************";
@@ -791,17 +1134,16 @@ void ThemePrivate::setThemeName(const QString &tempThemeName, bool writeSettings
         colors = KSharedConfig::openConfig(colorsFile);
     }
 
-    colorScheme = KColorScheme(QPalette::Active, KColorScheme::Window, colors);
-    selectionColorScheme = KColorScheme(QPalette::Active, KColorScheme::Selection, colors);
-    buttonColorScheme = KColorScheme(QPalette::Active, KColorScheme::Button, colors);
-    viewColorScheme = KColorScheme(QPalette::Active, KColorScheme::View, colors);
-    complementaryColorScheme = KColorScheme(QPalette::Active, KColorScheme::Complementary, colors);
+    filledColorGroups = 0;
     const QString wallpaperPath = QLatin1Literal(PLASMA_RELATIVE_DATA_INSTALL_DIR "/desktoptheme/") % theme % QLatin1Literal("/wallpapers/");
     hasWallpapers = !QStandardPaths::locate(QStandardPaths::GenericDataLocation, wallpaperPath, QStandardPaths::LocateDirectory).isEmpty();
+    delete wallpaperCatalogue;
+    wallpaperCatalogue = 0;
+    closeCompiledElements();
 
     // load the wallpaper settings, if any
     if (realTheme) {
-        const QString metadataPath(QStandardPaths::locate(QStandardPaths::GenericDataLocation, QLatin1Literal(PLASMA_RELATIVE_DATA_INSTALL_DIR "/desktoptheme/") % theme % QLatin1Literal("/metadata.desktop")));
+        const QString metadataPath(imagePath(theme, QStringLiteral("/"), QStringLiteral("metadata.desktop")));
         KConfig metadata(metadataPath);
         pluginInfo = KPluginInfo(metadataPath);
 
@@ -816,7 +1158,7 @@ void ThemePrivate::setThemeName(const QString &tempThemeName, bool writeSettings
         while (!fallback.isEmpty() && !fallbackThemes.contains(fallback)) {
             fallbackThemes.append(fallback);
 
-            QString metadataPath(QStandardPaths::locate(QStandardPaths::GenericDataLocation, QLatin1Literal(PLASMA_RELATIVE_DATA_INSTALL_DIR "/desktoptheme/") % theme % QLatin1Literal("/metadata.desktop")));
+            QString metadataPath(imagePath(theme, QStringLiteral("/"), QStringLiteral("metadata.desktop")));
             KConfig metadata(metadataPath);
             KConfigGroup cg(&metadata, "Settings");
             fallback = cg.readEntry("FallbackTheme", QString());
@@ -827,7 +1169,7 @@ void ThemePrivate::setThemeName(const QString &tempThemeName, bool writeSettings
         }
 
         foreach (const QString &theme, fallbackThemes) {
-            QString metadataPath(QStandardPaths::locate(QStandardPaths::GenericDataLocation, QLatin1Literal(PLASMA_RELATIVE_DATA_INSTALL_DIR "/desktoptheme/") % theme % QLatin1Literal("/metadata.desktop")));
+            QString metadataPath(imagePath(theme, QStringLiteral("/"), QStringLiteral("metadata.desktop")));
             KConfig metadata(metadataPath);
             processWallpaperSettings(&metadata);
         }
@@ -872,6 +1214,8 @@ bool ThemePrivate::eventFilter(QObject *watched, QEvent *event)
             colorsChanged();
         }
         if (event->type() == QEvent::ApplicationFontChange || event->type() == QEvent::FontChange) {
+            // the fonts of the style sheets
+            cachedStyleSheetValues.clear();
             defaultFontChanged();
             smallestFontChanged();
         }
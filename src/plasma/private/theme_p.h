@@ -23,11 +23,12 @@
 
 #include "theme.h"
 #include "svg.h"
+#include <QCache>
 #include <QHash>
+#include <QRegion>
 
 #include <QDebug>
 #include <kcolorscheme.h>
-#include <kimagecache.h>
 #include <kshareddatacache.h>
 #include <kwindowsystem.h>
 #include <QTimer>
@@ -36,6 +37,12 @@
 #if HAVE_X11
 #include "private/effectwatcher_p.h"
 #endif
+#include "private/pixmapcachekey_p.h"
+#include "private/pixmapcachewriter_p.h"
+#include "private/pixmapstore_p.h"
+#include "private/stylesheettemplate_p.h"
+#include "private/svgelementsindex_p.h"
+#include "private/wallpapercatalogue_p.h"
 
 #include "libplasma-theme-global.h"
 
@@ -53,7 +60,9 @@ static const int DEFAULT_WALLPAPER_HEIGHT = 1200;
 enum CacheType {
     NoCache = 0,
     PixmapCache = 1,
-    SvgElementsCache = 2
+    SvgElementsCache = 2,
+    //only the pixmaps depending on the colors, a subset of PixmapCache
+    ColorDependentPixmapCache = 4
 };
 Q_DECLARE_FLAGS(CacheTypes, CacheType)
 Q_DECLARE_OPERATORS_FOR_FLAGS(CacheTypes)
@@ -73,13 +82,35 @@ public:
     void discardCache(CacheTypes caches);
     void scheduleThemeChangeNotification(CacheTypes caches);
     bool useCache();
+    bool findInCache(const PixmapCacheKey &key, QPixmap &pix, unsigned int lastModified = 0);
+    //image is a view of the mapped cache file, nothing gets copied
+    bool findInCache(const PixmapCacheKey &key, QImage &image, unsigned int lastModified = 0);
+    void insertIntoCache(const PixmapCacheKey &key, const QPixmap &pix, const PixmapCacheOwner &owner,
+                         PixmapStore::ImageFlags flags = PixmapStore::NoImageFlags);
+    void closePixmapCache();
+    QString cacheFilePath(const QString &prefix, const QString &suffix) const;
+    QString computeCacheFingerprint() const;
+    QString colorsFingerprint() const;
+    void removeStaleCaches();
+    //the index plasma-themecompiler shipped with the theme, if it matches its version
+    const SvgElementsIndex *compiledElements();
+    //looks up the rect of elementId in image at its natural size, false when not compiled
+    bool findInCompiledElements(const QString &image, const QString &elementId, qreal scaleFactor, QRectF &rect);
+    QHash<QString, QVector<QSize> > compiledSizeHints(const QString &image);
+    void closeCompiledElements();
+    //counters of all the themes, memory held by the caches of this one
+    QVariantMap cacheStatistics() const;
+    void dumpCacheStatistics() const;
     void setThemeName(const QString &themeName, bool writeSettings, bool emitChanged);
     void processWallpaperSettings(KConfigBase *metadata);
+    const WallpaperCatalogue &wallpapers();
     void processContrastSettings(KConfigBase *metadata);
 
     const QString processStyleSheet(const QString &css, Plasma::Svg::Status status);
     const QString svgStyleSheet(Plasma::Theme::ColorGroup group, Plasma::Svg::Status status);
+    const StyleSheetTemplate::Values &styleSheetValues(Plasma::Svg::Status status);
     QColor color(Theme::ColorRole role, Theme::ColorGroup group = Theme::NormalColorGroup) const;
+    void fillColorTable(Theme::ColorGroup group) const;
 
 public Q_SLOTS:
     void compositingChanged(bool active);
@@ -114,24 +145,33 @@ public:
     KPluginInfo pluginInfo;
     QList<QString> fallbackThemes;
     KSharedConfigPtr colors;
-    KColorScheme colorScheme;
-    KColorScheme selectionColorScheme;
-    KColorScheme buttonColorScheme;
-    KColorScheme viewColorScheme;
-    KColorScheme complementaryColorScheme;
+    //the colors of every role, filled for a color group the first time one of its colors is used
+    mutable QRgb colorTable[Theme::ComplementaryColorGroup + 1][Theme::NegativeTextColor + 1];
+    mutable uint filledColorGroups;
     bool eventFilter(QObject *watched, QEvent *event) Q_DECL_OVERRIDE;
     KConfigGroup cfg;
     QString defaultWallpaperTheme;
     QString defaultWallpaperSuffix;
     int defaultWallpaperWidth;
     int defaultWallpaperHeight;
-    KImageCache *pixmapCache;
-    KSharedConfigPtr svgElementsCache;
+    //the sizes of the default wallpaper, indexed at the first lookup
+    WallpaperCatalogue *wallpaperCatalogue;
+    PixmapStore *pixmapCache;
+    //the pixmaps of the Svgs waiting to be written to pixmapCache
+    PixmapCacheWriter *pixmapWriter;
+    SvgElementsIndex *svgElementsCache;
+    //the regions of the frame masks, shared by all the FrameSvgs of the theme
+    QCache<PixmapCacheKey, QRegion> frameMasks;
+    static const int MAX_FRAME_MASKS = 100;
+    SvgElementsIndex *compiledElementsIndex;
+    //the directory of the theme the compiled index is for, images are relative to it
+    QString compiledElementsDir;
     QString cachedDefaultStyleSheet;
-    QHash<QString, QSet<QString> > invalidElements;
-    QHash<QString, QPixmap> pixmapsToCache;
-    QHash<QString, QString> keysToCache;
-    QHash<QString, QString> idsToCache;
+    QHash<int, StyleSheetTemplate::Values> cachedStyleSheetValues;
+    QHash<Theme::ColorGroup, StyleSheetTemplate> svgStyleSheetTemplates;
+    //the style sheets passed to processStyleSheet, compiled once per css
+    QCache<QString, StyleSheetTemplate> styleSheetTemplates;
+    static const int MAX_STYLE_SHEET_TEMPLATES = 50;
     QHash<Theme::ColorGroup, QString> cachedSvgStyleSheets;
     QHash<Theme::ColorGroup, QString> cachedSelectedSvgStyleSheets;
     QHash<QString, QString> discoveries;
@@ -141,6 +181,8 @@ public:
     unsigned cacheSize;
     CacheTypes cachesToDiscard;
     QString themeVersion;
+    //of the theme and icon theme the caches have been opened for, part of their file names
+    QString cacheFingerprint;
     QString themeMetadataPath;
     QString iconThemeMetadataPath;
 
@@ -152,6 +194,7 @@ public:
     bool hasWallpapers : 1;
     bool cacheTheme : 1;
     bool fixedName : 1;
+    bool compiledElementsLoaded : 1;
 
     qreal backgroundContrast;
     qreal backgroundIntensity;
@@ -0,0 +1,147 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "themefileindex_p.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QStandardPaths>
+#include <QStringBuilder>
+
+#include <kdirwatch.h>
+
+#include <config-plasma.h>
+
+namespace Plasma
+{
+
+Q_GLOBAL_STATIC(ThemeFileIndex, s_themeFileIndex)
+
+ThemeFileIndex::ThemeFileIndex(QObject *parent)
+    : QObject(parent)
+{
+    connect(KDirWatch::self(), &KDirWatch::created, this, &ThemeFileIndex::directoryChanged);
+    connect(KDirWatch::self(), &KDirWatch::deleted, this, &ThemeFileIndex::directoryChanged);
+    connect(KDirWatch::self(), &KDirWatch::dirty, this, &ThemeFileIndex::directoryChanged);
+}
+
+ThemeFileIndex::~ThemeFileIndex()
+{
+    clear();
+}
+
+ThemeFileIndex *ThemeFileIndex::self()
+{
+    return s_themeFileIndex();
+}
+
+ThemeFileIndex::Theme *ThemeFileIndex::theme(const QString &name)
+{
+    Theme *theme = m_themes.value(name);
+    if (theme) {
+        return theme;
+    }
+
+    theme = new Theme;
+    m_themes.insert(name, theme);
+
+    // the data directories come by priority: the first file found for a path wins
+    foreach (const QString &dataDir, QStandardPaths::standardLocations(QStandardPaths::GenericDataLocation)) {
+        const QString directory = dataDir % QLatin1Literal("/" PLASMA_RELATIVE_DATA_INSTALL_DIR "/desktoptheme/") % name;
+        theme->directories << directory;
+
+        // also watched if it doesn't exist, for a theme installed later
+        KDirWatch::self()->addDir(directory, KDirWatch::WatchSubDirs);
+
+        QDirIterator it(directory, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories | QDirIterator::FollowSymlinks);
+        while (it.hasNext()) {
+            const QString path = it.next();
+            const QString relativePath = path.mid(directory.length());
+            if (!theme->files.contains(relativePath)) {
+                theme->files.insert(relativePath, path);
+            }
+        }
+    }
+
+    return theme;
+}
+
+QString ThemeFileIndex::locate(const QString &themeName, const QString &relativePath)
+{
+    if (themeName.isEmpty()) {
+        return QString();
+    }
+
+    return theme(themeName)->files.value(relativePath);
+}
+
+QStringList ThemeFileIndex::files(const QString &themeName)
+{
+    if (themeName.isEmpty()) {
+        return QStringList();
+    }
+
+    return theme(themeName)->files.keys();
+}
+
+void ThemeFileIndex::remove(const QString &name)
+{
+    Theme *theme = m_themes.take(name);
+    if (!theme) {
+        return;
+    }
+
+    // at exit the watcher may be gone already
+    if (KDirWatch::exists()) {
+        foreach (const QString &directory, theme->directories) {
+            KDirWatch::self()->removeDir(directory);
+        }
+    }
+    delete theme;
+}
+
+void ThemeFileIndex::clear()
+{
+    foreach (const QString &name, m_themes.keys()) {
+        remove(name);
+    }
+}
+
+void ThemeFileIndex::directoryChanged(const QString &path)
+{
+    // KDirWatch is shared, most of what it reports is none of our business
+    QStringList changed;
+    for (QHash<QString, Theme *>::const_iterator it = m_themes.constBegin(); it != m_themes.constEnd(); ++it) {
+        foreach (const QString &directory, it.value()->directories) {
+            if (path == directory || path.startsWith(directory % QLatin1Char('/'))) {
+                changed << it.key();
+                break;
+            }
+        }
+    }
+
+    foreach (const QString &name, changed) {
+        remove(name);
+        emit themeChanged(name);
+    }
+}
+
+}
+
+#include "moc_themefileindex_p.cpp"
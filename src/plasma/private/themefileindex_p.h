@@ -0,0 +1,95 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PLASMA_THEMEFILEINDEX_P_H
+#define PLASMA_THEMEFILEINDEX_P_H
+
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+
+namespace Plasma
+{
+
+/**
+ * The files of the installed desktop themes, so looking for a file in a
+ * theme is a hash lookup instead of a QStandardPaths::locate() and its
+ * stat() in every data directory, and a miss costs the same as a hit.
+ *
+ * The files of a theme are listed the first time something is looked for
+ * in it, with one walk of its directory in every data directory, the
+ * locolor, opaque and translucent variants included. The directories are
+ * watched: when a file is added or removed, the list of the theme is
+ * dropped and made again at the next lookup.
+ *
+ * Only to be used from the GUI thread.
+ */
+class ThemeFileIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ThemeFileIndex(QObject *parent = 0);
+    ~ThemeFileIndex();
+
+    static ThemeFileIndex *self();
+
+    /**
+     * @param relativePath path in the directory of the theme, starting with a /
+     * @returns the absolute path of the file, from the data directory with
+     * the highest priority having it, like QStandardPaths::locate(), or an
+     * empty string
+     */
+    QString locate(const QString &theme, const QString &relativePath);
+
+    /**
+     * @returns the relative paths of the files of @p theme
+     */
+    QStringList files(const QString &theme);
+
+    /**
+     * Forgets the files of every theme
+     */
+    void clear();
+
+Q_SIGNALS:
+    /**
+     * Emitted when files of @p theme have been added or removed
+     */
+    void themeChanged(const QString &theme);
+
+private Q_SLOTS:
+    void directoryChanged(const QString &path);
+
+private:
+    struct Theme {
+        //relative path -> absolute path
+        QHash<QString, QString> files;
+        QStringList directories;
+    };
+
+    Theme *theme(const QString &name);
+    void remove(const QString &name);
+
+    QHash<QString, Theme *> m_themes;
+};
+
+}
+
+#endif
@@ -0,0 +1,153 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "wallpapercatalogue_p.h"
+
+namespace Plasma
+{
+
+static inline quint64 sizeKey(const QSize &size)
+{
+    return (quint64(quint32(size.width())) << 32) | quint32(size.height());
+}
+
+static inline QSize keySize(quint64 key)
+{
+    return QSize(int(key >> 32), int(key & 0xffffffff));
+}
+
+static inline bool covers(const QSize &image, const QSize &screen)
+{
+    return image.width() >= screen.width() && image.height() >= screen.height();
+}
+
+static inline bool sameAspectRatio(const QSize &image, const QSize &screen)
+{
+    return qAbs(qreal(image.width()) / image.height() - qreal(screen.width()) / screen.height()) < 0.01;
+}
+
+// whether @p a is a better image than @p b for a screen of @p screen
+static bool fitsBetter(const QSize &a, const QSize &b, const QSize &screen)
+{
+    const bool aCovers = covers(a, screen);
+    if (aCovers != covers(b, screen)) {
+        return aCovers;
+    }
+
+    const bool aSameAspectRatio = sameAspectRatio(a, screen);
+    if (aSameAspectRatio != sameAspectRatio(b, screen)) {
+        return aSameAspectRatio;
+    }
+
+    // the smallest covering the screen, or the closest to covering it
+    const qint64 aArea = qint64(a.width()) * a.height();
+    const qint64 bArea = qint64(b.width()) * b.height();
+    if (aArea != bArea) {
+        return aCovers ? aArea < bArea : aArea > bArea;
+    }
+
+    // stable whatever the order of the hash
+    return a.width() < b.width();
+}
+
+WallpaperCatalogue::WallpaperCatalogue()
+{
+}
+
+void WallpaperCatalogue::addImages(const QString &directory, const QStringList &fileNames, const QString &suffix)
+{
+    QSize size;
+    foreach (const QString &fileName, fileNames) {
+        if (parseSize(fileName, suffix, &size)) {
+            addImage(size, directory + QLatin1Char('/') + fileName);
+        }
+    }
+}
+
+void WallpaperCatalogue::addImage(const QSize &size, const QString &path)
+{
+    const quint64 key = sizeKey(size);
+    if (!m_images.contains(key)) {
+        m_images.insert(key, path);
+        m_bestFits.clear();
+    }
+}
+
+bool WallpaperCatalogue::isEmpty() const
+{
+    return m_images.isEmpty();
+}
+
+QList<QSize> WallpaperCatalogue::sizes() const
+{
+    QList<QSize> sizes;
+    foreach (quint64 key, m_images.keys()) {
+        sizes << keySize(key);
+    }
+    return sizes;
+}
+
+QString WallpaperCatalogue::bestFit(const QSize &size) const
+{
+    if (m_images.isEmpty() || size.isEmpty()) {
+        return QString();
+    }
+
+    const quint64 key = sizeKey(size);
+    QHash<quint64, QString>::const_iterator it = m_bestFits.constFind(key);
+    if (it != m_bestFits.constEnd()) {
+        return it.value();
+    }
+
+    QHash<quint64, QString>::const_iterator best = m_images.constBegin();
+    for (QHash<quint64, QString>::const_iterator image = best + 1; image != m_images.constEnd(); ++image) {
+        if (fitsBetter(keySize(image.key()), keySize(best.key()), size)) {
+            best = image;
+        }
+    }
+
+    m_bestFits.insert(key, best.value());
+    return best.value();
+}
+
+bool WallpaperCatalogue::parseSize(const QString &fileName, const QString &suffix, QSize *size)
+{
+    if (!fileName.endsWith(suffix)) {
+        return false;
+    }
+
+    const QStringRef name = fileName.leftRef(fileName.length() - suffix.length());
+    const int separator = name.indexOf(QLatin1Char('x'));
+    if (separator <= 0) {
+        return false;
+    }
+
+    bool widthOk = false;
+    bool heightOk = false;
+    const int width = name.left(separator).toInt(&widthOk);
+    const int height = name.mid(separator + 1).toInt(&heightOk);
+    if (!widthOk || !heightOk || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    *size = QSize(width, height);
+    return true;
+}
+
+}
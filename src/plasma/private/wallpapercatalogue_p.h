@@ -0,0 +1,75 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PLASMA_WALLPAPERCATALOGUE_P_H
+#define PLASMA_WALLPAPERCATALOGUE_P_H
+
+#include <QHash>
+#include <QSize>
+#include <QStringList>
+#include <QVector>
+
+namespace Plasma
+{
+
+/**
+ * The sizes a wallpaper package comes in, to pick the image to load for a
+ * screen.
+ *
+ * The images of a package are in its contents/images directory, named
+ * after their size, e.g. 1920x1080.png. The best fit for a screen is the
+ * smallest image covering it, of the same aspect ratio if there is one,
+ * rather than an image much larger than the screen to decode and downscale.
+ * The best fit of every size asked for is remembered.
+ */
+class WallpaperCatalogue
+{
+public:
+    WallpaperCatalogue();
+
+    /**
+     * Adds the images named after their size with the extension @p suffix
+     * (e.g. ".png") among @p fileNames, in @p directory. Sizes already known
+     * are ignored: add the directories with the highest priority first.
+     */
+    void addImages(const QString &directory, const QStringList &fileNames, const QString &suffix);
+    void addImage(const QSize &size, const QString &path);
+
+    bool isEmpty() const;
+    QList<QSize> sizes() const;
+
+    /**
+     * @returns the path of the image to use for a screen of @p size, the
+     * largest one if none covers it, or an empty string if there is no image
+     */
+    QString bestFit(const QSize &size) const;
+
+    /**
+     * Parses file names like 1920x1080.png
+     */
+    static bool parseSize(const QString &fileName, const QString &suffix, QSize *size);
+
+private:
+    QHash<quint64, QString> m_images;
+    mutable QHash<quint64, QString> m_bestFits;
+};
+
+}
+
+#endif
@@ -0,0 +1,181 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "renderprefetcher.h"
+#include "private/renderprefetcher_p.h"
+
+#include <QImage>
+#include <QTimer>
+
+#include "framesvg.h"
+#include "svg.h"
+#include "private/framesvg_p.h"
+
+namespace Plasma
+{
+
+RenderPrefetcherPrivate::RenderPrefetcherPrivate(RenderPrefetcher *prefetcher)
+    : q(prefetcher),
+      runningImages(0),
+      running(false)
+{
+}
+
+void RenderPrefetcherPrivate::imageReady(int request, const QImage &image)
+{
+    Q_UNUSED(request)
+    Q_UNUSED(image)
+
+    //the svg already put the image in the cache
+    Svg *svg = qobject_cast<Svg *>(q->sender());
+    if (svg) {
+        svg->deleteLater();
+    }
+
+    imageDone();
+}
+
+void RenderPrefetcherPrivate::imageDone()
+{
+    if (--runningImages > 0) {
+        return;
+    }
+
+    //frames reuse the images of their borders: compose them when they're all done
+    QTimer::singleShot(0, q, SLOT(generateFrames()));
+}
+
+void RenderPrefetcherPrivate::generateFrames()
+{
+    QList<FrameSvg *> svgs;
+    foreach (const Request &request, runningFrames) {
+        FrameSvg *frame = new FrameSvg;
+        if (theme) {
+            frame->setTheme(theme.data());
+        }
+        frame->setImagePath(request.imagePath);
+        frame->setDevicePixelRatio(request.devicePixelRatio);
+        frame->setColorGroup(request.group);
+        frame->setElementPrefix(request.element);
+        frame->resizeFrame(request.size);
+        svgs << frame;
+    }
+
+    //puts the frames in the cache, composing them all at once in the worker threads
+    FrameSvgPrivate::generateBackgrounds(svgs);
+
+    qDeleteAll(svgs);
+    runningFrames.clear();
+    running = false;
+    emit q->finished();
+}
+
+RenderPrefetcher::RenderPrefetcher(QObject *parent)
+    : QObject(parent),
+      d(new RenderPrefetcherPrivate(this))
+{
+}
+
+RenderPrefetcher::~RenderPrefetcher()
+{
+    delete d;
+}
+
+void RenderPrefetcher::setTheme(Plasma::Theme *theme)
+{
+    d->theme = theme;
+}
+
+Theme *RenderPrefetcher::theme() const
+{
+    return d->theme.data();
+}
+
+void RenderPrefetcher::addImage(const QString &imagePath, const QString &elementId, const QSize &size,
+                                qreal devicePixelRatio, Theme::ColorGroup group)
+{
+    RenderPrefetcherPrivate::Request request;
+    request.imagePath = imagePath;
+    request.element = elementId;
+    request.size = size;
+    request.devicePixelRatio = devicePixelRatio;
+    request.group = group;
+    d->images << request;
+}
+
+void RenderPrefetcher::addFrame(const QString &imagePath, const QString &prefix, const QSize &size,
+                                qreal devicePixelRatio, Theme::ColorGroup group)
+{
+    RenderPrefetcherPrivate::Request request;
+    request.imagePath = imagePath;
+    request.element = prefix;
+    request.size = size;
+    request.devicePixelRatio = devicePixelRatio;
+    request.group = group;
+    d->frames << request;
+}
+
+void RenderPrefetcher::start()
+{
+    if (d->running) {
+        return;
+    }
+
+    d->running = true;
+    d->runningFrames = d->frames;
+    d->frames.clear();
+
+    const QList<RenderPrefetcherPrivate::Request> images = d->images;
+    d->images.clear();
+
+    //one more, so the batch can't be over while it's still being started,
+    //images already in the cache are ready right away
+    d->runningImages = images.count() + 1;
+
+    foreach (const RenderPrefetcherPrivate::Request &request, images) {
+        Svg *svg = new Svg(this);
+        if (d->theme) {
+            svg->setTheme(d->theme.data());
+        }
+        svg->setImagePath(request.imagePath);
+        svg->setDevicePixelRatio(request.devicePixelRatio);
+        svg->setColorGroup(request.group);
+        //the same as SvgItem, so the images end up with the same cache keys
+        svg->setContainsMultipleImages(!request.element.isEmpty());
+
+        connect(svg, SIGNAL(imageReady(int,QImage)), this, SLOT(imageReady(int,QImage)));
+        svg->requestImage(request.size, request.element);
+    }
+
+    d->imageDone();
+}
+
+bool RenderPrefetcher::isRunning() const
+{
+    return d->running;
+}
+
+int RenderPrefetcher::pendingCount() const
+{
+    return d->images.count() + d->frames.count() + qMax(0, d->runningImages) + d->runningFrames.count();
+}
+
+} // Plasma namespace
+
+#include "moc_renderprefetcher.cpp"
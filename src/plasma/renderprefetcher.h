@@ -0,0 +1,137 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef PLASMA_RENDERPREFETCHER_H
+#define PLASMA_RENDERPREFETCHER_H
+
+#include <QtCore/QObject>
+
+#include <plasma/plasma_export.h>
+#include <plasma/theme.h>
+
+class QSize;
+
+namespace Plasma
+{
+
+class RenderPrefetcherPrivate;
+
+/**
+ * @class RenderPrefetcher plasma/renderprefetcher.h <Plasma/RenderPrefetcher>
+ *
+ * @short Renders Svg images and FrameSvg frames ahead of their first use
+ *
+ * The first time an image is painted it's usually not in the cache yet and
+ * gets rendered right away, one image after the other. When the images that
+ * are going to be needed are known in advance, e.g. the backgrounds of the
+ * panels at startup, they can be handed to a RenderPrefetcher: the images
+ * are rendered in worker threads and the results go to the theme cache,
+ * so that painting them later on is just a cache hit.
+ *
+ * @code
+ * Plasma::RenderPrefetcher *prefetcher = new Plasma::RenderPrefetcher(this);
+ * prefetcher->addFrame(QStringLiteral("widgets/panel-background"), QString(), panelSize);
+ * prefetcher->addImage(QStringLiteral("widgets/arrows"), QStringLiteral("up-arrow"), QSize(16, 16));
+ * connect(prefetcher, &Plasma::RenderPrefetcher::finished, prefetcher, &QObject::deleteLater);
+ * prefetcher->start();
+ * @endcode
+ *
+ * Frames are made of the borders of their Svg: they are composed once all
+ * the images are done, all of them at once in the worker threads.
+ *
+ * @since 5.24
+ */
+class PLASMA_EXPORT RenderPrefetcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RenderPrefetcher(QObject *parent = 0);
+    ~RenderPrefetcher();
+
+    /**
+     * Sets the theme the images are looked up in and cached into.
+     * By default, the default theme is used.
+     */
+    void setTheme(Plasma::Theme *theme);
+
+    /**
+     * @return the theme the images are looked up in and cached into
+     */
+    Theme *theme() const;
+
+    /**
+     * Queues the rendering of an image, as Svg::image() would render it.
+     *
+     * @param imagePath the path of the Svg, as given to Svg::setImagePath()
+     * @param elementId the element to render, or an empty string for the whole Svg
+     * @param size the size of the image, in logical pixels
+     * @param devicePixelRatio the device pixel ratio the image is going to be painted with
+     * @param group the color group the image is going to be painted with
+     */
+    void addImage(const QString &imagePath, const QString &elementId, const QSize &size,
+                  qreal devicePixelRatio = 1.0, Theme::ColorGroup group = Theme::NormalColorGroup);
+
+    /**
+     * Queues the rendering of a frame with all its borders, as
+     * FrameSvg::framePixmap() would render it.
+     *
+     * @param imagePath the path of the FrameSvg, as given to Svg::setImagePath()
+     * @param prefix the element prefix of the frame, see FrameSvg::setElementPrefix()
+     * @param size the size of the frame, in logical pixels
+     * @param devicePixelRatio the device pixel ratio the frame is going to be painted with
+     * @param group the color group the frame is going to be painted with
+     */
+    void addFrame(const QString &imagePath, const QString &prefix, const QSize &size,
+                  qreal devicePixelRatio = 1.0, Theme::ColorGroup group = Theme::NormalColorGroup);
+
+    /**
+     * Starts rendering everything queued so far as one batch.
+     * Does nothing if a batch is already being rendered.
+     */
+    void start();
+
+    /**
+     * @return true while a batch is being rendered
+     */
+    bool isRunning() const;
+
+    /**
+     * @return the number of images and frames queued and not rendered yet
+     */
+    int pendingCount() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted when everything started with start() has been rendered
+     */
+    void finished();
+
+private:
+    RenderPrefetcherPrivate *const d;
+
+    Q_PRIVATE_SLOT(d, void imageReady(int, const QImage &))
+    Q_PRIVATE_SLOT(d, void generateFrames())
+
+    friend class RenderPrefetcherPrivate;
+};
+
+} // Plasma namespace
+
+#endif // multiple inclusion guard
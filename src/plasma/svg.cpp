@@ -21,23 +21,23 @@
 #include "svg.h"
 #include "private/svg_p.h"
 #include "private/theme_p.h"
+#include "private/cachestatistics_p.h"
+#include "private/svgrasterizer_p.h"
+#include "private/svgrendererpool_p.h"
 
 #include <cmath>
 
 #include <QCoreApplication>
 #include <QDir>
 #include <QMatrix>
+#include <QMutexLocker>
 #include <QPainter>
+#include <QtMath>
 #include <QStringBuilder>
-#include <QXmlStreamReader>
-#include <QXmlStreamWriter>
-#include <QBuffer>
 
 #include <kcolorscheme.h>
 #include <kconfiggroup.h>
 #include <QDebug>
-#include <kfilterdev.h>
-#include <kiconeffect.h>
 #include <KIconLoader>
 #include <KIconTheme>
 
@@ -51,90 +51,69 @@ namespace Plasma
 
 
 SharedSvgRenderer::SharedSvgRenderer(QObject *parent)
-    : QSvgRenderer(parent)
+    : QSvgRenderer(parent),
+      m_estimatedSize(0)
 {
 }
 
 SharedSvgRenderer::SharedSvgRenderer(
-    const QString &filename,
+    const SvgDocument::Ptr &document,
     const QString &styleSheet,
-    QHash<QString, QRectF> &interestingElements,
+    QHash<QString, QRectF> *interestingElements,
     QObject *parent)
-    : QSvgRenderer(parent)
+    : QSvgRenderer(parent),
+      m_document(document),
+      m_estimatedSize(0)
 {
-    KCompressionDevice file(filename, KCompressionDevice::GZip);
-    if (!file.open(QIODevice::ReadOnly)) {
-        return;
-    }
-    load(file.readAll(), styleSheet, interestingElements);
+    load(styleSheet, interestingElements);
 }
 
 SharedSvgRenderer::SharedSvgRenderer(
     const QByteArray &contents,
     const QString &styleSheet,
-    QHash<QString, QRectF> &interestingElements,
+    QHash<QString, QRectF> *interestingElements,
     QObject *parent)
-    : QSvgRenderer(parent)
+    : QSvgRenderer(parent),
+      m_document(SvgDocument::fromContents(contents)),
+      m_estimatedSize(0)
 {
-    load(contents, styleSheet, interestingElements);
+    load(m_document->effectiveStyleSheet(styleSheet), interestingElements);
 }
 
 bool SharedSvgRenderer::load(
-    const QByteArray &contents,
     const QString &styleSheet,
-    QHash<QString, QRectF> &interestingElements)
-{
-    // Apply the style sheet.
-    if (!styleSheet.isEmpty() && contents.contains("current-color-scheme")) {
-        QByteArray processedContents;
-        QXmlStreamReader reader(contents);
-
-        QBuffer buffer(&processedContents);
-        buffer.open(QIODevice::WriteOnly);
-        QXmlStreamWriter writer(&buffer);
-        while (!reader.atEnd()) {
-            if (reader.readNext() == QXmlStreamReader::StartElement &&
-                reader.qualifiedName() == QLatin1String("style") &&
-                reader.attributes().value(QLatin1String("id")) == QLatin1String("current-color-scheme")) {
-                writer.writeStartElement(QLatin1String("style"));
-                writer.writeAttributes(reader.attributes());
-                writer.writeCharacters(styleSheet);
-                writer.writeEndElement();
-                while (reader.tokenType() != QXmlStreamReader::EndElement) {
-                    reader.readNext();
-                }
-            } else if (reader.tokenType() != QXmlStreamReader::Invalid) {
-                writer.writeCurrentToken(reader);
-            }
-        }
-        buffer.close();
-        if (!QSvgRenderer::load(processedContents)) {
-            return false;
-        }
-    } else if (!QSvgRenderer::load(contents)) {
+    QHash<QString, QRectF> *interestingElements)
+{
+    // The document was tokenized once, only the style sheet changes
+    const QByteArray contents = m_document->contents(styleSheet);
+    if (!QSvgRenderer::load(contents)) {
         return false;
     }
 
-    // Search the SVG to find and store all ids that contain size hints.
-    const QString contentsAsString(QString::fromLatin1(contents));
-    QRegExp idExpr(QLatin1String("id\\s*=\\s*(['\"])(\\d+-\\d+-.*)\\1"));
-    idExpr.setMinimal(true);
-
-    int pos = 0;
-    while ((pos = idExpr.indexIn(contentsAsString, pos)) != -1) {
-        QString elementId = idExpr.cap(2);
+    m_estimatedSize = contents.size();
 
-        QRectF elementRect = boundsOnElement(elementId);
-        if (elementRect.isValid()) {
-            interestingElements.insert(elementId, elementRect);
+    if (interestingElements) {
+        foreach (const QString &elementId, m_document->sizeHintedIds()) {
+            QRectF elementRect = boundsOnElement(elementId);
+            if (elementRect.isValid()) {
+                interestingElements->insert(elementId, elementRect);
+            }
         }
-
-        pos += idExpr.matchedLength();
     }
 
     return true;
 }
 
+qint64 SharedSvgRenderer::estimatedSize() const
+{
+    return m_estimatedSize;
+}
+
+QString SharedSvgRenderer::path() const
+{
+    return m_document ? m_document->path() : QString();
+}
+
 #define QLSEP QLatin1Char('_')
 #define CACHE_ID_WITH_SIZE(size, id, status, devicePixelRatio) QString::number(int(size.width())) % QLSEP % QString::number(int(size.height())) % QLSEP % id % QLSEP % QString::number(status) % QLSEP % QString::number(int(devicePixelRatio))
 #define CACHE_ID_NATURAL_SIZE(id, status, devicePixelRatio) QLatin1String("Natural") % QLSEP % id % QLSEP % QString::number(status) % QLSEP % QString::number(int(devicePixelRatio))
@@ -142,7 +121,7 @@ bool SharedSvgRenderer::load(
 SvgPrivate::SvgPrivate(Svg *svg)
     : q(svg),
       renderer(0),
-      styleCrc(0),
+      styleHash(0),
       colorGroup(Plasma::Theme::NormalColorGroup),
       lastModified(0),
       devicePixelRatio(1.0),
@@ -154,13 +133,20 @@ SvgPrivate::SvgPrivate(Svg *svg)
       fromCurrentTheme(false),
       applyColors(false),
       usesColors(false),
+      styledByColors(false),
+      settleTimer(0),
       cacheRendering(true),
-      themeFailed(false)
+      themeFailed(false),
+      interactiveResizing(false),
+      resizing(false)
 {
+    //a few full screen renders
+    interactivePixmaps.setMaxCost(32 * 1024);
 }
 
 SvgPrivate::~SvgPrivate()
 {
+    cancelImageRequests();
     eraseRenderer();
 }
 
@@ -175,9 +161,9 @@ QString SvgPrivate::cacheId(const QString &elementId) const
 }
 
 //This function is meant for the pixmap cache
-QString SvgPrivate::cachePath(const QString &path, const QSize &size) const
+PixmapCacheKey SvgPrivate::pixmapCacheKey(const QString &actualElementId, const QSize &size) const
 {
-    return CACHE_ID_WITH_SIZE(size, path, status, devicePixelRatio) % QLSEP % QString::number(colorGroup);
+    return PixmapCacheKey::svgElement(path, actualElementId, size, status, int(devicePixelRatio), colorGroup);
 }
 
 bool SvgPrivate::setImagePath(const QString &imagePath)
@@ -220,7 +206,7 @@ bool SvgPrivate::setImagePath(const QString &imagePath)
     path.clear();
     themePath.clear();
     localRectCache.clear();
-    elementsWithSizeHints.clear();
+    sizeHints = 0;
     bool oldFromCurrentTheme = fromCurrentTheme;
     fromCurrentTheme = actualTheme()->currentThemeHasImage(imagePath);
 
@@ -256,9 +242,14 @@ bool SvgPrivate::setImagePath(const QString &imagePath)
 
         if (cacheAndColorsTheme()->findInRectsCache(path, QStringLiteral("_Natural_%1").arg(scaleFactor), rect)) {
             naturalSize = rect.size();
+        } else if (themed && cacheAndColorsTheme()->d->findInCompiledElements(path, QString(), scaleFactor, rect)) {
+            naturalSize = rect.size();
+            cacheAndColorsTheme()->insertIntoRectsCache(path, QStringLiteral("_Natural_%1").arg(scaleFactor), rect);
         } else {
             createRenderer();
+            QMutexLocker lock(&renderer->renderMutex);
             naturalSize = renderer->defaultSize() * scaleFactor;
+            lock.unlock();
             //qCDebug(LOG_PLASMA) << "natural size for" << path << "from renderer is" << naturalSize;
             cacheAndColorsTheme()->insertIntoRectsCache(path, QStringLiteral("_Natural_%1").arg(scaleFactor), QRectF(QPointF(0, 0), naturalSize));
             //qCDebug(LOG_PLASMA) << "natural size for" << path << "from cache is" << naturalSize;
@@ -301,82 +292,135 @@ Theme *SvgPrivate::cacheAndColorsTheme()
     }
 }
 
-QPixmap SvgPrivate::findInCache(const QString &elementId, qreal ratio, const QSizeF &s)
+QString SvgPrivate::resolveElementId(const QString &elementId, qreal ratio, const QSizeF &s, QSize &size)
 {
-    QSize size;
     QString actualElementId;
 
-    if (elementsWithSizeHints.isEmpty()) {
-        // Fetch all size hinted element ids from the theme's rect cache
-        // and store them locally.
-        QRegExp sizeHintedKeyExpr(CACHE_ID_NATURAL_SIZE("(\\d+)-(\\d+)-(.+)", status, ratio));
+    if (!sizeHints) {
+        loadSizeHints();
+    }
 
-        foreach (const QString &key, cacheAndColorsTheme()->listCachedRectKeys(path)) {
-            if (sizeHintedKeyExpr.exactMatch(key)) {
-                QString baseElementId = sizeHintedKeyExpr.cap(3);
-                QSize sizeHint(sizeHintedKeyExpr.cap(1).toInt(),
-                               sizeHintedKeyExpr.cap(2).toInt());
+    // Look at the size hinted elements and try to find the smallest one
+    // big enough for the requested size.
+    if (s.isValid() && !elementId.isEmpty() && !sizeHints->isEmpty()) {
+        actualElementId = sizeHints->bestFit(elementId, QSize(qCeil(s.width() * ratio), qCeil(s.height() * ratio)));
+    }
 
-                if (sizeHint.isValid()) {
-                    elementsWithSizeHints.insertMulti(baseElementId, sizeHint);
-                }
-            }
-        }
+    if (elementId.isEmpty() || !q->hasElement(actualElementId)) {
+        actualElementId = elementId;
+    }
 
-        if (elementsWithSizeHints.isEmpty()) {
-            // Make sure we won't query the theme unnecessarily.
-            elementsWithSizeHints.insert(QString(), QSize());
-        }
+    if (elementId.isEmpty() || (multipleImages && s.isValid())) {
+        size = s.toSize() * ratio;
+    } else {
+        size = elementRect(actualElementId).size().toSize() * ratio;
     }
 
-    // Look at the size hinted elements and try to find the smallest one with an
-    // identical aspect ratio.
-    if (s.isValid() && !elementId.isEmpty()) {
-        QList<QSize> elementSizeHints = elementsWithSizeHints.values(elementId);
+    return actualElementId;
+}
 
-        if (!elementSizeHints.isEmpty()) {
-            QSize bestFit(-1, -1);
+QSize SvgPrivate::interactiveSize(const QString &elementId, const QSize &size)
+{
+    if (!interactiveResizing) {
+        return size;
+    }
 
-            Q_FOREACH (QSize hint, elementSizeHints) {
+    // The same element asked at another size: it's being resized
+    QSize &lastSize = requestedSizes[elementId];
+    if (lastSize.isValid() && lastSize != size) {
+        startResizing();
+    }
+    lastSize = size;
 
-                if (hint.width() >= s.width() * ratio && hint.height() >= s.height() * ratio &&
-                        (!bestFit.isValid() ||
-                         (bestFit.width() * bestFit.height()) > (hint.width() * hint.height()))) {
-                    bestFit = hint;
-                }
-            }
+    if (!resizing) {
+        return size;
+    }
 
-            if (bestFit.isValid()) {
-                actualElementId = QString::number(bestFit.width()) % '-' %
-                                  QString::number(bestFit.height()) % '-' % elementId;
-            }
-        }
+    return QSize(sizeBucket(size.width()), sizeBucket(size.height()));
+}
+
+void SvgPrivate::startResizing()
+{
+    if (!settleTimer) {
+        settleTimer = new QTimer(q);
+        settleTimer->setSingleShot(true);
+        settleTimer->setInterval(250);
+        QObject::connect(settleTimer, SIGNAL(timeout()), q, SLOT(resizingSettled()));
     }
 
-    if (elementId.isEmpty() || !q->hasElement(actualElementId)) {
-        actualElementId = elementId;
+    resizing = true;
+    settleTimer->start();
+}
+
+int SvgPrivate::sizeBucket(int length)
+{
+    // 16 buckets per power of two: at most 12.5% bigger than asked, small
+    // lengths below 16 are kept exact
+    int step = 1;
+    while (step * 16 <= length) {
+        step *= 2;
     }
 
-    if (elementId.isEmpty() || (multipleImages && s.isValid())) {
-        size = s.toSize() * ratio;
+    return (length + step - 1) / step * step;
+}
+
+void SvgPrivate::resizingSettled()
+{
+    resizing = false;
+    requestedSizes.clear();
+    interactivePixmaps.clear();
+
+    // let everybody render the exact size
+    emit q->repaintNeeded();
+}
+
+void SvgPrivate::loadSizeHints()
+{
+    sizeHints = s_sizeHints.value(path);
+    if (sizeHints) {
+        return;
+    }
+
+    // Nobody parsed the file yet: use what the elements index knows about it,
+    // the table is replaced by the one from the file when the renderer is created.
+    ThemePrivate *themePrivate = cacheAndColorsTheme()->d;
+    if (themePrivate->useCache() && !path.isEmpty()) {
+        sizeHints = new SvgSizeHints(themePrivate->svgElementsCache->sizeHints(path));
     } else {
-        size = elementRect(actualElementId).size().toSize() * ratio;
+        sizeHints = new SvgSizeHints(QStringList());
     }
 
-    if (size.isEmpty()) {
-        return QPixmap();
+    // or what was compiled with the theme
+    if (sizeHints->isEmpty() && themed && !path.isEmpty()) {
+        sizeHints = new SvgSizeHints(themePrivate->compiledSizeHints(path));
     }
 
-    QString id = cachePath(path, size);
+    if (!sizeHints->isEmpty()) {
+        s_sizeHints.insert(path, sizeHints);
+    }
+}
+
+QRectF SvgPrivate::renderTarget(const QString &actualElementId, const QSize &size)
+{
+    createRenderer();
+
+    QMutexLocker lock(&renderer->renderMutex);
+    return makeUniform(renderer->boundsOnElement(actualElementId), QRect(QPoint(0, 0), size));
+}
+
+QPixmap SvgPrivate::findInCache(const QString &elementId, qreal ratio, const QSizeF &s)
+{
+    QSize size;
+    const QString actualElementId = resolveElementId(elementId, ratio, s, size);
 
-    if (!actualElementId.isEmpty()) {
-        id.append(actualElementId);
+    if (size.isEmpty()) {
+        return QPixmap();
     }
 
-    //qCDebug(LOG_PLASMA) << "id is " << id;
+    const PixmapCacheKey id = pixmapCacheKey(actualElementId, size);
 
     QPixmap p;
-    if (cacheRendering && cacheAndColorsTheme()->findInCache(id, p, lastModified)) {
+    if (cacheRendering && cacheAndColorsTheme()->d->findInCache(id, p, lastModified)) {
         p.setDevicePixelRatio(ratio);
         //qCDebug(LOG_PLASMA) << "found cached version of " << id << p.size();
         return p;
@@ -387,38 +431,162 @@ QPixmap SvgPrivate::findInCache(const QString &elementId, qreal ratio, const QSi
     //qCDebug(LOG_PLASMA) << "size for " << actualElementId << " is " << s;
     // we have to re-render this puppy
 
-    createRenderer();
-
-    QRectF finalRect = makeUniform(renderer->boundsOnElement(actualElementId), QRect(QPoint(0, 0), size));
+    QRectF finalRect = renderTarget(actualElementId, size);
 
     //don't alter the pixmap size or it won't match up properly to, e.g., FrameSvg elements
     //makeUniform should never change the size so much that it gains or loses a whole pixel
-    p = QPixmap(size);
+    // Apply current color scheme if the svg asks for it, while the pixels are still in the image
+    const QColor colorizeColor = applyColors ? cacheAndColorsTheme()->color(Theme::BackgroundColor) : QColor();
+    p = QPixmap::fromImage(SvgRasterJob::render(renderer.data(), actualElementId, size, finalRect, ratio, colorizeColor));
+    p.setDevicePixelRatio(ratio);
 
-    p.fill(Qt::transparent);
-    QPainter renderPainter(&p);
+    cacheImage(id, p, false);
 
-    if (actualElementId.isEmpty()) {
-        renderer->render(&renderPainter, finalRect);
-    } else {
-        renderer->render(&renderPainter, actualElementId, finalRect);
+    return p;
+}
+
+QImage SvgPrivate::findImageInCache(const QString &elementId, qreal ratio, const QSizeF &s, bool interactive)
+{
+    QSize size;
+    const QString actualElementId = resolveElementId(elementId, ratio, s, size);
+
+    if (size.isEmpty()) {
+        return QImage();
+    }
+
+    if (interactive) {
+        size = interactiveSize(elementId, size);
+        interactive = resizing;
     }
 
-    renderPainter.end();
+    const PixmapCacheKey id = pixmapCacheKey(actualElementId, size);
+
+    QImage image;
+    if (findCachedImage(id, ratio, interactive, image)) {
+        return image;
+    }
+
+    const QRectF finalRect = renderTarget(actualElementId, size);
+    const QColor colorizeColor = applyColors ? cacheAndColorsTheme()->color(Theme::BackgroundColor) : QColor();
+    image = SvgRasterJob::render(renderer.data(), actualElementId, size, finalRect, ratio, colorizeColor);
+
+    QPixmap p = QPixmap::fromImage(image);
     p.setDevicePixelRatio(ratio);
+    cacheImage(id, p, interactive);
+
+    return image;
+}
+
+bool SvgPrivate::findCachedImage(const PixmapCacheKey &id, qreal ratio, bool interactive, QImage &image)
+{
+    if (interactive) {
+        if (QPixmap *cached = interactivePixmaps.object(id)) {
+            image = cached->toImage();
+            return true;
+        }
+    }
 
-    // Apply current color scheme if the svg asks for it
-    if (applyColors) {
-        QImage itmp = p.toImage();
-        KIconEffect::colorize(itmp, cacheAndColorsTheme()->color(Theme::BackgroundColor), 1.0);
-        p = p.fromImage(itmp);
+    if (cacheRendering && cacheAndColorsTheme()->d->findInCache(id, image, lastModified)) {
+        // the cache doesn't store the ratio: setting it copies the mapped pixels,
+        // which doesn't happen on the usual ratio of 1
+        if (image.devicePixelRatio() != ratio) {
+            image.setDevicePixelRatio(ratio);
+        }
+        return true;
     }
 
-    if (cacheRendering) {
-        cacheAndColorsTheme()->insertIntoCache(id, p, QString::number((qint64)q, 16) % QLSEP % actualElementId);
+    return false;
+}
+
+void SvgPrivate::cacheImage(const PixmapCacheKey &id, const QPixmap &p, bool interactive)
+{
+    if (interactive) {
+        interactivePixmaps.insert(id, new QPixmap(p), qMax(1, p.width() * p.height() / 256));
+    } else if (cacheRendering) {
+        cacheAndColorsTheme()->d->insertIntoCache(id, p, PixmapCacheOwner(q, id.element), cacheFlags());
     }
+}
 
-    return p;
+PixmapStore::ImageFlags SvgPrivate::cacheFlags() const
+{
+    return usesColors || styledByColors ? PixmapStore::ColorDependent : PixmapStore::NoImageFlags;
+}
+
+int SvgPrivate::requestImage(const QSize &s, const QString &elementId)
+{
+    const int request = ++s_lastImageRequest;
+    const qreal ratio = devicePixelRatio;
+
+    QSize size;
+    const QString actualElementId = resolveElementId(elementId, ratio, s, size);
+
+    if (size.isEmpty()) {
+        emit q->imageReady(request, QImage());
+        return request;
+    }
+
+    size = interactiveSize(elementId, size);
+
+    const PixmapCacheKey id = pixmapCacheKey(actualElementId, size);
+
+    QImage image;
+    if (findCachedImage(id, ratio, resizing, image)) {
+        emit q->imageReady(request, image);
+        return request;
+    }
+
+    const QRectF finalRect = renderTarget(actualElementId, size);
+    const QColor colorizeColor = applyColors ? cacheAndColorsTheme()->color(Theme::BackgroundColor) : QColor();
+
+    ImageRequest imageRequest;
+    imageRequest.job = new SvgRasterJob(request, renderer, actualElementId, size, finalRect, ratio, colorizeColor);
+    imageRequest.cacheKey = id;
+    imageRequest.ratio = ratio;
+    imageRequest.interactive = resizing;
+    imageRequests.insert(request, imageRequest);
+
+    QObject::connect(imageRequest.job, SIGNAL(finished(int,QImage)), q, SLOT(imageRendered(int,QImage)), Qt::QueuedConnection);
+    imageRequest.job->start();
+
+    return request;
+}
+
+void SvgPrivate::cancelImageRequest(int request)
+{
+    QHash<int, ImageRequest>::iterator it = imageRequests.find(request);
+    if (it != imageRequests.end()) {
+        it.value().job->cancel();
+        imageRequests.erase(it);
+    }
+}
+
+void SvgPrivate::cancelImageRequests()
+{
+    foreach (const ImageRequest &imageRequest, imageRequests) {
+        imageRequest.job->cancel();
+    }
+    imageRequests.clear();
+}
+
+void SvgPrivate::imageRendered(int request, const QImage &image)
+{
+    QHash<int, ImageRequest>::iterator it = imageRequests.find(request);
+    //cancelled after the image was already on its way
+    if (it == imageRequests.end()) {
+        return;
+    }
+
+    const ImageRequest imageRequest = it.value();
+    imageRequests.erase(it);
+
+    //once settled, an interactive render is for a size that has been left behind
+    if (!image.isNull() && (!imageRequest.interactive || resizing)) {
+        QPixmap p = QPixmap::fromImage(image);
+        p.setDevicePixelRatio(imageRequest.ratio);
+        cacheImage(imageRequest.cacheKey, p, imageRequest.interactive);
+    }
+
+    emit q->imageReady(request, image);
 }
 
 void SvgPrivate::createRenderer()
@@ -455,23 +623,47 @@ void SvgPrivate::createRenderer()
     //qCDebug(LOG_PLASMA) << "FAIL! **************************";
     //qCDebug(LOG_PLASMA) << path << "**";
 
-    QString styleSheet = cacheAndColorsTheme()->d->svgStyleSheet(colorGroup, status);
-    styleCrc = qChecksum(styleSheet.toUtf8(), styleSheet.size());
+    // Only the colors of the classes the document uses matter: color groups and
+    // statuses agreeing on them, or all of them if the document doesn't use the
+    // color scheme, share the same renderer
+    SvgDocument::Ptr document;
+    QString styleSheet;
+    if (!path.isEmpty()) {
+        document = SvgDocument::load(path);
+        styleSheet = document->effectiveStyleSheet(cacheAndColorsTheme()->d->svgStyleSheet(colorGroup, status));
+    }
+    // 64 bits: two style sheets sharing a renderer would render with the same colors
+    styleHash = SvgElementsIndex::hash(styleSheet.constData(), styleSheet.size());
+    styledByColors = !styleSheet.isEmpty();
 
-    QHash<QString, SharedSvgRenderer::Ptr>::const_iterator it = s_renderers.constFind(styleCrc + path);
+    const QString rendererKey = QString::number(styleHash, 16) % QLatin1Char(':') % path;
+    renderer = SvgRendererPool::self()->renderer(rendererKey);
 
-    if (it != s_renderers.constEnd()) {
+    if (renderer) {
         //qCDebug(LOG_PLASMA) << "gots us an existing one!";
-        renderer = it.value();
+        CacheStatistics::self()->count(CacheStatistics::RendererReused);
+        sizeHints = s_sizeHints.value(path);
     } else {
+        CacheStatistics::self()->count(CacheStatistics::RendererCreated);
+
+        if (!path.isEmpty() && !sizeHints) {
+            loadSizeHints();
+        }
+
         if (path.isEmpty()) {
             renderer = new SharedSvgRenderer();
+        } else if (!sizeHints->isEmpty()) {
+            // The size hinted elements are already known, from another renderer
+            // of the same file or from the elements index: no need to look for them
+            renderer = new SharedSvgRenderer(document, styleSheet, 0);
         } else {
             QHash<QString, QRectF> interestingElements;
-            renderer = new SharedSvgRenderer(path, styleSheet, interestingElements);
+            renderer = new SharedSvgRenderer(document, styleSheet, &interestingElements);
 
             // Add interesting elements to the theme's rect cache.
             QHashIterator<QString, QRectF> i(interestingElements);
+            ThemePrivate *themePrivate = cacheAndColorsTheme()->d;
+            const bool indexSizeHints = themePrivate->useCache();
 
             while (i.hasNext()) {
                 i.next();
@@ -481,32 +673,50 @@ void SvgPrivate::createRenderer()
                 const QString cacheId = CACHE_ID_NATURAL_SIZE(elementId, status, devicePixelRatio);
                 localRectCache.insert(cacheId, elementRect);
                 cacheAndColorsTheme()->insertIntoRectsCache(path, cacheId, elementRect);
+
+                // interesting elements are in the form width-height-elementid
+                QSize sizeHint;
+                QString baseElementId;
+                if (indexSizeHints && SvgSizeHints::parse(elementId, sizeHint, baseElementId)) {
+                    themePrivate->svgElementsCache->insertSizeHint(path, baseElementId, sizeHint);
+                }
+            }
+
+            sizeHints = new SvgSizeHints(interestingElements.keys());
+            if (!sizeHints->isEmpty()) {
+                s_sizeHints[path] = sizeHints;
             }
         }
 
-        s_renderers[styleCrc + path] = renderer;
+        SvgRendererPool::self()->insert(rendererKey, renderer);
     }
 
     if (size == QSizeF()) {
+        QMutexLocker lock(&renderer->renderMutex);
         size = renderer->defaultSize();
     }
 }
 
 void SvgPrivate::eraseRenderer()
 {
-    if (renderer && renderer->ref.load() == 2) {
-        // this and the cache reference it
-        s_renderers.erase(s_renderers.find(styleCrc + path));
+    if (renderer && renderer->ref.load() == 2 && theme) {
+        // this and the pool reference it
+        theme.data()->releaseRectsCache(path);
+    }
 
-        if (theme) {
-            theme.data()->releaseRectsCache(path);
-        }
+    if (SvgRendererPool *pool = SvgRendererPool::self()) {
+        pool->release(renderer);
+    }
+
+    if (sizeHints && sizeHints->ref.load() == 2 && s_sizeHints.value(path) == sizeHints) {
+        s_sizeHints.remove(path);
     }
 
     renderer = 0;
-    styleCrc = 0;
+    styleHash = 0;
     localRectCache.clear();
-    elementsWithSizeHints.clear();
+    interactivePixmaps.clear();
+    sizeHints = 0;
 }
 
 QRectF SvgPrivate::elementRect(const QString &elementId)
@@ -542,6 +752,13 @@ QRectF SvgPrivate::elementRect(const QString &elementId)
         return rect;
     } else if (found) {
         localRectCache.insert(id, rect);
+    } else if (themed && (!size.isValid() || size == naturalSize) &&
+               cacheAndColorsTheme()->d->findInCompiledElements(path, elementId, scaleFactor, rect)) {
+        // measured when the theme was built, no need to parse the file
+        cacheAndColorsTheme()->insertIntoRectsCache(path, id, rect);
+        if (rect.isValid()) {
+            localRectCache.insert(id, rect);
+        }
     } else {
         rect = findAndCacheElementRect(elementId);
     }
@@ -559,13 +776,16 @@ QRectF SvgPrivate::findAndCacheElementRect(const QString &elementId)
         return localRectCache.value(id);
     }
 
+    QMutexLocker lock(&renderer->renderMutex);
     QRectF elementRect = renderer->elementExists(elementId) ?
                          renderer->matrixForElement(elementId).map(renderer->boundsOnElement(elementId)).boundingRect() :
                          QRectF();
-    naturalSize = renderer->defaultSize() * scaleFactor;
+    const QSize defaultSize = renderer->defaultSize();
+    lock.unlock();
+    naturalSize = defaultSize * scaleFactor;
 
-    qreal dx = size.width() / renderer->defaultSize().width();
-    qreal dy = size.height() / renderer->defaultSize().height();
+    qreal dx = size.width() / defaultSize.width();
+    qreal dy = size.height() / defaultSize.height();
 
     elementRect = QRectF(elementRect.x() * dx, elementRect.y() * dy,
                          elementRect.width() * dx, elementRect.height() * dy);
@@ -578,6 +798,7 @@ QRectF SvgPrivate::findAndCacheElementRect(const QString &elementId)
 QMatrix SvgPrivate::matrixForElement(const QString &elementId)
 {
     createRenderer();
+    QMutexLocker lock(&renderer->renderMutex);
     return renderer->matrixForElement(elementId);
 }
 
@@ -693,8 +914,9 @@ void SvgPrivate::colorsChanged()
     emit q->repaintNeeded();
 }
 
-QHash<QString, SharedSvgRenderer::Ptr> SvgPrivate::s_renderers;
+QHash<QString, SvgSizeHints::Ptr> SvgPrivate::s_sizeHints;
 QWeakPointer<Theme> SvgPrivate::s_systemColorsCache;
+int SvgPrivate::s_lastImageRequest = 0;
 
 Svg::Svg(QObject *parent)
     : QObject(parent),
@@ -748,6 +970,7 @@ void Svg::setScaleFactor(qreal ratio)
         d->naturalSize = rect.size();
     } else {
         d->createRenderer();
+        QMutexLocker lock(&d->renderer->renderMutex);
         d->naturalSize = d->renderer->defaultSize() * d->scaleFactor;
     }
 
@@ -769,7 +992,7 @@ void Svg::setColorGroup(Plasma::Theme::ColorGroup group)
     }
 
     d->colorGroup = group;
-    d->renderer = 0;
+    d->eraseRenderer();
     emit colorGroupChanged();
     emit repaintNeeded();
 }
@@ -790,8 +1013,17 @@ QPixmap Svg::pixmap(const QString &elementID)
 
 QImage Svg::image(const QSize &size, const QString &elementID)
 {
-    QPixmap pix(d->findInCache(elementID, d->devicePixelRatio, size));
-    return pix.toImage();
+    return d->findImageInCache(elementID, d->devicePixelRatio, size, true);
+}
+
+int Svg::requestImage(const QSize &size, const QString &elementID)
+{
+    return d->requestImage(size, elementID);
+}
+
+void Svg::cancelImageRequest(int request)
+{
+    d->cancelImageRequest(request);
 }
 
 void Svg::paint(QPainter *painter, const QPointF &point, const QString &elementID)
@@ -904,6 +1136,7 @@ bool Svg::isValid() const
     }
 
     d->createRenderer();
+    QMutexLocker lock(&d->renderer->renderMutex);
     return d->renderer->isValid();
 }
 
@@ -997,6 +1230,26 @@ Svg::Status Svg::status() const
     return d->status;
 }
 
+void Svg::setInteractiveResizing(bool interactive)
+{
+    if (interactive == d->interactiveResizing) {
+        return;
+    }
+
+    d->interactiveResizing = interactive;
+    if (!interactive && d->resizing) {
+        d->settleTimer->stop();
+        d->resizingSettled();
+    }
+
+    emit interactiveResizingChanged(interactive);
+}
+
+bool Svg::isInteractiveResizing() const
+{
+    return d->interactiveResizing;
+}
+
 } // Plasma namespace
 
 #include "private/moc_svg_p.cpp"
@@ -64,6 +64,7 @@ class PLASMA_EXPORT Svg : public QObject
     Q_PROPERTY(bool fromCurrentTheme READ fromCurrentTheme NOTIFY fromCurrentThemeChanged)
     Q_PROPERTY(Plasma::Theme::ColorGroup colorGroup READ colorGroup WRITE setColorGroup NOTIFY colorGroupChanged)
     Q_PROPERTY(Plasma::Svg::Status status READ status WRITE setStatus NOTIFY statusChanged)
+    Q_PROPERTY(bool interactiveResizing READ isInteractiveResizing WRITE setInteractiveResizing NOTIFY interactiveResizingChanged)
 
 public:
     enum Status {
@@ -155,12 +156,42 @@ public:
      * size of the requested element after the whole SVG has been scaled
      * to size().
      *
+     * While the Svg is interactively resized, the image may be a bit bigger
+     * than asked, see setInteractiveResizing().
+     *
      * @param elementId  the ID string of the element to render, or an empty
      *                 string for the whole SVG (the default)
      * @return a QPixmap of the rendered SVG
      */
     Q_INVOKABLE QImage image(const QSize &size, const QString &elementID = QString());
 
+    /**
+     * Requests an image of the SVG represented by this object, rendered
+     * in a worker thread instead of blocking the caller like image() does.
+     *
+     * The result is delivered by imageReady() and is the same image that
+     * image() would return for the same arguments. If the image is already
+     * in the cache, imageReady() is emitted before this method returns.
+     *
+     * @param size       the size of the image, as for image()
+     * @param elementId  the ID string of the element to render, or an empty
+     *                 string for the whole SVG (the default)
+     * @return an id identifying the request in imageReady()
+     * @see cancelImageRequest
+     * @since 5.24
+     */
+    Q_INVOKABLE int requestImage(const QSize &size, const QString &elementID = QString());
+
+    /**
+     * Cancels a request made with requestImage(): imageReady() won't be
+     * emitted for it. Typically used when the size changed again before
+     * the image was ready.
+     *
+     * @param request the id returned by requestImage()
+     * @since 5.24
+     */
+    Q_INVOKABLE void cancelImageRequest(int request);
+
     /**
      * Paints all or part of the SVG represented by this object
      *
@@ -455,6 +486,35 @@ public:
      */
     Svg::Status status() const;
 
+    /**
+     * Sets whether the Svg expects to be resized continuously, e.g. by an
+     * animation or while the user drags it.
+     *
+     * When enabled, as soon as image() or requestImage() get asked for an
+     * element at a size different from the previous one, the Svg is
+     * considered being resized: images are then rendered to the closest
+     * bigger size bucket (at most 12.5% bigger than asked) and are meant to
+     * be scaled by the caller, as SvgItem does. Those images are kept out of
+     * the rendering cache. A moment after the last resize, repaintNeeded()
+     * is emitted so the exact size gets rendered again.
+     *
+     * pixmap() and paint() always render the exact size, but a FrameSvg
+     * being resized keeps its intermediate frames out of the rendering cache.
+     *
+     * Default is false.
+     *
+     * @param interactive true if the Svg is going to be resized continuously
+     * @since 5.24
+     */
+    void setInteractiveResizing(bool interactive);
+
+    /**
+     * @return true if the Svg expects to be resized continuously
+     * @see setInteractiveResizing
+     * @since 5.24
+     */
+    bool isInteractiveResizing() const;
+
 Q_SIGNALS:
     /**
      * Emitted whenever the SVG data has changed in such a way that a repaint is required.
@@ -500,12 +560,30 @@ Q_SIGNALS:
      */
     void statusChanged(Plasma::Svg::Status status);
 
+    /**
+     * Emitted when an image requested with requestImage() is ready.
+     * The image is null if there was nothing to render.
+     *
+     * @param request the id returned by requestImage()
+     * @param image the rendered image
+     * @since 5.24
+     */
+    void imageReady(int request, const QImage &image);
+
+    /**
+     * Emitted when the interactive resizing mode changes
+     * @since 5.24
+     */
+    void interactiveResizingChanged(bool interactive);
+
 private:
     SvgPrivate *const d;
     bool eventFilter(QObject *watched, QEvent *event) Q_DECL_OVERRIDE;
 
     Q_PRIVATE_SLOT(d, void themeChanged())
     Q_PRIVATE_SLOT(d, void colorsChanged())
+    Q_PRIVATE_SLOT(d, void imageRendered(int, const QImage &))
+    Q_PRIVATE_SLOT(d, void resizingSettled())
 
     friend class SvgPrivate;
     friend class FrameSvgPrivate;
@@ -42,7 +42,11 @@
 #include <kwindowsystem.h>
 #include <qstandardpaths.h>
 
+#include "private/cachestatistics_p.h"
+#include "private/framebackgroundcache_p.h"
+#include "private/framesvg_p.h"
 #include "private/packages_p.h"
+#include "private/svgrendererpool_p.h"
 #include "debug_p.h"
 
 namespace Plasma
@@ -201,54 +205,10 @@ QString Theme::styleSheet(const QString &css) const
 
 QString Theme::wallpaperPath(const QSize &size) const
 {
-    QString fullPath;
-    QString image = d->defaultWallpaperTheme;
-
-    image.append("/contents/images/%1x%2").append(d->defaultWallpaperSuffix);
-    QString defaultImage = image.arg(d->defaultWallpaperWidth).arg(d->defaultWallpaperHeight);
-
-    if (size.isValid()) {
-        // try to customize the paper to the size requested
-        //TODO: this should do better than just fallback to the default size.
-        //      a "best fit" matching would be far better, so we don't end
-        //      up returning a 1920x1200 wallpaper for a 640x480 request ;)
-        image = image.arg(size.width()).arg(size.height());
-    } else {
-        image = defaultImage;
-    }
-
-    //TODO: the theme's wallpaper overrides regularly installed wallpapers.
-    //      should it be possible for user installed (e.g. locateLocal) wallpapers
-    //      to override the theme?
-    if (d->hasWallpapers) {
-        // check in the theme first
-        fullPath = d->findInTheme(QLatin1Literal("wallpapers/") % image, d->themeName);
-
-        if (fullPath.isEmpty()) {
-            fullPath = d->findInTheme(QLatin1Literal("wallpapers/") % defaultImage, d->themeName);
-        }
-    }
-
-    if (fullPath.isEmpty()) {
-        // we failed to find it in the theme, so look in the standard directories
-        //qCDebug(LOG_PLASMA) << "looking for" << image;
-        fullPath = QStandardPaths::locate(QStandardPaths::GenericDataLocation, QLatin1String("wallpapers/") + image);
-    }
-
-    if (fullPath.isEmpty()) {
-        // we still failed to find it in the theme, so look for the default in
-        // the standard directories
-        //qCDebug(LOG_PLASMA) << "looking for" << defaultImage;
-        fullPath = QStandardPaths::locate(QStandardPaths::GenericDataLocation, QLatin1String("wallpapers/") + defaultImage);
-
-        if (fullPath.isEmpty()) {
-#ifndef NDEBUG
-            // qCDebug(LOG_PLASMA) << "exhausted every effort to find a wallpaper.";
-#endif
-        }
-    }
-
-    return fullPath;
+    // the smallest image covering the size, so decoding scales with the screen
+    // rather than with the largest image of the wallpaper
+    const QSize defaultSize(d->defaultWallpaperWidth, d->defaultWallpaperHeight);
+    return d->wallpapers().bestFit(size.isValid() ? size : defaultSize);
 }
 
 QString Theme::wallpaperPathForSize(int width, int height) const
@@ -301,17 +261,19 @@ bool Theme::findInCache(const QString &key, QPixmap &pix, unsigned int lastModif
     }
 
     if (d->useCache()) {
-        const QString id = d->keysToCache.value(key);
-        if (d->pixmapsToCache.contains(id)) {
-            pix = d->pixmapsToCache.value(id);
-            return !pix.isNull();
+        // Pixmaps waiting to be written are indexed by structured keys, this string
+        // based lookup is only used by external callers
+        if (d->pixmapWriter->find(key, &pix)) {
+            CacheStatistics::self()->count(CacheStatistics::PendingPixmapHit);
+            return true;
         }
 
-        QPixmap temp;
-        if (d->pixmapCache->findPixmap(key, &temp) && !temp.isNull()) {
-            pix = temp;
+        if (d->pixmapCache->findPixmap(key, &pix) && !pix.isNull()) {
+            CacheStatistics::self()->count(CacheStatistics::PixmapCacheHit);
             return true;
         }
+
+        CacheStatistics::self()->count(CacheStatistics::PixmapCacheMiss);
     }
 
     return false;
@@ -320,25 +282,19 @@ bool Theme::findInCache(const QString &key, QPixmap &pix, unsigned int lastModif
 void Theme::insertIntoCache(const QString &key, const QPixmap &pix)
 {
     if (d->useCache()) {
-        d->pixmapCache->insertPixmap(key, pix);
+        // nothing tells what the pixmap is made of: gone as well when the colors change
+        d->pixmapCache->insertPixmap(key, pix, PixmapStore::ColorDependent);
+        //written to disk with the pixmaps of the Svgs
+        QMetaObject::invokeMethod(d->pixmapSaveTimer, "start", Qt::QueuedConnection);
     }
 }
 
 void Theme::insertIntoCache(const QString &key, const QPixmap &pix, const QString &id)
 {
-    if (d->useCache()) {
-        d->pixmapsToCache.insert(id, pix);
-
-        if (d->idsToCache.contains(id)) {
-            d->keysToCache.remove(d->idsToCache[id]);
-        }
-
-        d->keysToCache.insert(key, id);
-        d->idsToCache.insert(id, key);
-
-        //always start timer in d->pixmapSaveTimer's thread
-        QMetaObject::invokeMethod(d->pixmapSaveTimer, "start", Qt::QueuedConnection);
-    }
+    // queued like the pixmaps of the Svgs: only the last one inserted with the same id gets written
+    d->insertIntoCache(PixmapCacheKey::custom(key), pix,
+                       PixmapCacheOwner(this, id),
+                       PixmapStore::ColorDependent);
 }
 
 bool Theme::findInRectsCache(const QString &image, const QString &element, QRectF &rect) const
@@ -347,30 +303,21 @@ bool Theme::findInRectsCache(const QString &image, const QString &element, QRect
         return false;
     }
 
-    KConfigGroup imageGroup(d->svgElementsCache, image);
-    rect = imageGroup.readEntry(element % QLatin1Literal("Size"), QRectF());
-
-    if (rect.isValid()) {
+    if (d->svgElementsCache->findRect(image, element, rect)) {
+        CacheStatistics::self()->count(CacheStatistics::RectsCacheHit);
         return true;
     }
 
     //Name starting by _ means the element is empty and we're asked for the size of
     //the whole image, so the whole image is never invalid
     if (element.indexOf('_') <= 0) {
+        CacheStatistics::self()->count(CacheStatistics::RectsCacheMiss);
         return false;
     }
 
-    bool invalid = false;
-
-    QHash<QString, QSet<QString> >::iterator it = d->invalidElements.find(image);
-    if (it == d->invalidElements.end()) {
-        QSet<QString> elements = imageGroup.readEntry("invalidElements", QStringList()).toSet();
-        d->invalidElements.insert(image, elements);
-        invalid = elements.contains(element);
-    } else {
-        invalid = it.value().contains(element);
-    }
-
+    rect = QRectF();
+    const bool invalid = d->svgElementsCache->isInvalid(image, element);
+    CacheStatistics::self()->count(invalid ? CacheStatistics::RectsCacheHit : CacheStatistics::RectsCacheMiss);
     return invalid;
 }
 
@@ -380,21 +327,7 @@ QStringList Theme::listCachedRectKeys(const QString &image) const
         return QStringList();
     }
 
-    KConfigGroup imageGroup(d->svgElementsCache, image);
-    QStringList keys = imageGroup.keyList();
-
-    QMutableListIterator<QString> i(keys);
-    while (i.hasNext()) {
-        QString key = i.next();
-        if (key.endsWith(QLatin1String("Size"))) {
-            // The actual cache id used from outside doesn't end on "Size".
-            key.resize(key.size() - 4);
-            i.setValue(key);
-        } else {
-            i.remove();
-        }
-    }
-    return keys;
+    return d->svgElementsCache->keys(image);
 }
 
 void Theme::insertIntoRectsCache(const QString &image, const QString &element, const QRectF &rect)
@@ -404,19 +337,9 @@ void Theme::insertIntoRectsCache(const QString &image, const QString &element, c
     }
 
     if (rect.isValid()) {
-        KConfigGroup imageGroup(d->svgElementsCache, image);
-        imageGroup.writeEntry(element % QLatin1Literal("Size"), rect);
+        d->svgElementsCache->insertRect(image, element, rect);
     } else {
-        QHash<QString, QSet<QString> >::iterator it = d->invalidElements.find(image);
-        if (it == d->invalidElements.end()) {
-            d->invalidElements[image].insert(element);
-        } else if (!it.value().contains(element)) {
-            if (it.value().count() > 1000) {
-                it.value().erase(it.value().begin());
-            }
-
-            it.value().insert(element);
-        }
+        d->svgElementsCache->insertInvalid(image, element);
     }
 
     QMetaObject::invokeMethod(d->rectSaveTimer, "start");
@@ -425,31 +348,40 @@ void Theme::insertIntoRectsCache(const QString &image, const QString &element, c
 void Theme::invalidateRectsCache(const QString &image)
 {
     if (d->useCache()) {
-        KConfigGroup imageGroup(d->svgElementsCache, image);
-        imageGroup.deleteGroup();
+        d->svgElementsCache->remove(image);
+        QMetaObject::invokeMethod(d->rectSaveTimer, "start");
     }
-
-    d->invalidElements.remove(image);
 }
 
 void Theme::releaseRectsCache(const QString &image)
 {
-    QHash<QString, QSet<QString> >::iterator it = d->invalidElements.find(image);
-    if (it != d->invalidElements.end()) {
-        if (d->useCache()) {
-            KConfigGroup imageGroup(d->svgElementsCache, it.key());
-            imageGroup.writeEntry("invalidElements", it.value().toList());
-        }
+    // The index is memory mapped, there is nothing loaded per image to release:
+    // entries still pending are written at the next save
+    Q_UNUSED(image)
+}
 
-        d->invalidElements.erase(it);
-    }
+QVariantMap Theme::cacheStatistics() const
+{
+    return d->cacheStatistics();
+}
+
+void Theme::resetCacheStatistics()
+{
+    CacheStatistics::self()->reset();
+}
+
+void Theme::trimCaches()
+{
+    FrameBackgroundCache::self()->trim();
+    SvgRendererPool::self()->clearUnused();
+    FrameSvgPrivate::s_ninePatches.remove(d);
+    d->frameMasks.clear();
 }
 
 void Theme::setCacheLimit(int kbytes)
 {
     d->cacheSize = kbytes;
-    delete d->pixmapCache;
-    d->pixmapCache = 0;
+    d->closePixmapCache();
 }
 
 KPluginInfo Theme::pluginInfo() const
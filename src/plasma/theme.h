@@ -24,6 +24,7 @@
 #include <QGuiApplication>
 #include <QFont>
 #include <QtCore/QObject>
+#include <QtCore/QVariant>
 
 #include <kplugininfo.h>
 #include <ksharedconfig.h>
@@ -129,6 +130,9 @@ public:
      *
      * @param size the target height and width of the wallpaper; if an invalid size
      *           is passed in, then a default size will be provided instead.
+     *           Since 5.24 the smallest image covering the size is picked,
+     *           of the same aspect ratio if the wallpaper has one, or the
+     *           largest one if none covers it.
      * @return the full path to the wallpaper image
      */
     QString wallpaperPath(const QSize &size = QSize()) const;
@@ -313,6 +317,53 @@ public:
      */
     void releaseRectsCache(const QString &image);
 
+    /**
+     * Statistics of the caches used to render the theme, to tune their sizes
+     * (e.g. themeCacheKb in plasmarc) from real use. The counters and render
+     * times are shared by all the themes of the process:
+     * - "pixmapCacheHits", "pixmapCacheMisses", "pendingPixmapHits" (found among
+     *   the pixmaps not written to the disk cache yet)
+     * - "rectsCacheHits", "rectsCacheMisses"
+     * - "renderersReused", "renderersCreated": parsed svg files shared or not
+     * - "framesShared", "framesNotShared": FrameSvg frames shared or not
+     * - "framesEvicted": rendered frames dropped to stay within "frameBudget"
+     * - "renderTimes": for each image path, the list of how many renders took
+     *   under 1, 2, 4 ... 128 milliseconds and longer
+     *
+     * The memory held by the caches, in bytes: "pixmapCacheBytes" (and its
+     * "pixmapCacheBudget"), "pendingPixmapBytes", "rectsCacheBytes",
+     * "rendererBytes" for "renderers" parsed files, of which
+     * "unusedRendererBytes" for the "unusedRenderers" kept in case they are
+     * needed again (see svgRendererCacheKb in plasmarc), "frameBytes" for
+     * "frames" shared frames, "ninePatchBytes" for the "ninePatches"
+     * they are composed from and "renderedFrameBytes" for all the rendered
+     * frames of the process (see frameCacheKb in plasmarc).
+     *
+     * Setting the PLASMA_CACHE_STATISTICS environment variable logs them
+     * when the application quits.
+     *
+     * @see resetCacheStatistics
+     * @since 5.24
+     */
+    QVariantMap cacheStatistics() const;
+
+    /**
+     * Sets the counters and render times of cacheStatistics() back to zero
+     * @since 5.24
+     */
+    void resetCacheStatistics();
+
+    /**
+     * Releases the memory the caches can do without, e.g. when the system
+     * is short of memory: the rendered backgrounds of all the frames of the
+     * process, including the ones on screen, the parsed svgs that aren't
+     * being used, and the parts and masks of the frames of this theme.
+     * Everything is rendered again, usually from the disk cache, when needed:
+     * the frames on screen right away, on their next paint.
+     * @since 5.24
+     */
+    void trimCaches();
+
     /**
      * @return plugin info for this theme, with informations such as
      * name, description, author, website etc
@@ -0,0 +1,191 @@
+/*
+ *   Copyright 2016 The KDE Community
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/**
+ * plasma-themecompiler <theme directory> <output file>
+ *
+ * Measures the elements of every svg of a desktop theme at build time and
+ * writes them in the format of the svg elements index, to be installed in
+ * the theme as elements.index: the rects of the elements at their natural
+ * size, the size hints and the frame and color hint elements known to be
+ * missing. Plasma::Theme looks there before parsing a file of the theme.
+ *
+ * Exit codes: 0 on success, 1 on wrong arguments, 2 if the index could not
+ * be written.
+ */
+
+#include <QCommandLineParser>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QGuiApplication>
+#include <QSet>
+#include <QSvgRenderer>
+#include <QTextStream>
+#include <QXmlStreamReader>
+
+#include <kconfig.h>
+#include <kconfiggroup.h>
+
+#include "plasma/private/svgdocument_p.h"
+#include "plasma/private/svgelementsindex_p.h"
+#include "plasma/private/svgsizehints_p.h"
+
+using namespace Plasma;
+
+// What FrameSvg looks for after a prefix, a missing one is as good to know as a present one
+static const char *const s_frameElements[] = {
+    "center", "top", "bottom", "left", "right",
+    "topleft", "topright", "bottomleft", "bottomright",
+    "hint-top-margin", "hint-bottom-margin", "hint-left-margin", "hint-right-margin",
+    "hint-stretch-borders", "hint-tile-center", "hint-no-border-padding", "hint-compose-over-border",
+    "overlay", "hint-overlay-tile-horizontal", "hint-overlay-tile-vertical", "hint-overlay-stretch",
+    "hint-overlay-pos-right", "hint-overlay-pos-bottom"
+};
+
+// What every Svg looks for when it loads its file
+static const char *const s_colorHints[] = {
+    "hint-apply-color-scheme", "current-color-scheme"
+};
+
+// Plasma::Svg keys the rects of the elements at their natural size by status and
+// device pixel ratio, the rects are the same for all of them: only the ones of
+// the normal status at a ratio of 1 are stored
+static QString naturalSizeKey(const QString &elementId)
+{
+    return QLatin1String("Natural_") + elementId + QLatin1String("_0_1");
+}
+
+static QStringList elementIds(const QByteArray &contents)
+{
+    QStringList ids;
+    QXmlStreamReader reader(contents);
+    while (!reader.atEnd()) {
+        if (reader.readNext() == QXmlStreamReader::StartElement) {
+            const QStringRef id = reader.attributes().value(QLatin1String("id"));
+            if (!id.isEmpty()) {
+                ids << id.toString();
+            }
+        }
+    }
+
+    return ids;
+}
+
+static void compileSvg(const QString &path, const QString &image, SvgElementsIndex &index)
+{
+    const SvgDocument::Ptr document = SvgDocument::load(path);
+    const QByteArray contents = document->contents(QString());
+    QSvgRenderer renderer(contents);
+    if (!renderer.isValid()) {
+        QTextStream(stderr) << "Invalid svg: " << path << endl;
+        return;
+    }
+
+    const QSize naturalSize = renderer.defaultSize();
+    index.insertRect(image, QStringLiteral("_Natural_1"), QRectF(QPointF(0, 0), naturalSize));
+
+    QSet<QString> present;
+    QStringList framePrefixes;
+    foreach (const QString &id, elementIds(contents)) {
+        if (present.contains(id) || !renderer.elementExists(id)) {
+            continue;
+        }
+        present.insert(id);
+
+        const QRectF rect = renderer.matrixForElement(id).map(renderer.boundsOnElement(id)).boundingRect();
+        index.insertRect(image, naturalSizeKey(id), rect);
+
+        if (id.endsWith(QLatin1String("center"))) {
+            framePrefixes << id.left(id.length() - 6);
+        }
+    }
+
+    foreach (const QString &id, document->sizeHintedIds()) {
+        QSize hint;
+        QString elementId;
+        if (SvgSizeHints::parse(id, hint, elementId)) {
+            index.insertSizeHint(image, elementId, hint);
+        }
+    }
+
+    for (const char *hint : s_colorHints) {
+        const QString id = QLatin1String(hint);
+        if (!present.contains(id)) {
+            index.insertInvalid(image, naturalSizeKey(id));
+        }
+    }
+
+    foreach (const QString &prefix, framePrefixes) {
+        for (const char *element : s_frameElements) {
+            const QString id = prefix + QLatin1String(element);
+            if (!present.contains(id)) {
+                index.insertInvalid(image, naturalSizeKey(id));
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    // only measuring, no need for a display at build time
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QGuiApplication app(argc, argv);
+    app.setApplicationName(QStringLiteral("plasma-themecompiler"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Compiles the svg files of a Plasma desktop theme into an index of their elements"));
+    parser.addHelpOption();
+    parser.addPositionalArgument(QStringLiteral("theme"), QStringLiteral("The directory of the theme, with its metadata.desktop"));
+    parser.addPositionalArgument(QStringLiteral("output"), QStringLiteral("The index to write"));
+    parser.process(app);
+
+    const QStringList arguments = parser.positionalArguments();
+    if (arguments.count() != 2) {
+        parser.showHelp(1);
+    }
+
+    const QString themeDir = QDir(arguments.at(0)).absolutePath() + QLatin1Char('/');
+    const QString output = arguments.at(1);
+
+    // the index is only used for the version of the theme it has been compiled from
+    KConfig metadata(themeDir + QLatin1String("metadata.desktop"), KConfig::SimpleConfig);
+    const QString version = KConfigGroup(&metadata, "Desktop Entry").readEntry("X-KDE-PluginInfo-Version", QString());
+
+    QFile::remove(output);
+    SvgElementsIndex index(output);
+    index.setTag(version);
+
+    QDirIterator it(themeDir, QStringList() << QStringLiteral("*.svg") << QStringLiteral("*.svgz"),
+                    QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString path = it.next();
+        compileSvg(path, path.mid(themeDir.length()), index);
+    }
+
+    if (!index.save()) {
+        QTextStream(stderr) << "Could not write " << output << endl;
+        return 2;
+    }
+
+    return 0;
+}